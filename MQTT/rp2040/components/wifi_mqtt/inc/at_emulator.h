@@ -0,0 +1,44 @@
+#ifndef AT_EMULATOR_H
+#define AT_EMULATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/time.h"
+#include "uart_comm.h"
+
+// 명령 줄 / 지연 응답 최대 길이
+#define AT_EMU_LINE_MAX 256
+#define AT_EMU_REPLY_MAX 32
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ESP-AT 모듈 에뮬레이터 (벤치마크용, 두 번째 UART를 ESP-01 UART와 교차 연결)
+// AT+MQTTPUBRAW → "OK\r\n\r\n>" → 페이로드 수신 → "+MQTTPUB:OK", 그 외 명령 → "OK"
+// 에코 없음 (ATE0 상태), 응답은 ack_delay_us 뒤에 송신 (모듈 처리 시간 모사)
+typedef struct {
+    UartLink* link;                  // 모듈 쪽 링크 (uart_read_raw로만 읽음)
+    char line[AT_EMU_LINE_MAX];      // 수신 중인 명령 줄
+    uint32_t line_len;
+    uint32_t payload_remaining;      // '>' 이후 받아야 할 페이로드 바이트 수
+    uint32_t ack_delay_us;
+    char reply[AT_EMU_REPLY_MAX];    // 송신 대기 응답
+    uint32_t reply_len;
+    absolute_time_t reply_at;        // 응답 송신 시각
+    uint32_t commands;               // 처리한 명령 수
+    uint32_t publishes;              // 처리한 MQTTPUBRAW 수
+    uint32_t overflows;              // 줄 길이 초과로 버린 명령 수
+} AtEmulator;
+
+// 에뮬레이터 초기화 (link는 uart_init_esp01로 초기화된 링크)
+void at_emu_init(AtEmulator& emu, UartLink& link, uint32_t ack_delay_us);
+
+// 에뮬레이터 진행: 수신 바이트 처리, 송신 시각이 된 응답 전송 (차단 없음)
+void at_emu_poll(AtEmulator& emu);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AT_EMULATOR_H
@@ -0,0 +1,110 @@
+#ifndef AT_ENGINE_H
+#define AT_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pico/time.h"
+#include "uart_comm.h"
+
+// 명령 큐 크기
+#define AT_QUEUE_LEN 8
+// 비차단 제출 시 슬롯에 복사하는 명령·페이로드 최대 길이 (슬롯마다 차지, 프로젝트에서 재정의 가능)
+// 차단 래퍼(at_execute)는 호출 측 버퍼를 그대로 쓰므로 이 제한을 받지 않음
+#ifndef AT_CMD_MAX_LEN
+#define AT_CMD_MAX_LEN 256
+#endif
+#ifndef AT_PAYLOAD_MAX
+#define AT_PAYLOAD_MAX 256
+#endif
+
+// 완료 결과 (0 이상 = 일치한 토큰 인덱스, 관례상 tokens[0]이 성공)
+#define AT_RESULT_TIMEOUT     -1   // 응답 시간 초과
+#define AT_RESULT_PROMPT_FAIL -2   // '>' 프롬프트 대신 ERROR
+#define AT_RESULT_ABORTED     -3   // 앞선 연쇄 명령 실패 또는 큐 비움으로 취소
+#define AT_RESULT_PENDING     -4   // 아직 완료되지 않음 (호출 측 초기값용)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 완료 콜백 (at_engine_poll 안, 메인 루프 컨텍스트에서 호출)
+// 콜백 안에서 at_execute 등 차단 함수를 호출하면 안 됨 (at_submit은 가능)
+typedef void (*AtCallback)(int result, void* user);
+
+// 명령 요청
+typedef struct {
+    const char* cmd;                // AT 명령 ("\r\n" 제외)
+    const char* const* tokens;      // 완료 토큰 (먼저 일치한 인덱스가 결과)
+    int token_count;
+    uint32_t timeout_ms;            // 단계별 응답 제한 시간 (프롬프트/결과 각각)
+    const void* payload;            // '>' 프롬프트 후 보낼 데이터 (NULL = 프롬프트 단계 없음)
+    uint32_t payload_len;
+    uint32_t delay_ms;              // 직전 명령 완료 후 전송까지 최소 간격 (sleep_ms 대체)
+    bool chain;                     // true = 실패 시 뒤따르는 연쇄 명령 취소 (마지막 명령은 false)
+    bool borrow;                    // true = cmd/payload를 복사하지 않고 완료까지 호출 측 버퍼 사용 (길이 제한 없음)
+    AtCallback done;
+    void* user;
+} AtRequest;
+
+// 큐 슬롯 (요청 + 명령/페이로드 복사본, borrow면 복사본은 비어 있음)
+typedef struct {
+    AtRequest req;
+    char cmd[AT_CMD_MAX_LEN];
+    uint8_t payload[AT_PAYLOAD_MAX];
+} AtSlot;
+
+typedef enum {
+    AT_STATE_IDLE,          // 대기 중인 명령 없음 또는 다음 명령 꺼내기 전
+    AT_STATE_DELAY,         // delay_ms 경과 대기
+    AT_STATE_WAIT_PROMPT,   // '>' 대기
+    AT_STATE_SEND_PAYLOAD,  // '>' 수신 후 페이로드를 TX 큐 여유만큼 나눠 넣는 중
+    AT_STATE_WAIT_RESULT    // 완료 토큰 대기
+} AtState;
+
+// AT 엔진: UART 링크 하나당 하나, 명령을 순서대로 하나씩 진행
+typedef struct AtEngine {
+    UartLink* link;
+    AtSlot queue[AT_QUEUE_LEN];
+    uint32_t head;                  // 제출 위치
+    uint32_t tail;                  // 진행 중인 명령 위치
+    AtState state;
+    UartMatcher matcher;
+    absolute_time_t deadline;       // 현재 단계 제한 시각 (DELAY 단계에서는 전송 시각)
+    absolute_time_t last_done;      // 직전 명령 완료 시각
+    uint32_t payload_sent;          // 현재 명령의 페이로드 중 TX 큐에 넣은 바이트
+    bool aborting;                  // 연쇄 실패 후 남은 연쇄 명령 취소 중
+    bool in_poll;                   // 콜백 재진입 감지
+} AtEngine;
+
+// 엔진 초기화 (링크에 연결, link.at 설정)
+void at_engine_init(AtEngine& engine, UartLink& link);
+
+// 명령 제출 (비차단), 큐가 가득 차거나 길이 초과(borrow가 아닐 때) 시 false
+bool at_submit(AtEngine& engine, const AtRequest& req);
+
+// 엔진 진행: URC 분배, 응답 검사, 타임아웃 처리, 다음 명령 전송 (차단 없음)
+// 링크가 투명 전송 중이면(uart_set_passthrough) 다음 명령은 종료될 때까지 보내지 않음
+void at_engine_poll(AtEngine& engine);
+
+// 진행 중이거나 대기 중인 명령이 있는지
+bool at_engine_busy(AtEngine& engine);
+
+// 큐에 남은 명령 수 (진행 중인 명령 포함, 최대 AT_QUEUE_LEN)
+uint32_t at_engine_pending(AtEngine& engine);
+
+// 대기 중인 명령 모두 취소 (진행 중인 명령 포함, 콜백에 AT_RESULT_ABORTED)
+void at_engine_flush(AtEngine& engine);
+
+// 차단 래퍼: 제출 후 완료까지 엔진을 돌리고 결과 반환 (req.done/user는 무시)
+// 완료까지 호출 측 cmd/payload를 그대로 사용 (복사하지 않으므로 슬롯 크기 제한 없음)
+// 큐가 가득 차 있으면 자리가 날 때까지 엔진을 돌리며 대기 (req.timeout_ms 안에 안 나면 AT_RESULT_TIMEOUT)
+int at_execute(AtEngine& engine, const AtRequest& req);
+
+// 차단 래퍼 (프롬프트/지연 없는 단일 명령)
+int at_command(AtEngine& engine, const char* cmd, const char* const* tokens, int count, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AT_ENGINE_H
@@ -0,0 +1,88 @@
+#ifndef BOOT_SEQ_H
+#define BOOT_SEQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 등록 가능한 최대 단계 수 (의존성을 32비트 마스크로 표현)
+#define BOOT_SEQ_MAX_STAGES 16
+
+// 단계 번호 → 의존성 마스크 (예: BOOT_DEP(a) | BOOT_DEP(b))
+#define BOOT_DEP(index) (1u << (index))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 단계 상태
+typedef enum {
+    BOOT_STAGE_WAITING,     // 의존 단계 완료 대기
+    BOOT_STAGE_RUNNING,     // 시작함, poll로 완료 확인 중
+    BOOT_STAGE_DONE,
+    BOOT_STAGE_FAILED,
+    BOOT_STAGE_SKIPPED      // 의존 단계가 실패해 시작하지 않음
+} BootStageState;
+
+// 단계 진행 결과
+typedef enum {
+    BOOT_STEP_PENDING,      // 아직 진행 중 (다음 poll에서 다시 확인)
+    BOOT_STEP_DONE,
+    BOOT_STEP_FAILED
+} BootStepResult;
+
+// 단계 시작 (의존 단계가 모두 끝난 직후 한 번, 차단 없이 제출만)
+// 반환: PENDING = poll로 완료 확인, DONE/FAILED = 시작에서 바로 끝남
+typedef BootStepResult (*BootStartFn)(void* user, uint32_t now);
+// 진행 확인 (RUNNING 동안 매 poll, NULL이면 시작 결과로 완료)
+typedef BootStepResult (*BootPollFn)(void* user, uint32_t now);
+
+typedef struct {
+    const char* name;
+    BootStartFn start;
+    BootPollFn poll;
+    void* user;
+    uint32_t deps;          // 먼저 끝나야 하는 단계 마스크 (BOOT_DEP)
+    BootStageState state;
+    uint32_t start_ms;      // 부팅 후 시각 (ms)
+    uint32_t end_ms;
+} BootStage;
+
+// 부팅 단계 조정기: 의존성이 끝난 단계를 모두 동시에 진행 (대기 위주 단계가 서로 겹침)
+typedef struct {
+    BootStage stages[BOOT_SEQ_MAX_STAGES];
+    uint8_t count;
+    uint8_t finished;       // DONE/FAILED/SKIPPED 단계 수
+    bool started;
+    uint32_t start_ms;      // 첫 poll 시각
+    uint32_t end_ms;        // 모든 단계가 끝난 시각
+} BootSeq;
+
+// 초기화
+void boot_seq_init(BootSeq& seq);
+
+// 단계 등록 (의존 단계는 먼저 등록되어 있어야 함), 반환: 단계 번호 (실패 시 -1)
+int boot_seq_add(BootSeq& seq, const char* name, BootStartFn start, BootPollFn poll, void* user, uint32_t deps);
+
+// 한 번 진행 (메인 루프/부팅 루프에서 매번 호출, 차단 없음), 반환: 모든 단계 종료 여부
+bool boot_seq_poll(BootSeq& seq, uint32_t now);
+
+// 모든 단계 종료 여부
+bool boot_seq_finished(const BootSeq& seq);
+
+// 단계 상태 (범위 밖이면 BOOT_STAGE_SKIPPED)
+BootStageState boot_seq_state(const BootSeq& seq, int index);
+
+// 단계별 시작/완료 시각과 소요 시간 출력
+void boot_seq_report(const BootSeq& seq);
+
+// 단계별 시간 JSON 생성 (발행용), 반환: 길이 (실패 시 -1)
+int boot_seq_format_stats(const BootSeq& seq, char* buffer, int max_len);
+
+// 상태 이름 (로그용)
+const char* boot_seq_state_name(BootStageState state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_SEQ_H
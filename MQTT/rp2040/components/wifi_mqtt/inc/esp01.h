@@ -4,37 +4,117 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "hardware/uart.h"
+#include "uart_comm.h"
+#include "at_engine.h"
+
+// 하드웨어 리셋 펄스 폭 (ms, ESP8266 EXT_RSTB 최소 폭은 수십 us)
+#define ESP01_RESET_PULSE_MS 20
+// 리셋 해제 후 부팅 완료 최대 대기 (ms, "ready" 배너나 AT 응답이 오면 바로 진행)
+#define ESP01_BOOT_WAIT_MS 3000
+// 부팅 대기 중 AT 확인 간격 (배너를 놓치거나 펌웨어가 배너를 내지 않는 경우 대비, ms)
+#define ESP01_READY_PROBE_MS 200
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// 마지막으로 성공한 WiFi 접속 정보 (빠른 재접속용, RAM에만 보관)
+typedef struct {
+    bool valid;                 // BSSID와 IP를 모두 확인함
+    bool autoconn_off;          // 이번 부팅에서 AT+CWAUTOCONN=0 성공 (OK 응답 확인)
+    bool sysstore_off;          // 모듈 부팅 후 AT+SYSSTORE=0 성공 (모듈이 리셋/재부팅하면 1로 돌아가므로 다시 보냄)
+    char bssid[18];             // "aa:bb:cc:dd:ee:ff"
+    uint8_t channel;            // 확인용 (AT+CWJAP에는 채널 인자가 없음)
+    char ip[16];
+    char gateway[16];
+    char netmask[16];
+} Esp01JoinCache;
+
+// 접속 경로별 통계 (소요 시간 = 명령 제출 → CWJAP 완료)
+typedef struct {
+    uint32_t fast_ok;           // 빠른 재접속 성공
+    uint32_t fast_failed;       // 빠른 재접속 실패 → 전체 접속으로 전환
+    uint32_t full_ok;           // 전체 접속(스캔 + DHCP) 성공
+    uint32_t last_fast_ms;
+    uint32_t last_full_ms;
+} Esp01JoinStats;
+
 // ESP-01 모듈 설정 구조체
 typedef struct {
+    UartLink* link;             // UART 링크 컨텍스트 (모듈마다 별도)
     uart_inst_t* uart;          // UART 인스턴스
     unsigned int uart_tx_pin;   // UART TX 핀
     unsigned int uart_rx_pin;   // UART RX 핀
-    unsigned int uart_baudrate; // UART 보드레이트
+    unsigned int uart_baudrate; // UART 보드레이트 (ESP-01 부팅 기본값)
+    unsigned int uart_target_baudrate; // AT+UART_CUR로 올릴 보드레이트 (0 = 전환 안 함)
+    int uart_cts_pin;           // UART CTS 핀 (ESP RTS와 연결, -1 = 미연결)
+    int uart_rts_pin;           // UART RTS 핀 (ESP CTS와 연결, -1 = 미연결)
     unsigned int rst_pin;       // 리셋 핀
     char ssid[64];              // WiFi SSID
     char password[64];          // WiFi 비밀번호
+    bool wifi_connected;        // WiFi 상태 (WIFI GOT IP / WIFI DISCONNECT URC로 갱신)
+    bool fast_rejoin;           // 마지막 BSSID/IP로 재접속 (스캔/DHCP 생략, 실패 시 전체 접속)
+    Esp01JoinCache join_cache;  // 마지막 성공 접속 정보 (0으로 초기화)
+    Esp01JoinStats join_stats;  // 접속 경로별 통계 (0으로 초기화)
+    uint32_t join_start_ms;     // 진행 중인 접속의 제출 시각
+    bool ready;                 // 리셋 후 응답 가능 ("ready" 배너 또는 AT 응답)
+    bool rebooted;              // 리셋하지 않았는데 "ready" 배너 수신 (전원 불안정 등), 처리한 쪽이 지움
+    uint32_t reset_ms;          // 마지막 리셋 해제(또는 자체 재부팅 감지) 시각
+    uint32_t ready_ms;          // 리셋 해제 → 응답 가능까지 (ms)
 } Esp01Module;
 
-// ESP-01 모듈 초기화 (UART + 하드웨어 리셋)
+// ESP-01 모듈 초기화 (UART + 하드웨어 리셋, 부팅 완료를 확인하면 바로 반환)
 void esp01_module_init(Esp01Module& module);
 
+// 비차단 모듈 초기화 시작 (UART + URC 등록 + RST 핀 내림), 반환: 설정 검증 결과
+// ESP01_RESET_PULSE_MS 뒤 esp01_reset_release, 이후는 비차단 리셋과 같음 (module.ready 대기 → esp01_at_init_async)
+bool esp01_module_begin(Esp01Module& module);
+
 // ESP-01 AT 명령 초기화
 bool esp01_at_init(Esp01Module& module);
 
+// 보드레이트/흐름 제어 전환 (AT+UART_CUR), 반환: 전환 여부
+// 새 속도에서 응답이 없으면 모듈을 리셋해 기존 보드레이트로 복귀하고 AT 초기화 명령(AT, ATE0, AT+CWMODE=1)을 다시 실행
+bool esp01_set_baudrate(Esp01Module& module, unsigned int baudrate);
+
+// 설정된 목표 보드레이트/흐름 제어로 전환 (차단, 필요 없으면 바로 true)
+// 반환: 모듈 사용 가능 여부 (전환에 실패해 기존 보드레이트로 남아도 응답하면 true, 복구 후에도 응답이 없으면 false)
+// esp01_at_init은 내부에서 호출, esp01_at_init_async 뒤에는 필요할 때 직접 호출 (false면 AT 초기화부터 다시)
+bool esp01_negotiate_baudrate(Esp01Module& module);
+
+// 부팅 확인용 AT 1회 제출 (엔진이 비어 있고 아직 ready가 아닐 때만), 응답하면 module.ready
+// 반환: 제출 여부 (비차단 부팅 대기에서 ESP01_READY_PROBE_MS마다 호출)
+bool esp01_probe_ready_async(Esp01Module& module);
+
 // WiFi 연결
 bool esp01_connect_wifi(Esp01Module& module);
 
+// 비차단 WiFi 연결 (AT+CWJAP 1회 제출), 완료 시 module.wifi_connected 갱신
+// fast_rejoin이고 접속 정보가 있으면 AT+CIPSTA(고정 IP) + BSSID 지정 접속,
+// 실패하면 완료 콜백 안에서 DHCP를 켜고 전체 접속을 이어서 제출 (AT 엔진이 빌 때 결과 확정)
+bool esp01_connect_wifi_async(Esp01Module& module);
+
 // WiFi 연결 상태 확인
 bool esp01_is_connected(Esp01Module& module);
 
+// 비차단 WiFi 상태 조회 (AT+CIPSTATUS 제출), 완료 시 module.wifi_connected 갱신
+bool esp01_query_status_async(Esp01Module& module);
+
 // WiFi 재연결 (기존 SSID/비밀번호 사용)
 bool esp01_reconnect_wifi(Esp01Module& module);
 
+// 비차단 하드웨어 리셋 시작: 대기 중인 명령 취소, RST 핀 내림, UART를 부팅 기본 보드레이트로 복귀
+// ESP01_RESET_PULSE_MS 뒤 esp01_reset_release 호출
+void esp01_reset_assert(Esp01Module& module);
+
+// RST 핀 올림, module.ready가 켜지거나 ESP01_BOOT_WAIT_MS가 지나면 esp01_at_init_async로 재초기화
+// (배너를 놓쳐도 재초기화의 첫 AT가 응답 확인을 대신함)
+void esp01_reset_release(Esp01Module& module);
+
+// 비차단 AT 초기화 (AT → ATE0 → AT+CWMODE=1 연쇄 제출), 완료 시 done(결과, user)
+// 보드레이트 재협상은 하지 않음 (리셋 후에는 부팅 기본 보드레이트로 계속)
+bool esp01_at_init_async(Esp01Module& module, AtCallback done, void* user);
+
 #ifdef __cplusplus
 }
 #endif
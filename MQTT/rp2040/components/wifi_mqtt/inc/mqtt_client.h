@@ -3,13 +3,232 @@
 
 #include <stdbool.h>
 #include <cstdint>
+#include "uart_comm.h"
+#include "at_engine.h"
+#include "mqtt_store.h"
+#include "mqtt_packet.h"
+
+// 전송 방식 선택 (빌드 시점)
+// 0 = ESP-AT MQTT 명령 (AT+MQTTPUBRAW 등, 모듈이 MQTT 처리)
+// 1 = 네이티브: AT+CIPSTART TCP 소켓을 투명 전송(AT+CIPMODE=1)으로 열고 MQTT 3.1.1 패킷을 직접 주고받음
+#ifndef MQTT_NATIVE_TRANSPORT
+#define MQTT_NATIVE_TRANSPORT 0
+#endif
+
+// 브로커 keepalive (초): 이 간격 안에 송신이 없으면 PINGREQ로 연결 유지
+// AT 전송은 모듈이 MQTTCONNCFG 값으로 직접 처리, 네이티브 전송은 절반 간격 무송신 시 mqtt_outbox_poll이 보냄
+// 응답이 끊기면 브로커는 1.5배 뒤 LWT(offline)를 발행하고, 끊김은 URC/PINGRESP 시간 초과로 반영
+#ifndef MQTT_KEEPALIVE_S
+#define MQTT_KEEPALIVE_S 60
+#endif
+
+// 네이티브 전송: CONNACK / PUBACK·SUBACK / PINGRESP 대기 한도, 투명 전송 종료("+++") 전후 간격
+#define MQTT_NATIVE_CONNACK_TIMEOUT_MS 5000
+#define MQTT_NATIVE_ACK_TIMEOUT_MS 5000
+#define MQTT_NATIVE_PING_TIMEOUT_MS 5000
+#define MQTT_NATIVE_EXIT_GUARD_MS 20
+#define MQTT_NATIVE_EXIT_WAIT_MS 1000
+
+// 토픽 최대 길이 (NUL 포함, 발행/구독/LWT 토픽 검증 기준)
+#define MAX_TOPIC_LEN 128
+
+// 발행 지연 표본 수 (p50/p99 계산용 최근 발행, 2의 거듭제곱)
+#define MQTT_PUB_LATENCY_SAMPLES 128
+
+// 토픽별 MQTTPUBRAW 명령 접두사 캐시 크기 (반복 발행 토픽 수)
+#define MQTT_PUB_PREFIX_CACHE 4
+
+// 발신 큐 크기 / 항목별 토픽·메시지 최대 길이 (mqtt_enqueue가 복사해 보관)
+#define MQTT_OUTBOX_LEN 8
+#define MQTT_OUTBOX_TOPIC_MAX 128
+#define MQTT_OUTBOX_MSG_MAX AT_PAYLOAD_MAX  // 비차단 발행 한도와 같게 (통계 JSON이 잘리지 않도록)
+// 항목(또는 플래시 보관 메시지)별 최대 전송 횟수 - 계속 실패하는 메시지가 뒤 항목을 막지 않도록 버림
+#define MQTT_OUTBOX_MAX_ATTEMPTS 3
+// 동시에 제출해 두는 발신 큐 항목 수
+// AT 명령은 한 건씩 (나머지는 큐에 남아 병합 대상 유지), 네이티브 전송은 PUBACK/완료 콜백을 기다리는 동안 뒤 항목도 송신
+#ifndef MQTT_OUTBOX_PIPELINE
+#if MQTT_NATIVE_TRANSPORT
+#define MQTT_OUTBOX_PIPELINE AT_QUEUE_LEN
+#else
+#define MQTT_OUTBOX_PIPELINE 1
+#endif
+#endif
+
+// QoS 1 발행 추적 슬롯 수 (결과 대기 + 재전송 대기 메시지) / 재전송 포함 최대 전송 횟수 (로컬 리셋/연결 해제로 취소된 전송은 제외, 전송 계층 시간 초과는 포함)
+#define MQTT_QOS1_SLOTS 4
+#define MQTT_QOS1_MAX_ATTEMPTS 5
+
+// 구독 관리자: 원하는 토픽 수 / 필터 최대 길이 / 토픽 최대 단계 수
+#define MQTT_SUBS_MAX 32
+#define MQTT_SUBS_FILTER_MAX 128
+#define MQTT_SUBS_MAX_LEVELS 8
+
+// 재연결 후 플래시 보관 메시지 재전송 간격 (새 발행보다 뒤, 한 건씩)
+#ifndef MQTT_STORE_REPLAY_INTERVAL_MS
+#define MQTT_STORE_REPLAY_INTERVAL_MS 200
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// MQTT 클라이언트 설정 구조체
+// 발행 통계 (제출 → OK 지연, 비차단 발행은 AT 큐 대기 시간 포함)
+typedef struct {
+    uint32_t published;                                 // 성공
+    uint32_t failed;                                    // 실패/취소
+    uint32_t first_ok_ms;                               // 첫 발행 성공 시각 (ms since boot, 0 = 아직 없음 - 0으로 되돌리면 다음 성공부터 다시 기록)
+    uint32_t samples_us[MQTT_PUB_LATENCY_SAMPLES];      // 최근 발행 지연 (링)
+    uint32_t sample_count;                              // 누적 표본 수
+    uint32_t pending_start_us[AT_QUEUE_LEN];            // 완료 대기 중인 비차단 발행 제출 시각 (엔진 FIFO 순서)
+    uint32_t pending_head;
+    uint32_t pending_tail;
+} MqttPublishStats;
+
+// 발행 지연 요약
+typedef struct {
+    uint32_t published;
+    uint32_t failed;
+    uint32_t samples;       // 요약에 사용한 표본 수 (최대 MQTT_PUB_LATENCY_SAMPLES)
+    uint32_t p50_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} MqttPublishLatency;
+
+// 토픽별 발행 명령 접두사 (AT 전송: "AT+MQTTPUBRAW=0,\"<topic>\",")
+typedef struct {
+    uint16_t topic_len;
+    uint16_t len;                           // 0 = 빈 항목
+    char prefix[MAX_TOPIC_LEN + 24];
+} MqttPubPrefix;
+
+typedef struct {
+    MqttPubPrefix entries[MQTT_PUB_PREFIX_CACHE];
+    uint32_t next;                          // 교체 위치 (순환)
+} MqttPubPrefixCache;
+
+// 발신 큐 항목
+typedef struct {
+    char topic[MQTT_OUTBOX_TOPIC_MAX];
+    char message[MQTT_OUTBOX_MSG_MAX + 1];
+    uint8_t qos;
+    uint8_t retain;
+    bool coalesce;          // true = 같은 토픽의 새 값이 대기 중인 값을 교체 (텔레메트리)
+    uint8_t attempts;       // 실패한 전송 횟수 (취소 제외, 병합으로 값이 바뀌어도 유지)
+} MqttOutboxEntry;
+
+// 발신 큐 (고정 크기 FIFO, 연결된 동안 맨 앞 항목부터 MQTT_OUTBOX_PIPELINE건까지 제출)
+typedef struct {
+    MqttOutboxEntry entries[MQTT_OUTBOX_LEN];
+    uint32_t head;          // 가장 오래된 항목 인덱스
+    uint32_t count;
+    uint32_t in_flight;     // 제출되어 결과 대기 중인 맨 앞 항목 수 (보관 메시지 재전송 중이면 그 1건)
+    bool replaying;         // 진행 중인 발행이 플래시 보관 메시지
+    uint32_t replay_at;     // 다음 보관 메시지 재전송 가능 시각 (ms)
+    uint8_t replay_attempts; // 맨 앞 보관 메시지의 실패한 전송 횟수
+    uint32_t sent;          // 발행 성공
+    uint32_t coalesced;     // 새 값으로 교체된 횟수
+    uint32_t dropped;       // 가득 차서 버린 가장 오래된 항목 + MQTT_OUTBOX_MAX_ATTEMPTS회 실패해 버린 항목 수
+} MqttOutbox;
+
+// QoS 1 전달 완료 콜백 (delivered = false: 최대 전송 횟수 초과로 포기)
+typedef void (*MqttDeliveryCallback)(bool delivered, void* user);
+
+// QoS 1 메시지 상태
+enum {
+    MQTT_QOS1_FREE = 0,
+    MQTT_QOS1_WAITING,      // 전송 대기 (처음 또는 실패 후 재연결 대기)
+    MQTT_QOS1_SENT          // AT 엔진에 제출됨, +MQTTPUB:OK(모듈이 PUBACK 처리) 대기
+};
+
+typedef struct {
+    char topic[MQTT_OUTBOX_TOPIC_MAX];
+    char message[MQTT_OUTBOX_MSG_MAX + 1];
+    uint8_t retain;
+    uint8_t state;
+    uint8_t attempts;       // 전송 횟수
+    uint32_t seq;           // 등록 순서 (재전송도 이 순서로)
+    MqttDeliveryCallback done;
+    void* user;
+} MqttQos1Message;
+
+// QoS 1 발행 추적 (여러 건 동시 제출, 확인될 때까지 보관 → 연결 끊김을 넘어 재전송)
 typedef struct {
+    MqttQos1Message slots[MQTT_QOS1_SLOTS];
+    uint8_t order[MQTT_QOS1_SLOTS];     // 제출된 슬롯 (엔진 완료 순서)
+    uint8_t order_head;
+    uint8_t order_tail;
+    uint32_t next_seq;
+    uint32_t delivered;
+    uint32_t retransmits;
+    uint32_t expired;                   // 최대 전송 횟수 초과
+} MqttQos1;
+
+// 네이티브 전송 연결 단계
+enum {
+    MQTT_NATIVE_CLOSED = 0,
+    MQTT_NATIVE_OPENING,        // AT+CIPMODE/CIPSTART/CIPSEND 진행 중
+    MQTT_NATIVE_CONNACK,        // 투명 전송 시작, CONNECT 보내고 CONNACK 대기
+    MQTT_NATIVE_ONLINE,
+    MQTT_NATIVE_EXIT_GUARD,     // "+++" 앞 무전송 간격 대기
+    MQTT_NATIVE_EXIT_WAIT       // "+++" 뒤 명령 모드 복귀 대기
+};
+
+// 네이티브 전송 완료 대기 요청 (제출 순서대로 완료 콜백 호출)
+typedef struct {
+    AtCallback done;
+    void* user;
+    uint16_t packet_id;         // PUBACK/SUBACK 대조용 (QoS 0 발행은 0)
+    int8_t result;              // AT_RESULT_PENDING = 확인 대기, 0 = 성공
+    uint32_t deadline_ms;
+} MqttNativeRequest;
+
+// 네이티브 전송 상태 (MQTT_NATIVE_TRANSPORT 빌드에서만 사용)
+typedef struct {
+    uint8_t phase;
+    MqttPacketHandler handler;              // 디코더 콜백 (user = 클라이언트)
+    MqttPacketDecoder decoder;
+    MqttNativeRequest requests[AT_QUEUE_LEN];
+    uint32_t req_head;
+    uint32_t req_tail;
+    uint16_t next_packet_id;
+    uint32_t phase_deadline_ms;             // CONNACK 대기 / "+++" 전후 간격
+    bool ping_pending;
+    uint32_t ping_deadline_ms;
+    uint32_t ping_timeouts;
+} MqttNative;
+
+// 구독 필터 (원하는 토픽을 묶은 결과 또는 직접 추가한 와일드카드 필터)
+typedef struct {
+    char filter[MQTT_SUBS_FILTER_MAX];
+    uint8_t qos;
+    bool subscribed;        // 현재 연결에서 구독 완료
+} MqttSubFilter;
+
+// 구독 관리자 (원하는 구독 집합 보관, 재연결 시 최소 필터로 연속 구독)
+// 와일드카드로 넓어진 필터에 딸려 온 토픽은 mqtt_subs_wanted로 걸러냄
+typedef struct {
+    const char* topics[MQTT_SUBS_MAX];          // 원하는 토픽 (문자열은 호출 측이 유지)
+    uint8_t topic_qos[MQTT_SUBS_MAX];
+    uint8_t topic_count;
+    MqttSubFilter filters[MQTT_SUBS_MAX];       // 직접 추가한 필터 + 묶은 필터
+    uint8_t filter_count;
+    uint8_t explicit_count;                     // filters 앞쪽의 직접 추가한 필터 수
+    bool collapse;                              // true = 같은 구조의 토픽을 '+'로 묶음 (브로커 ACL이 허용할 때)
+    bool dirty;                                 // 필터 다시 계산 필요
+    // 구독 진행 상태
+    uint8_t next;                               // 다음에 제출할 필터
+    uint8_t in_flight[AT_QUEUE_LEN];            // 제출한 필터 인덱스 (엔진 완료 순서)
+    uint8_t in_flight_head;
+    uint8_t in_flight_tail;
+    uint8_t failed;
+    struct MqttClient* client;                  // 구독 중인 클라이언트 (완료 콜백용)
+    uint32_t start_us;
+    uint32_t last_apply_us;                     // 마지막 구독 시작 → 완료 시간
+} MqttSubscriptions;
+
+// MQTT 클라이언트 설정 구조체
+typedef struct MqttClient {
+    UartLink* link;           // AT 명령을 주고받을 UART 링크 (ESP-01 모듈과 공유)
     const char* broker;       // MQTT 브로커 주소
     int port;                 // 브로커 포트
     const char* client_id;    // 클라이언트 ID
@@ -18,35 +237,120 @@ typedef struct {
     const char* lwt_topic;    // Last Will Topic
     const char* lwt_message;  // Last Will Message
     bool connected;           // 연결 상태
-    uint32_t last_activity;   // 마지막 MQTT 활동 시간 (ms)
+    uint32_t last_activity;   // 마지막 MQTT 송신 시간 (ms, 네이티브 전송의 PINGREQ 기준)
+    MqttPublishStats pub_stats; // 발행 지연 통계 (0으로 초기화)
+    MqttPubPrefixCache pub_prefix; // 토픽별 발행 명령 접두사 캐시 (0으로 초기화)
+    MqttOutbox outbox;          // 발신 큐 (0으로 초기화)
+    MqttStore* store;           // 연결 끊김 중 발행을 보관할 플래시 로그 (NULL = 사용 안 함)
+    MqttQos1 qos1;              // QoS 1 발행 추적 (0으로 초기화)
+    MqttNative native;          // 네이티브 전송 상태 (0으로 초기화)
 } MqttClient;
 
 // MQTT 브로커 연결
 bool mqtt_connect(MqttClient& client);
 
+// 비차단 브로커 연결 (설정/연결 명령 제출), 완료 시 client.connected 갱신 후 online 발행
+bool mqtt_connect_async(MqttClient& client);
+
+// 비차단 연결 진행 중 (AT 명령 대기는 at_engine_busy로도 보이지만 네이티브 CONNACK 대기는 여기서만)
+bool mqtt_connect_pending(MqttClient& client);
+
 // MQTT 토픽 구독
 bool mqtt_subscribe(MqttClient& client, const char* topic, int qos);
 
-// MQTT 메시지 발행
+// 비차단 토픽 구독 (재시도 없음), 결과 0 = 성공
+bool mqtt_subscribe_async(MqttClient& client, const char* topic, int qos, AtCallback done, void* user);
+
+// 구독 관리자 초기화 / 원하는 토픽 추가 / 와일드카드 필터 직접 추가 (일치하는 토픽은 따로 구독하지 않음)
+void mqtt_subs_init(MqttSubscriptions& subs, bool collapse);
+bool mqtt_subs_add(MqttSubscriptions& subs, const char* topic, int qos);
+bool mqtt_subs_add_filter(MqttSubscriptions& subs, const char* filter, int qos);
+
+// 모든 필터 구독 시작 (재연결 직후 호출, 지연 없이 연속 제출, 비차단)
+bool mqtt_subs_start(MqttClient& client, MqttSubscriptions& subs);
+
+// 실패한 필터만 다시 구독 (비차단)
+bool mqtt_subs_retry(MqttClient& client, MqttSubscriptions& subs);
+
+// 구독 진행 중 여부 / 마지막 구독에서 실패한 필터 수
+bool mqtt_subs_busy(const MqttSubscriptions& subs);
+int mqtt_subs_failed(const MqttSubscriptions& subs);
+
+// 차단 래퍼: 모든 필터 구독 후 완료까지 대기, 실패 필터가 없으면 true
+bool mqtt_subs_apply(MqttClient& client, MqttSubscriptions& subs);
+
+// 수신 토픽이 원하는 구독 집합에 속하는지 (넓은 필터로 딸려 온 토픽 거르기)
+bool mqtt_subs_wanted(const MqttSubscriptions& subs, const char* topic);
+
+// MQTT 토픽 필터 일치 검사 ('+' = 한 단계, '#' = 나머지 전체)
+bool mqtt_topic_matches(const char* filter, const char* topic);
+
+// MQTT 메시지 발행 (AT 전송은 메시지 길이 제한 없음, 네이티브는 QoS 0/1만)
 bool mqtt_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain);
 
-// MQTT 메시지 체크 (수신 확인)
+// 비차단 발행 (토픽/메시지 복사 후 제출), 프롬프트 실패/응답 없음이면 client.connected = false (+MQTTPUB:FAIL은 제외)
+// AT 전송은 메시지를 엔진 슬롯에 복사하므로 최대 AT_PAYLOAD_MAX 바이트 (at_engine.h, 프로젝트에서 재정의 가능)
+// 발신 큐/QoS 1/플래시 재전송도 이 경로를 쓰므로 같은 제한
+bool mqtt_publish_async(MqttClient& client, const char* topic, const char* message, int qos, int retain);
+
+// 발신 큐에 추가 (차단 없음, 연결 끊김 중에도 보관 후 재연결 시 전송)
+// coalesce = true: 같은 토픽의 대기 중인 값을 교체, 가득 차면 가장 오래된 대기 항목을 버림
+// client.store가 있으면 연결 끊김 중 발행은 병합 없이 플래시 로그에 기록 (측정 시각은 페이로드에 실어야 보존됨,
+// 부팅 후 ms를 쓰면 client.store->boot를 함께 실어 재부팅 전 기록과 구분)
+// 전송이 MQTT_OUTBOX_MAX_ATTEMPTS회 실패한 항목(보관 메시지 포함)은 버리고 outbox.dropped에 셈
+bool mqtt_enqueue(MqttClient& client, const char* topic, const char* message, int qos, int retain, bool coalesce);
+
+// QoS 1 발행 (차단 없음, 빈 슬롯이 없으면 false)
+// 확인(+MQTTPUB:OK)될 때까지 슬롯에 보관, 실패하면 재연결 후 등록 순서대로 재전송
+// done은 확인 시 delivered = true, MQTT_QOS1_MAX_ATTEMPTS회 실패 시 false로 한 번 호출
+bool mqtt_publish_qos1(MqttClient& client, const char* topic, const char* message, int retain,
+                       MqttDeliveryCallback done, void* user);
+
+// 확인 대기 중인 QoS 1 메시지 수
+uint32_t mqtt_qos1_pending(const MqttClient& client);
+
+// 발신 큐 배출 (메인 루프에서 호출, 연결된 동안 AT 엔진에 여유가 있으면 다음 항목 제출)
+// QoS 1 메시지를 먼저 모두 제출하고, 발신 큐는 한 건씩
+// 큐가 비면 플래시 보관 메시지를 MQTT_STORE_REPLAY_INTERVAL_MS 간격으로 재전송, 플래시 작업도 진행
+void mqtt_outbox_poll(MqttClient& client);
+
+// MQTT 메시지 체크 (수신 확인, 토픽/메시지를 호출 측 버퍼로 복사)
 bool mqtt_check_message(MqttClient& client, char* topic, int topic_max_len, char* message, int message_max_len);
 
+// 수신 메시지를 복사 없이 조회 (토픽/페이로드는 NUL 종료, payload_len 바이트 그대로)
+// 처리 후 반드시 mqtt_release_message 호출
+bool mqtt_peek_message(MqttClient& client, UartMqttFrame* msg);
+
+// mqtt_peek_message로 조회한 메시지 반환
+void mqtt_release_message(MqttClient& client);
+
+// 토픽의 메시지를 URC 큐 대신 스트리밍으로 받음 (on_begin/on_chunk/on_end, 크기 제한 없음)
+// 구독은 mqtt_subscribe로 따로 요청, handler NULL = 해제
+bool mqtt_register_stream(MqttClient& client, const char* topic, const UartStreamHandler* handler);
+
 // MQTT 연결 상태
 bool mqtt_is_connected(MqttClient& client);
 
 // MQTT 연결 해제
 void mqtt_disconnect(MqttClient& client);
 
-// MQTT 브로커 연결 상태 확인 (AT 명령 사용)
+// MQTT 브로커 연결 상태 확인 (AT 명령 또는 네이티브 PINGREQ)
 bool mqtt_check_connection(MqttClient& client);
 
+// 비차단 연결 상태 확인, 끊김이면 client.connected = false
+bool mqtt_check_connection_async(MqttClient& client);
+
 // MQTT 브로커 재연결 (기존 설정 사용)
 bool mqtt_reconnect(MqttClient& client);
 
-// MQTT keepalive (주기적으로 호출하여 연결 유지)
-void mqtt_keepalive(MqttClient& client);
+// 모듈 리셋 직전 호출: 명령 없이 연결/전송 상태만 초기화 (확인 대기 요청은 취소)
+void mqtt_link_reset(MqttClient& client);
+
+// 발행 지연 요약 (최근 표본의 p50/p99)
+void mqtt_get_publish_latency(MqttClient& client, MqttPublishLatency* out);
+
+// 발행 통계 초기화 (완료 대기 중인 발행은 유지)
+void mqtt_reset_publish_stats(MqttClient& client);
 
 #ifdef __cplusplus
 }
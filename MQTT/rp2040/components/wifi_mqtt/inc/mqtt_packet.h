@@ -0,0 +1,106 @@
+#ifndef MQTT_PACKET_H
+#define MQTT_PACKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 수신 패킷 본문 버퍼 (PUBLISH 외: CONNACK/PUBACK/SUBACK/UNSUBACK, 넘으면 잘라서 전달)
+#define MQTT_PACKET_BODY_MAX 8
+
+// 수신 PUBLISH 토픽 최대 길이 (넘으면 패킷을 건너뜀)
+#define MQTT_PACKET_TOPIC_MAX 128
+
+// 가변 길이 필드 최대 값 (MQTT 3.1.1, 4바이트)
+#define MQTT_PACKET_REMAINING_MAX 268435455u
+
+// MQTT 3.1.1 패킷 종류 (고정 헤더 상위 4비트)
+enum {
+    MQTT_PKT_CONNECT = 1,
+    MQTT_PKT_CONNACK = 2,
+    MQTT_PKT_PUBLISH = 3,
+    MQTT_PKT_PUBACK = 4,
+    MQTT_PKT_PUBREC = 5,
+    MQTT_PKT_PUBREL = 6,
+    MQTT_PKT_PUBCOMP = 7,
+    MQTT_PKT_SUBSCRIBE = 8,
+    MQTT_PKT_SUBACK = 9,
+    MQTT_PKT_UNSUBSCRIBE = 10,
+    MQTT_PKT_UNSUBACK = 11,
+    MQTT_PKT_PINGREQ = 12,
+    MQTT_PKT_PINGRESP = 13,
+    MQTT_PKT_DISCONNECT = 14
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// CONNECT 설정 (문자열 NULL = 필드 생략)
+typedef struct {
+    const char* client_id;
+    const char* username;
+    const char* password;
+    const char* will_topic;
+    const char* will_message;
+    uint8_t will_qos;
+    bool will_retain;
+    bool clean_session;
+    uint16_t keepalive_s;
+} MqttConnectOptions;
+
+// 디코더 콜백 (메인 루프 컨텍스트, mqtt_packet_feed 안에서 호출)
+typedef struct {
+    // PUBLISH 외 패킷 (body는 본문 앞쪽 최대 MQTT_PACKET_BODY_MAX 바이트, len은 담긴 길이)
+    void (*on_packet)(uint8_t type, uint8_t flags, const uint8_t* body, uint32_t len, void* user);
+    // PUBLISH 시작 (topic은 NUL 종료), 이어서 payload_len 바이트가 on_publish_data로 나뉘어 옴
+    void (*on_publish_begin)(const char* topic, uint32_t topic_len, uint8_t flags, uint16_t packet_id,
+                             uint32_t payload_len, void* user);
+    void (*on_publish_data)(const char* data, uint32_t len, void* user);   // data는 콜백 안에서만 유효
+    void* user;
+} MqttPacketHandler;
+
+// 스트리밍 디코더: TCP 바이트열을 도착하는 대로 넣으면 패킷 경계를 찾아 콜백 호출
+// PUBLISH 페이로드는 버퍼에 모으지 않고 입력 구간을 그대로 전달 (크기 제한 없음)
+typedef struct {
+    const MqttPacketHandler* handler;
+    uint8_t state;
+    uint8_t header;                         // 고정 헤더 첫 바이트
+    uint8_t len_shift;                      // 가변 길이 해석 위치 (7비트 단위)
+    uint32_t remaining;                     // 현재 패킷의 남은 바이트
+    uint32_t got;                           // 현재 필드에 모은 바이트
+    uint16_t topic_len;
+    uint16_t packet_id;
+    uint8_t body[MQTT_PACKET_BODY_MAX];
+    char topic[MQTT_PACKET_TOPIC_MAX + 1];
+    bool error;                             // 형식 오류 (스트림 동기 상실 → 연결을 다시 열어야 함)
+    uint32_t skipped;                       // 토픽이 너무 길어 건너뛴 PUBLISH 수
+} MqttPacketDecoder;
+
+// CONNECT 패킷 작성, 반환: 길이 (버퍼 부족/설정 오류 시 0)
+uint32_t mqtt_packet_connect(uint8_t* buf, uint32_t max, const MqttConnectOptions& opt);
+
+// PUBLISH 헤더 작성 (고정 헤더 + 토픽 + 패킷 ID), 페이로드는 호출 측이 이어서 전송
+// packet_id는 qos > 0일 때만 기록, 반환: 헤더 길이 (버퍼 부족 시 0)
+uint32_t mqtt_packet_publish_header(uint8_t* buf, uint32_t max, const char* topic, uint32_t payload_len,
+                                    int qos, bool retain, uint16_t packet_id);
+
+// SUBSCRIBE 패킷 작성 (필터 하나), 반환: 길이 (버퍼 부족 시 0)
+uint32_t mqtt_packet_subscribe(uint8_t* buf, uint32_t max, uint16_t packet_id, const char* filter, int qos);
+
+// PUBACK 등 패킷 ID만 있는 패킷 (4바이트), 반환: 4
+uint32_t mqtt_packet_ack(uint8_t* buf, uint8_t type, uint16_t packet_id);
+
+// PINGREQ/DISCONNECT 등 본문 없는 패킷 (2바이트), 반환: 2
+uint32_t mqtt_packet_empty(uint8_t* buf, uint8_t type);
+
+// 디코더 초기화 (새 TCP 연결마다)
+void mqtt_packet_decoder_init(MqttPacketDecoder& dec, const MqttPacketHandler* handler);
+
+// 수신 바이트 해석, 형식 오류 시 false (이후 입력은 무시)
+bool mqtt_packet_feed(MqttPacketDecoder& dec, const uint8_t* data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MQTT_PACKET_H
@@ -0,0 +1,87 @@
+#ifndef MQTT_ROUTER_H
+#define MQTT_ROUTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 트라이 노드 수 (필터 단계 수의 합 상한, 루트 포함)
+#ifndef MQTT_ROUTER_NODES
+#define MQTT_ROUTER_NODES 256
+#endif
+
+// 등록 가능한 핸들러 수
+#ifndef MQTT_ROUTER_ROUTES
+#define MQTT_ROUTER_ROUTES 128
+#endif
+
+// 단계 문자열 저장 공간 (바이트, 같은 부모 아래 같은 단계는 한 번만 저장)
+#ifndef MQTT_ROUTER_TEXT_POOL
+#define MQTT_ROUTER_TEXT_POOL 2048
+#endif
+
+// 자식 단계 해시 테이블 크기 (2의 거듭제곱, 노드 수보다 커야 함)
+#define MQTT_ROUTER_HASH_SIZE 512
+
+// 한 단계에서 동시에 따라가는 경로 수 ('+'와 일반 단계가 겹칠 때 갈라짐)
+// 경로는 '+' 노드를 지날 때만 하나씩 늘어나므로 1 + '+' 노드 수를 넘지 않음
+// → '+' 노드는 MQTT_ROUTER_ACTIVE_MAX - 1개까지만 등록 (디스패치에서 경로를 버리는 일이 없음)
+#ifndef MQTT_ROUTER_ACTIVE_MAX
+#define MQTT_ROUTER_ACTIVE_MAX 16
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 메시지 핸들러 (topic/payload는 호출 중에만 유효, payload는 NUL 종료)
+typedef void (*MqttRouteHandler)(const char* topic, const char* payload, uint32_t payload_len, void* user);
+
+// 트라이 노드 = 필터의 한 단계
+typedef struct {
+    uint16_t parent;
+    uint16_t text_off;          // 단계 문자열 위치 (text 풀)
+    uint8_t text_len;
+    int16_t plus;               // '+' 자식 노드 (-1 = 없음)
+    int16_t routes;             // 이 단계에서 끝나는 필터의 첫 핸들러 (-1 = 없음)
+    int16_t hash_routes;        // 이 단계 아래 '#' 필터의 첫 핸들러 (-1 = 없음)
+} MqttRouterNode;
+
+typedef struct {
+    MqttRouteHandler handler;
+    void* user;
+    int16_t next;               // 같은 노드의 다음 핸들러 (등록 순)
+} MqttRoute;
+
+// 토픽 라우터: 필터를 등록 시점에 단계별 트라이로 만들어 두고,
+// 수신 토픽은 단계마다 (부모 노드, 단계 문자열) 해시로 자식을 찾아 한 번만 훑음
+// → 비용은 토픽 길이에 비례하고 등록된 핸들러 수와 무관
+typedef struct {
+    MqttRouterNode nodes[MQTT_ROUTER_NODES];
+    uint16_t node_count;
+    int16_t table[MQTT_ROUTER_HASH_SIZE];   // 일반 단계 자식 노드 (-1 = 빈 칸, 선형 탐사)
+    char text[MQTT_ROUTER_TEXT_POOL];
+    uint16_t text_used;
+    MqttRoute routes[MQTT_ROUTER_ROUTES];
+    uint16_t route_count;
+    uint16_t plus_count;        // '+' 노드 수 (동시 경로 수 상한 = 1 + plus_count)
+    // 통계
+    uint32_t dispatched;        // 핸들러가 하나 이상 호출된 메시지 수
+    uint32_t unmatched;         // 일치하는 필터가 없던 메시지 수
+} MqttRouter;
+
+// 라우터 초기화 (등록된 필터 모두 제거)
+void mqtt_router_init(MqttRouter& router);
+
+// 필터에 핸들러 등록 ('+' = 한 단계, '#' = 마지막 단계에서 나머지 전체)
+// 같은 필터에 여러 핸들러 등록 가능, 겹치는 필터는 모두 호출됨
+// 새 '+' 위치가 MQTT_ROUTER_ACTIVE_MAX - 1개를 넘으면 거절 (이미 있는 '+' 위치를 쓰는 필터는 제한 없음)
+bool mqtt_router_add(MqttRouter& router, const char* filter, MqttRouteHandler handler, void* user);
+
+// 토픽과 일치하는 모든 핸들러 호출 (반환: 호출한 핸들러 수, 0 = 일치 없음)
+int mqtt_router_dispatch(MqttRouter& router, const char* topic, const char* payload, uint32_t payload_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MQTT_ROUTER_H
@@ -0,0 +1,90 @@
+#ifndef MQTT_STORE_H
+#define MQTT_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "hardware/flash.h"
+#include "uart_comm.h"
+
+// 보관 영역 크기 (섹터 수 = 보관 한도, 가득 차면 가장 오래된 섹터부터 지움)
+// 영역은 플래시 끝에서부터 잡으므로 펌웨어 크기 + 이 영역이 플래시 크기를 넘지 않아야 함
+#ifndef MQTT_STORE_SECTORS
+#define MQTT_STORE_SECTORS 32
+#endif
+
+// 마지막 기록 후 부분 페이지를 플래시에 기록하기까지 대기 시간 (전원 차단 시 손실 범위)
+#ifndef MQTT_STORE_FLUSH_MS
+#define MQTT_STORE_FLUSH_MS 1000
+#endif
+
+// 기록 하나의 토픽/페이로드 최대 길이
+#define MQTT_STORE_TOPIC_MAX 127
+#define MQTT_STORE_PAYLOAD_MAX 256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 보관된 메시지 (토픽/페이로드는 XIP 플래시를 직접 가리킴, NUL 종료)
+typedef struct {
+    const char* topic;
+    const char* payload;
+    uint32_t payload_len;
+    uint8_t qos;
+    uint8_t retain;
+} MqttStoredMessage;
+
+// 플래시 발행 로그 (추가 전용, 섹터 단위 순환 → 모든 섹터가 고르게 지워짐)
+// 섹터 = [헤더(magic, seq)][기록...], 기록 = [헤더][토픽\0][페이로드\0] (4바이트 정렬)
+// 전송 완료 표시는 기록 헤더의 플래그 비트를 1→0으로 덮어써 지우기 없이 처리
+// 부팅마다 번호를 하나 올려 빈 부팅 표시 기록으로 남김 → 부팅 후 ms 시각은 (boot, ms) 쌍으로 부팅이 바뀌어도 구분
+typedef struct {
+    uint32_t base;                      // 영역 시작 (플래시 오프셋)
+    uint32_t sectors;
+    uint32_t boot;                      // 이번 부팅 번호 (로그에 남은 가장 큰 번호 + 1, 0 = 열리지 않음)
+    UartLink* pause_link;               // 플래시 작업 동안 RTS로 수신을 멈출 링크 (init 후 설정, NULL = 멈추지 않음)
+    // 쓰기 위치
+    uint32_t write_seq;                 // 현재 쓰기 섹터 순번 (물리 섹터 = seq % sectors)
+    uint32_t write_off;                 // 섹터 내 다음 기록 위치
+    uint32_t flushed_off;               // 쓰기 섹터에서 플래시에 기록 완료된 끝 (읽기 한계)
+    uint8_t page[FLASH_PAGE_SIZE];      // 기록 중인 페이지 (RAM)
+    uint32_t page_off;                  // page가 대응하는 섹터 내 오프셋
+    bool page_dirty;
+    bool erase_pending;                 // 쓰기 섹터 지우기 전 (헤더/기록은 page에만 있음)
+    uint32_t last_append_ms;
+    // 읽기 위치 (가장 오래된 미전송 기록)
+    uint32_t read_seq;
+    uint32_t read_off;
+    uint32_t peek_seq;                  // 마지막 peek 위치 (ack 대상 확인용)
+    uint32_t peek_off;
+    uint32_t ack_off;                   // 전송 완료 표시할 기록 플래그의 플래시 오프셋 (0 = 없음)
+    // 통계
+    uint32_t pending;                   // 미전송 기록 수
+    uint32_t stored;
+    uint32_t replayed;
+    uint32_t dropped;                   // 보관 한도 초과로 지워진 미전송 기록 + 기록 실패
+    uint32_t erases;
+} MqttStore;
+
+// 보관 영역 열기 (플래시 끝 MQTT_STORE_SECTORS 섹터), 기존 로그를 스캔해 쓰기/읽기 위치와 부팅 번호 복구
+// 이번 부팅 번호의 표시 기록은 RAM 페이지에만 추가 (플래시 기록은 mqtt_store_poll에서)
+bool mqtt_store_init(MqttStore& store);
+
+// 메시지 기록 (RAM 페이지에 추가, 페이지가 차면 그 페이지만 즉시 기록)
+bool mqtt_store_append(MqttStore& store, const char* topic, const char* payload, uint32_t payload_len,
+                       int qos, int retain);
+
+// 가장 오래된 미전송 메시지 조회 (플래시에 기록된 것만, 없으면 false)
+bool mqtt_store_peek(MqttStore& store, MqttStoredMessage* msg);
+
+// mqtt_store_peek으로 조회한 메시지를 전송 완료로 표시하고 다음으로 이동
+void mqtt_store_ack(MqttStore& store);
+
+// 지연된 플래시 작업 진행 (메인 루프에서 호출, 호출당 섹터 지우기 또는 페이지 기록 최대 1회)
+void mqtt_store_poll(MqttStore& store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MQTT_STORE_H
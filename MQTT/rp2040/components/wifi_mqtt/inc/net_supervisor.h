@@ -0,0 +1,132 @@
+#ifndef NET_SUPERVISOR_H
+#define NET_SUPERVISOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "at_engine.h"
+#include "esp01.h"
+#include "mqtt_client.h"
+
+// 연결된 동안 브로커 연결 확인 기본 간격 (ms, 초기화 후 check_interval_ms로 변경 가능)
+#define NET_SUP_CHECK_INTERVAL_MS 30000
+
+// 복구 시도 간격: 실패마다 두 배 (상한까지), 실제 대기는 [간격/2, 간격] 안에서 보드별 난수
+#ifndef NET_SUP_BACKOFF_BASE_MS
+#define NET_SUP_BACKOFF_BASE_MS 1000
+#endif
+#ifndef NET_SUP_BACKOFF_MAX_MS
+#define NET_SUP_BACKOFF_MAX_MS 60000
+#endif
+
+// 단계별 연속 실패 한도 (넘으면 MQTT 재연결 → WiFi 재접속 → 모듈 리셋 순으로 격상)
+#ifndef NET_SUP_TIER_ATTEMPTS
+#define NET_SUP_TIER_ATTEMPTS 3
+#endif
+
+// 복원(구독/online 발행) 재시도 간격 (ms, 연결은 유지된 상태)
+#define NET_SUP_RESTORE_RETRY_MS 1000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 감독자 상태 (AT 엔진이 비었을 때 한 단계씩 진행)
+typedef enum {
+    NET_SUP_ONLINE,         // 정상 - 주기적 연결 확인만
+    NET_SUP_BACKOFF,        // 다음 시도까지 대기
+    NET_SUP_WIFI_CHECK,     // AT+CIPSTATUS 결과 대기
+    NET_SUP_WIFI_JOIN,      // AT+CWJAP 결과 대기
+    NET_SUP_MQTT_CONNECT,   // 브로커 연결 결과 대기
+    NET_SUP_RESTORE,        // 앱 복원 결과 대기 (구독/online 발행)
+    NET_SUP_RESET_PULSE,    // RST 핀 내린 상태
+    NET_SUP_RESET_BOOT,     // 모듈 부팅 대기
+    NET_SUP_RESET_INIT      // AT 재초기화 결과 대기
+} NetSupervisorState;
+
+// 복구 단계 (시도가 계속 실패하면 격상, 복구되면 처음으로)
+typedef enum {
+    NET_TIER_MQTT,          // WiFi 상태 확인 후 브로커만 재연결
+    NET_TIER_WIFI,          // WiFi 재접속 후 브로커 연결
+    NET_TIER_RESET          // 모듈 하드웨어 리셋 후 처음부터
+} NetTier;
+
+// 복원 확인 결과
+typedef enum {
+    NET_RESTORE_PENDING,    // 아직 응답 대기
+    NET_RESTORE_DONE,       // 완료 (또는 앱이 포기) → 정상 상태로
+    NET_RESTORE_RETRY       // NET_SUP_RESTORE_RETRY_MS 뒤 submit(attempt + 1)
+} NetRestoreResult;
+
+// 브로커 재연결 직후 앱 복원 (메인 루프 컨텍스트, 제출만 하고 반환)
+typedef struct {
+    // attempt: 0 = 새 연결, 재시도마다 1씩 증가, 반환: 제출 여부 (false면 다음 poll에서 다시 호출)
+    bool (*submit)(MqttClient& mqtt, uint32_t attempt, void* user);
+    // AT 엔진이 빈 뒤 호출
+    NetRestoreResult (*check)(MqttClient& mqtt, uint32_t attempt, void* user);
+    void* user;
+} NetRestoreHooks;
+
+// 복구 통계 (끊김 감지 → 복원 완료까지)
+typedef struct {
+    uint32_t outages;           // 끊김 감지 횟수
+    uint32_t recoveries;        // 복구 완료 횟수
+    uint32_t attempts;          // 복구 시도 (모든 단계 합)
+    uint32_t wifi_rejoins;      // WiFi 재접속 시도
+    uint32_t module_resets;     // 모듈 리셋
+    uint32_t last_recover_ms;   // 최근 복구 소요 시간
+    uint32_t max_recover_ms;
+    uint64_t total_recover_ms;  // 평균 = total_recover_ms / recoveries
+    uint32_t cold_starts;       // 모듈 리셋/재부팅 후 첫 발행까지 측정한 횟수 (부팅 포함)
+    uint32_t last_cold_ms;      // 최근 리셋 해제 → 첫 발행 성공
+    uint32_t max_cold_ms;
+} NetSupervisorStats;
+
+// 네트워크 복구 감독자: 끊김 감지 시 단계별 복구를 비차단으로 진행
+// 시도 간격에 보드별 지터를 넣어 AP 재부팅 후 여러 보드가 동시에 몰리지 않게 함
+typedef struct {
+    Esp01Module* esp01;
+    MqttClient* mqtt;
+    AtEngine* at;
+    const NetRestoreHooks* restore;
+    NetSupervisorState state;
+    NetTier tier;
+    uint8_t tier_failures;      // 현재 단계 연속 실패
+    uint32_t restore_attempt;
+    int init_result;            // 모듈 재초기화 결과 (AT_RESULT_PENDING = 대기)
+    uint32_t backoff_ms;        // 다음 실패 시 대기 상한
+    uint32_t retry_at;          // 다음 단계 진행 가능 시각 (ms)
+    uint32_t check_interval_ms; // 연결 확인 간격 (기본 NET_SUP_CHECK_INTERVAL_MS)
+    uint32_t last_check;        // 마지막 연결 확인 시각 (ms)
+    uint32_t down_since;        // 끊김 감지 시각 (ms)
+    uint32_t boot_deadline;     // 리셋 후 부팅 완료 대기 한도 (ms)
+    bool cold_pending;          // 리셋 후 첫 발행 대기 중
+    uint32_t rng;               // 지터 난수 상태 (보드 고유 ID로 시드)
+    NetSupervisorStats stats;
+} NetSupervisor;
+
+// 초기화 (연결된 상태에서 시작, 첫 끊김부터 감독), restore = NULL이면 복원 단계 없음
+// 부팅 시 첫 발행을 마친 직후 호출하면 그 시점을 부팅 콜드 스타트로 기록
+void net_supervisor_init(NetSupervisor& sup, Esp01Module& esp01, MqttClient& mqtt, const NetRestoreHooks* restore);
+
+// 한 단계 진행 (메인 루프에서 매번 호출, 차단 없음)
+void net_supervisor_poll(NetSupervisor& sup, uint32_t now);
+
+// 정상 상태(복원까지 완료)인지
+bool net_supervisor_online(const NetSupervisor& sup);
+
+// 현재 끊김 지속 시간 (ms, 정상이면 0)
+uint32_t net_supervisor_down_ms(const NetSupervisor& sup, uint32_t now);
+
+// 상태/단계 이름 (로그용)
+const char* net_supervisor_state_name(NetSupervisorState state);
+const char* net_supervisor_tier_name(NetTier tier);
+
+// 통계 JSON 생성 (발행용), 반환: 길이 (실패 시 -1)
+int net_supervisor_format_stats(const NetSupervisor& sup, uint32_t now, char* buffer, int max_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_SUPERVISOR_H
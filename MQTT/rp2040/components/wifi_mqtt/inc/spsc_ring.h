@@ -0,0 +1,197 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief 단일 생산자/단일 소비자(SPSC) lock-free 링버퍼 (헤더 전용)
+ *
+ * - 크기 N은 컴파일 타임 2의 거듭제곱 → 나머지 연산 대신 마스크로 순환
+ * - head/tail은 32비트 누적 인덱스 (N 바이트 전부 사용 가능, 오버플로우 자연 순환)
+ * - 생산자는 데이터 기록 후 release 저장, 소비자는 acquire 적재
+ *   → ISR(생산자)과 메인 루프(소비자)가 인터럽트를 막지 않고 공유
+ * - DMA 링 모드(쓰기 주소 순환)의 대상으로 쓸 링만 Align = N으로 저장소를 N 경계에 정렬
+ *   (정렬한 링은 객체 크기가 2N이 되므로 필요한 링에만 지정, 기본은 N + 인덱스 8바이트)
+ *
+ * @tparam N 버퍼 크기 (바이트, 2의 거듭제곱)
+ * @tparam Align 저장소 정렬 (바이트, DMA 링 대상이면 N)
+ */
+template <uint32_t N, uint32_t Align = 1>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing 크기는 2의 거듭제곱이어야 합니다");
+    static_assert((Align & (Align - 1)) == 0 && Align <= N, "SpscRing 정렬은 N 이하의 2의 거듭제곱이어야 합니다");
+
+public:
+    static constexpr uint32_t CAPACITY = N;
+    static constexpr uint32_t MASK = N - 1;
+
+    /**
+     * @brief log2(N) - DMA 링 크기 설정값 (channel_config_set_ring)
+     */
+    static constexpr uint32_t BITS = [] {
+        uint32_t bits = 0;
+        while ((1u << bits) < N) {
+            bits++;
+        }
+        return bits;
+    }();
+
+    /**
+     * @brief 링 안의 연속 구간 (랩 경계에서 최대 2개로 나뉨)
+     */
+    struct Span {
+        const char* data;
+        uint32_t len;
+    };
+
+    // ========== 생산자 ==========
+
+    /**
+     * @brief 1바이트 기록
+     *
+     * @return false 버퍼 가득 참 (바이트 버림)
+     */
+    bool push(char ch) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= N) {
+            return false;
+        }
+        buf_[head & MASK] = ch;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 여러 바이트 기록
+     *
+     * @return uint32_t 실제로 기록한 바이트 수 (남은 공간만큼)
+     */
+    uint32_t write(const char* src, uint32_t len) {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        uint32_t space = N - (head - tail_.load(std::memory_order_acquire));
+        if (len > space) {
+            len = space;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            buf_[(head + i) & MASK] = src[i];
+        }
+        head_.store(head + len, std::memory_order_release);
+        return len;
+    }
+
+    /**
+     * @brief 외부 생산자(DMA)가 storage()에 직접 쓴 위치까지 공개
+     *
+     * @param head 새 누적 쓰기 인덱스
+     */
+    void publish(uint32_t head) {
+        head_.store(head, std::memory_order_release);
+    }
+
+    /**
+     * @brief DMA 대상 저장소 시작 주소
+     */
+    volatile char* storage() {
+        return buf_;
+    }
+
+    // ========== 소비자 ==========
+
+    /**
+     * @brief 누적 쓰기 인덱스 (소비자 측 acquire)
+     */
+    uint32_t head() const {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 누적 읽기 인덱스
+     */
+    uint32_t tail() const {
+        return tail_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 읽을 수 있는 바이트 수
+     */
+    uint32_t size() const {
+        return head() - tail();
+    }
+
+    /**
+     * @brief 누적 인덱스 위치의 바이트 (tail <= index < head 범위에서만 유효)
+     */
+    char at(uint32_t index) const {
+        return buf_[index & MASK];
+    }
+
+    /**
+     * @brief 읽을 수 있는 데이터를 복사 없이 최대 2개 구간으로 반환
+     *
+     * @param spans 결과 구간 (spans[1]은 랩이 없으면 길이 0)
+     * @param max_len 최대 길이
+     * @return uint32_t 두 구간 길이의 합
+     */
+    uint32_t peek(Span spans[2], uint32_t max_len = N) const {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        uint32_t avail = head() - tail;
+        if (avail > max_len) {
+            avail = max_len;
+        }
+
+        uint32_t offset = tail & MASK;
+        uint32_t first = N - offset;
+        if (first > avail) {
+            first = avail;
+        }
+
+        spans[0].data = const_cast<const char*>(&buf_[offset]);
+        spans[0].len = first;
+        spans[1].data = const_cast<const char*>(&buf_[0]);
+        spans[1].len = avail - first;
+        return avail;
+    }
+
+    /**
+     * @brief n 바이트 소비 (읽을 수 있는 양을 넘지 않도록 제한)
+     */
+    void consume(uint32_t n) {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        uint32_t avail = head() - tail;
+        if (n > avail) {
+            n = avail;
+        }
+        tail_.store(tail + n, std::memory_order_release);
+    }
+
+    /**
+     * @brief 누적 인덱스 index 직전까지 소비
+     */
+    void consume_to(uint32_t index) {
+        consume(index - tail());
+    }
+
+    /**
+     * @brief 읽지 않은 데이터 모두 버림 (소비자 측 연산)
+     */
+    void clear() {
+        tail_.store(head(), std::memory_order_release);
+    }
+
+    /**
+     * @brief 인덱스 초기화 (생산자가 멈춘 상태에서만 호출)
+     */
+    void reset() {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_release);
+    }
+
+private:
+    // 인덱스를 저장소 앞에 두어 정렬하지 않은 링은 뒤쪽 패딩 없이 N + 8바이트
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    alignas(Align) volatile char buf_[N];
+};
+
+#endif // SPSC_RING_H
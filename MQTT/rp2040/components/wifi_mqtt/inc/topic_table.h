@@ -0,0 +1,140 @@
+#ifndef TOPIC_TABLE_H
+#define TOPIC_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief 컴파일 타임 토픽 테이블 (완전 해시, 헤더 전용)
+ *
+ * - 빌드 시점에 정해진 토픽 목록을 constexpr로 받아, 모든 토픽이 서로 다른 칸에 들어가는
+ *   해시 시드를 컴파일러가 찾음 → 조회는 해시 1회 + 문자열 비교 1회
+ * - constexpr 객체로 선언하면 테이블 전체가 플래시(.rodata)에 놓여 RAM을 쓰지 않음
+ * - 토픽 길이/충돌 검사는 perfect(), max_len()을 static_assert로 확인
+ *
+ * 사용 예:
+ * @code
+ * static constexpr TopicTable<Kind, 2>::Entry list[] = { {"a/b", KIND_A}, {"a/c", KIND_C} };
+ * static constexpr TopicTable<Kind, 2> table(list);
+ * static_assert(table.perfect(), "충돌 없는 해시 시드 없음");
+ * static_assert(table.max_len() < MAX_TOPIC_LEN, "토픽 길이 초과");
+ * const Kind* kind = table.find(topic, topic_len);
+ * @endcode
+ *
+ * @tparam V 토픽에 대응하는 값 (constexpr 생성 가능한 타입)
+ * @tparam N 토픽 수 (1~255)
+ */
+template <typename V, uint32_t N>
+class TopicTable {
+    static_assert(N >= 1 && N <= 255, "TopicTable 토픽 수는 1~255");
+
+public:
+    struct Entry {
+        const char* topic;
+        V value;
+    };
+
+    /**
+     * @brief 해시 칸 수 (토픽 수의 4배 이상 2의 거듭제곱 → 시드 탐색이 빨리 끝남)
+     */
+    static constexpr uint32_t SLOTS = [] {
+        uint32_t slots = 1;
+        while (slots < N * 4) {
+            slots <<= 1;
+        }
+        return slots;
+    }();
+
+    // 시드 탐색 상한 (넘으면 perfect() = false)
+    static constexpr uint32_t SEED_LIMIT = 1u << 16;
+
+    static constexpr uint8_t EMPTY = 0xFF;
+
+    constexpr TopicTable(const Entry (&entries)[N])
+        : entries_{}, lens_{}, slots_{}, seed_(0), max_len_(0), perfect_(false) {
+        for (uint32_t i = 0; i < N; i++) {
+            entries_[i] = entries[i];
+            lens_[i] = const_strlen(entries[i].topic);
+            if (lens_[i] > max_len_) {
+                max_len_ = lens_[i];
+            }
+        }
+
+        for (uint32_t seed = 0; seed < SEED_LIMIT && !perfect_; seed++) {
+            for (uint32_t s = 0; s < SLOTS; s++) {
+                slots_[s] = EMPTY;
+            }
+            bool collision = false;
+            for (uint32_t i = 0; i < N && !collision; i++) {
+                uint32_t s = hash(seed, entries_[i].topic, lens_[i]) & (SLOTS - 1);
+                if (slots_[s] != EMPTY) {
+                    collision = true;   // 같은 토픽이 두 번 있어도 여기서 걸림
+                } else {
+                    slots_[s] = (uint8_t)i;
+                }
+            }
+            if (!collision) {
+                seed_ = seed;
+                perfect_ = true;
+            }
+        }
+    }
+
+    /**
+     * @brief 토픽 조회
+     *
+     * @param topic 수신 토픽 (NUL 종료 불필요)
+     * @param len 토픽 길이
+     * @return 대응 값, 목록에 없으면 nullptr
+     */
+    const V* find(const char* topic, uint32_t len) const {
+        if (!topic) {
+            return nullptr;
+        }
+        uint8_t i = slots_[hash(seed_, topic, len) & (SLOTS - 1)];
+        if (i == EMPTY || lens_[i] != len || memcmp(entries_[i].topic, topic, len) != 0) {
+            return nullptr;
+        }
+        return &entries_[i].value;
+    }
+
+    constexpr uint32_t size() const { return N; }
+    constexpr const Entry& operator[](uint32_t i) const { return entries_[i]; }
+
+    /**
+     * @brief 모든 토픽이 서로 다른 칸에 들어가는 시드를 찾았는지 (static_assert 용)
+     */
+    constexpr bool perfect() const { return perfect_; }
+
+    /**
+     * @brief 가장 긴 토픽 길이 (static_assert 용)
+     */
+    constexpr uint32_t max_len() const { return max_len_; }
+
+private:
+    // FNV-1a (시드를 초기값에 섞음)
+    static constexpr uint32_t hash(uint32_t seed, const char* s, uint32_t len) {
+        uint32_t h = 2166136261u ^ (seed * 0x9E3779B1u);
+        for (uint32_t i = 0; i < len; i++) {
+            h = (h ^ (uint8_t)s[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    static constexpr uint32_t const_strlen(const char* s) {
+        uint32_t len = 0;
+        while (s[len] != '\0') {
+            len++;
+        }
+        return len;
+    }
+
+    Entry entries_[N];
+    uint32_t lens_[N];
+    uint8_t slots_[SLOTS];
+    uint32_t seed_;
+    uint32_t max_len_;
+    bool perfect_;
+};
+
+#endif // TOPIC_TABLE_H
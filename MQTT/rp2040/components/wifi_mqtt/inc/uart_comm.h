@@ -4,31 +4,383 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "hardware/uart.h"
+#include "pico/time.h"
+#include "spsc_ring.h"
+
+// RX 링버퍼 크기 (2의 거듭제곱, 프로젝트별로 target_compile_definitions로 조정)
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE 1024
+#endif
+
+// 명령 응답 링버퍼 크기 (URC를 걸러낸 응답 줄만 저장, 2의 거듭제곱)
+#ifndef UART_RESP_BUFFER_SIZE
+#define UART_RESP_BUFFER_SIZE 512
+#endif
+
+// URC 메시지 큐 크기 (+MQTTSUBRECV 프레임 저장, 2의 거듭제곱, 메시지 하나의 최대 크기도 결정)
+#ifndef UART_URC_BUFFER_SIZE
+#define UART_URC_BUFFER_SIZE UART_RX_BUFFER_SIZE
+#endif
+
+// URC 등록 한도 / 콜백에 넘기는 줄 최대 길이
+#define UART_URC_MAX_HANDLERS 8
+#define UART_URC_LINE_MAX 128
+
+// 수신 MQTT 메시지 토픽 최대 길이 (+MQTTSUBRECV 헤더 검증)
+#define UART_MQTT_TOPIC_MAX 128
+
+// 스트리밍 구독 등록 한도
+#define UART_STREAM_MAX_HANDLERS 4
+
+// RX 수신 방식: 1 = DMA가 링버퍼에 직접 기록 (감시 타이머가 새 수신을 볼 때/링 한 바퀴에서만 CPU 깨어남)
+//              0 = 바이트 단위 RX 인터럽트
+#ifndef UART_RX_USE_DMA
+#define UART_RX_USE_DMA 1
+#endif
+
+// DMA 수신 감시 주기 (us): DMA가 FIFO를 바로 비우므로 수신 타임아웃(RTIM) 인터럽트는 거의 발생하지 않음
+// → 이 주기마다 DMA 쓰기 위치를 확인해 움직였으면 WFE 대기 코어를 깨움 (응답 지연 상한)
+// 타이머는 응답을 기다리는 동안만 가동 (진행 중인 AT 명령, uart_wait_any, 프레임 수신 중, 투명 전송 세션)
+// → 그동안 알람 인터럽트가 초당 1000000 / UART_RX_DMA_WATCH_US회 (기본 2000회, 회당 수 us),
+//   유휴 상태에서는 0회 (그때 도착한 URC는 uart_wait_event의 10 ms 상한 안에 처리)
+#ifndef UART_RX_DMA_WATCH_US
+#define UART_RX_DMA_WATCH_US 500
+#endif
+
+// TX 큐 크기 (세그먼트 슬롯 수 / 복사 전송용 스테이징 버퍼)
+#define UART_TX_QUEUE_LEN 16
+#define UART_TX_STAGING_SIZE 1024
+
+// 복사 전송 한 번의 최대 크기: 링 끝에서 감기 패딩을 더해도 스테이징 버퍼를 넘지 않는 한도
+#define UART_TX_STAGING_CHUNK (UART_TX_STAGING_SIZE / 2)
+
+// 응답 매처 한도
+#define UART_MATCH_MAX_TOKENS 6
+#define UART_MATCH_MAX_TOKEN_LEN 32
+
+// 보드레이트 허용 범위 (ESP8266 AT+UART_CUR 상한 고려)
+#define UART_BAUD_MIN 300
+#define UART_BAUD_MAX 4000000
+
+// AT 왕복 시간 히스토그램 (구간 경계: 1,2,5,10,20,50,100,200,500,1000,2000,5000 ms, 마지막 = 그 이상)
+#define UART_RTT_BUCKETS 13
+
+// RX 링만 DMA 링 모드 대상이므로 자기 크기에 정렬 (바이트 인터럽트 모드는 정렬 불필요)
+typedef SpscRing<UART_RX_BUFFER_SIZE, UART_RX_USE_DMA ? UART_RX_BUFFER_SIZE : 1> UartRxRing;
+typedef SpscRing<UART_RESP_BUFFER_SIZE> UartRespRing;
+typedef SpscRing<UART_URC_BUFFER_SIZE> UartUrcRing;
+typedef UartRxRing::Span UartSpan;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// UART 초기화
-void uart_init_esp01(uart_inst_t* uart, unsigned int tx_pin, unsigned int rx_pin, unsigned int baudrate);
+// RX 깨어남 통계 (bytes / wakeups = 깨어남당 이동 바이트)
+typedef struct {
+    uint32_t wakeups;   // RX 처리를 위한 CPU 인터럽트 진입 횟수
+    uint32_t bytes;     // 링버퍼로 이동한 누적 바이트
+} UartRxStats;
+
+// 링크 상태 통계 (현장 데이터로 버퍼 크기 결정용)
+typedef struct {
+    uint32_t rx_bytes;          // 수신 누적 바이트
+    uint32_t rx_dropped;        // 링버퍼 가득 참으로 잃은 바이트
+    uint32_t rx_hwm;            // 링버퍼 최대 점유 (high-water mark)
+    uint32_t rx_capacity;       // 링버퍼 크기
+    uint32_t overrun_errors;    // UART RX FIFO 오버런
+    uint32_t framing_errors;    // 프레이밍 오류 (보드레이트 불일치/잡음)
+    uint32_t break_errors;      // 브레이크 검출
+    uint32_t parity_errors;     // 패리티 오류
+    uint32_t urc_dropped;       // URC 큐 가득 참/형식 오류로 버린 줄 또는 메시지
+    uint32_t max_isr_us;        // 가장 긴 UART/DMA RX 인터럽트 처리 시간
+    uint32_t max_irq_masked_us; // 가장 긴 인터럽트 금지 구간
+} UartLinkStats;
+
+typedef struct {
+    uint32_t count[UART_RTT_BUCKETS];
+    uint32_t samples;
+    uint64_t total_us;
+    uint32_t max_us;
+} UartRttHistogram;
+
+// 실측 처리량 (마지막 보드레이트 전환 이후 구간)
+typedef struct {
+    uint32_t baudrate;          // 실제 설정된 보드레이트
+    bool flow_control;          // RTS/CTS 사용 여부
+    uint32_t elapsed_ms;        // 측정 구간 길이
+    uint32_t rx_bytes;          // 구간 내 수신 바이트
+    uint32_t tx_bytes;          // 구간 내 송신 완료 바이트
+    uint32_t rx_bytes_per_sec;
+    uint32_t tx_bytes_per_sec;
+} UartThroughput;
+
+// TX 분산-수집 세그먼트 (AT 헤더, 페이로드, "\r\n"을 이어붙이지 않고 전송)
+typedef struct {
+    const void* data;
+    uint32_t len;
+} UartTxSegment;
+
+// TX 완료 콜백 (메인 루프 컨텍스트: DMA ISR이 기록해 두고 uart_link_poll에서 호출, 콜백 안에서 다시 제출 가능)
+typedef void (*UartTxCallback)(void* user);
+
+// 호출 대기 중인 TX 완료 콜백
+typedef struct {
+    UartTxCallback done;
+    void* user;
+} UartTxDone;
+
+// TX 큐 슬롯: 세그먼트 하나 = DMA 전송 하나, 요청의 마지막 세그먼트에만 완료 콜백이 붙음
+typedef struct {
+    const uint8_t* data;
+    uint32_t len;
+    uint32_t staging_release;  // 완료 시 반환할 스테이징 바이트 (복사 전송만)
+    UartTxCallback done;
+    void* user;
+} UartTxSlot;
+
+// URC 콜백 (메인 루프 컨텍스트, uart_link_poll/응답 대기 중 호출)
+// line은 줄 끝 "\r\n"을 뺀 문자열 (UART_URC_LINE_MAX - 1 바이트까지)
+typedef void (*UartUrcHandler)(const char* line, uint32_t len, void* user);
+
+// URC 등록 항목: prefix로 시작하는 줄은 명령 응답 스트림에서 빠짐
+typedef struct {
+    const char* prefix;
+    uint8_t prefix_len;
+    UartUrcHandler handler;   // NULL = 길이 기반 프레임으로 URC 큐에 저장 (uart_peek_mqtt_frame으로 읽음)
+    void* user;
+} UartUrcEntry;
+
+// 수신 MQTT 메시지 뷰 (URC 큐 안을 직접 가리킴, uart_release_mqtt_frame 전까지 유효)
+typedef struct {
+    const char* topic;        // NUL 종료
+    uint32_t topic_len;
+    const char* payload;      // NUL 종료 (바이너리 페이로드는 payload_len 기준, 중간 NUL/개행 가능)
+    uint32_t payload_len;
+} UartMqttFrame;
+
+// 스트리밍 구독 콜백 (메인 루프 컨텍스트, uart_link_poll 안에서 호출)
+// 페이로드는 URC 큐를 거치지 않고 RX 링에서 도착하는 대로 on_chunk로 전달 (크기 제한 없음)
+typedef struct {
+    void (*on_begin)(const char* topic, uint32_t total_len, void* user);
+    void (*on_chunk)(UartSpan chunk, void* user);            // chunk.data는 콜백 안에서만 유효
+    void (*on_end)(bool complete, void* user);                // false = 수신 중 손실 또는 링크 재초기화
+    void* user;
+} UartStreamHandler;
+
+// 투명 전송 수신 콜백 (메인 루프 컨텍스트, uart_link_poll 안에서 호출)
+// data는 RX 링 안의 연속 구간으로 콜백 안에서만 유효, 전달된 바이트는 모두 소비된 것으로 처리
+typedef void (*UartPassthroughHandler)(UartSpan data, void* user);
+
+// 스트리밍 구독 등록 항목 (토픽 완전 일치)
+typedef struct {
+    const char* topic;
+    UartStreamHandler handler;
+} UartStreamEntry;
+
+struct AtEngine;
+
+// UART 링크 컨텍스트: ESP-01 하나당 하나 (uart0/uart1 각각 독립 동작)
+// DMA 모드에서는 RX 링이 자기 크기에 정렬되므로 정적(전역) 객체로 두는 것을 권장
+typedef struct {
+    UartRxRing rx_ring;                   // 생산자: RX ISR 또는 DMA, 소비자: 메인 루프 (줄 분배기)
+    UartRespRing resp_ring;               // 명령 응답 줄 (매처가 검사)
+    UartUrcRing urc_ring;                 // 수신 MQTT 메시지 프레임 (+MQTTSUBRECV)
+    uart_inst_t* uart;
+    struct AtEngine* at;                  // 비차단 AT 엔진 (at_engine_init에서 연결)
+    uint32_t baudrate;                    // 실제 설정된 보드레이트
+    int cts_pin;                          // -1 = 흐름 제어 미사용
+    int rts_pin;
+
+    // RX DMA (UART_RX_USE_DMA)
+    int rx_dma_chan;
+    volatile uint32_t rx_dma_runs;        // 완료된 링 한 바퀴 횟수
+    volatile uint32_t rx_dma_last_total;  // 직전 깨어남 시점의 누적 수신 바이트
+    repeating_timer_t rx_watch_timer;     // DMA 쓰기 위치 감시 (FIFO와 무관한 수신 깨어남, 응답 대기 중에만 가동)
+    bool rx_watch_active;
+    uint8_t rx_waiters;                   // uart_wait_any로 응답을 기다리는 중인 호출 수
+    volatile UartRxStats rx_stats;        // ISR에서만 갱신
+
+    // RX 손실/오류 통계
+    volatile uint32_t rx_dropped;         // IRQ 모드: ISR, DMA 모드: 메인 루프(rx_sync)에서 갱신
+    volatile uint32_t rx_hwm;
+    volatile uint32_t err_overrun;        // UART 오류 인터럽트에서 갱신
+    volatile uint32_t err_framing;
+    volatile uint32_t err_break;
+    volatile uint32_t err_parity;
+    volatile uint32_t max_isr_us;
+    uint32_t max_irq_masked_us;
+
+    // URC 분배기 (메인 루프 전용)
+    UartUrcEntry urc_table[UART_URC_MAX_HANDLERS];
+    int urc_count;
+    uint32_t demux_scan;                  // 줄 끝을 찾은 rx_ring 누적 인덱스
+    uint32_t urc_dropped;
+    char urc_line[UART_URC_LINE_MAX];     // 콜백 전달용 연속 복사본
+
+    // +MQTTSUBRECV 길이 기반 프레이머 (메인 루프 전용)
+    bool frame_active;                    // 페이로드 수신 중 (줄 분배 중단)
+    bool frame_drop;                      // URC 큐 공간 부족 → 페이로드 버림
+    uint32_t frame_remaining;             // 아직 받지 못한 페이로드 바이트
+    uint32_t frame_pad;                   // 페이로드 뒤 NUL + 정렬 바이트
+    uint32_t frame_rx_dropped;            // 프레임 시작 시점 rx_dropped (수신 중 손실 감지)
+    const UartStreamHandler* frame_stream; // 현재 프레임을 받는 스트림 (NULL = URC 큐)
+    char frame_topic[UART_MQTT_TOPIC_MAX + 1];
+    UartStreamEntry stream_table[UART_STREAM_MAX_HANDLERS];
+    int stream_count;
+
+    // 투명 전송 (AT+CIPMODE=1): 설정되어 있으면 줄 분배/응답 매칭 없이 수신 바이트를 그대로 전달
+    UartPassthroughHandler passthrough;
+    void* passthrough_user;
+
+    // TX DMA 큐
+    int tx_dma_chan;
+    UartTxSlot tx_slots[UART_TX_QUEUE_LEN];
+    volatile uint32_t tx_slot_head;       // 제출 위치 (메인 루프)
+    volatile uint32_t tx_slot_tail;       // 완료 위치 (DMA ISR)
+    volatile bool tx_active;              // DMA 전송 진행 중
+    uint8_t tx_staging[UART_TX_STAGING_SIZE];
+    uint32_t tx_staging_head;             // 할당 위치 (메인 루프)
+    volatile uint32_t tx_staging_tail;    // 반환 위치 (DMA ISR)
+    volatile uint32_t tx_bytes;           // 송신 완료 누적 바이트 (DMA ISR)
+    UartTxDone tx_done[UART_TX_QUEUE_LEN]; // 완료된 요청의 콜백 (DMA ISR이 기록, uart_link_poll이 호출)
+    volatile uint32_t tx_done_head;       // 기록 위치 (DMA ISR)
+    uint32_t tx_done_tail;                // 호출 위치 (메인 루프)
+    uint32_t tx_done_reserved;            // 제출 후 아직 호출되지 않은 콜백 수 (tx_done 자리 예약)
+
+    // 처리량 측정 구간 시작점
+    uint64_t tp_start_us;
+    uint32_t tp_rx_base;
+    uint32_t tp_tx_base;
+
+    // AT 왕복 시간 통계
+    UartRttHistogram rtt_hist;
+    uint64_t rtt_cmd_sent_us;             // 마지막 AT 명령 제출 시각
+    bool rtt_pending;                     // 응답 일치 시 기록할 명령이 있는지
+} UartLink;
+
+// 증분 응답 매처: 링버퍼 안의 검사 위치와 토큰별 진행 상태를 폴링 사이에 유지
+typedef struct {
+    UartLink* link;
+    const char* tokens[UART_MATCH_MAX_TOKENS];
+    uint8_t token_len[UART_MATCH_MAX_TOKENS];
+    uint8_t progress[UART_MATCH_MAX_TOKENS];                          // 현재 일치한 접두사 길이
+    uint8_t fail[UART_MATCH_MAX_TOKENS][UART_MATCH_MAX_TOKEN_LEN];    // KMP 실패 함수
+    int count;
+    uint32_t scan_pos;                                                // 다음에 검사할 링 누적 인덱스
+} UartMatcher;
+
+// UART 초기화 (링크 컨텍스트에 UART 인스턴스 바인딩)
+void uart_init_esp01(UartLink& link, uart_inst_t* uart, unsigned int tx_pin, unsigned int rx_pin, unsigned int baudrate);
+
+// 보드레이트/흐름 제어 전환 (TX 완료 대기 후 인터럽트 금지 구간에서 한 번에 적용)
+// cts_pin/rts_pin: -1 = 미사용, 반환: 성공 여부
+bool uart_switch_baudrate(UartLink& link, unsigned int baudrate, int cts_pin, int rts_pin);
+
+// 수신 일시 정지: RTS를 GPIO로 잡아 비활성(high)으로 유지 → 모듈이 송신을 멈춤 (pause = false면 하드웨어 흐름 제어로 복귀)
+// RX DMA가 FIFO를 늘 비우므로 하드웨어 RTS는 스스로 비활성이 되지 않음 → 메인 루프가 오래 멈추는 구간(플래시 지우기) 앞뒤로 호출
+// 반환: RTS 핀이 없으면 false (멈추지 못함)
+bool uart_rx_pause(UartLink& link, bool pause);
+
+// UART 해제 (DMA/인터럽트 정지 - 시리얼 브릿지 등 직접 접근 전에 호출)
+void uart_deinit_esp01(UartLink& link);
+
+// AT 명령 전송 (비차단: 내부 버퍼로 복사 후 DMA 전송, 큐가 가득 차 있을 때만 공간이 날 때까지 짧게 대기)
+void uart_send_at_command(UartLink& link, const char* cmd);
+
+// URC 등록 (같은 prefix는 교체), handler NULL = URC 큐에 저장
+bool uart_register_urc(UartLink& link, const char* prefix, UartUrcHandler handler, void* user);
+
+// 수신 바이트를 줄 단위로 분배 (URC → 콜백/큐, 나머지 → 명령 응답)
+// 큐잉 URC는 헤더의 길이만큼 페이로드를 그대로 받음 (개행/랩 경계/부분 도착 무관)
+// 응답 대기 함수들이 내부에서 호출하며, 대기 중이 아닐 때는 메인 루프에서 주기적으로 호출
+void uart_link_poll(UartLink& link);
+
+// 응답 대기 (RX 라인 종료 이벤트로 깨어남, 그 외에는 코어 수면)
+bool uart_wait_response(UartLink& link, const char* expected, uint32_t timeout_ms);
+
+// RX 이벤트(IRQ 모드: 라인 종료, DMA 모드: 새 수신/링 한 바퀴) 또는 deadline까지 코어 수면 (최대 10 ms)
+void uart_wait_event(absolute_time_t deadline);
+
+// 여러 응답 중 먼저 도착한 것 대기 (예: OK/ERROR/FAIL)
+// 반환: 일치한 토큰 인덱스, 타임아웃 시 -1
+int uart_wait_any(UartLink& link, const char* const* tokens, int count, uint32_t timeout_ms);
+
+// 매처 초기화 (현재 읽기 위치부터 검사 시작)
+bool uart_matcher_init(UartLink& link, UartMatcher* matcher, const char* const* tokens, int count);
+
+// 새로 도착한 바이트만 검사, 일치 시 토큰 끝까지 소비하고 인덱스 반환 (없으면 -1)
+int uart_matcher_poll(UartMatcher* matcher);
+
+// 명령 응답 버퍼 내용 복사 (소비하지 않음), 반환: 복사한 길이
+int uart_get_rx_buffer(UartLink& link, char* buffer, int max_len);
+
+// 명령 응답 버퍼 클리어 (URC 큐는 유지)
+void uart_clear_rx_buffer(UartLink& link);
+
+// 원시 데이터 전송 (MQTT raw publish용, 비차단: 내부 버퍼로 복사 후 DMA 전송, 큐가 가득 차 있을 때만 짧게 대기)
+// 반환: 전부 큐에 넣었으면 true, 아니면 false (아무것도 보내지 않음 - 일부만 나가는 경우 없음)
+// 한 번에 최대 UART_TX_STAGING_SIZE 바이트, 공간이 200 ms 안에 나지 않으면 false
+bool uart_send_raw(UartLink& link, const char* data, int len);
+
+// 수신 바이트를 분배 없이 그대로 읽고 소비 (AT 에뮬레이터 등 모듈 쪽 링크용), 반환: 읽은 길이
+int uart_read_raw(UartLink& link, char* buffer, int max_len);
+
+// 세그먼트 목록을 복사 없이 DMA 큐에 제출 (대기하지 않음: 슬롯이 모자라면 false - 나중에 다시 제출)
+// 세그먼트 데이터는 done 콜백이 호출될 때까지 유지되어야 함, 인터럽트 컨텍스트에서는 호출 불가
+bool uart_tx_submit(UartLink& link, const UartTxSegment* segs, int count, UartTxCallback done, void* user);
+
+// len 바이트 복사 전송(세그먼트 segments개)이 대기 없이 큐에 들어가는지
+// uart_send_at_command/uart_send_raw는 공간이 날 때까지 짧게 대기하므로, 대기하면 안 되는 호출자가 먼저 확인 (원시 전송은 uart_tx_raw_room)
+bool uart_tx_room(UartLink& link, uint32_t len, int segments);
+
+// uart_send_raw sends회(합계 len 바이트)가 대기 없이 큐에 들어가는지
+// 여러 조각을 나눠 보내되 일부만 나가면 안 되는 호출자가 먼저 확인 (예: 발행 헤더 + 페이로드)
+bool uart_tx_raw_room(UartLink& link, uint32_t len, int sends);
+
+// TX 큐에 전송 대기/진행 중인 데이터가 있는지
+bool uart_tx_busy(UartLink& link);
+
+// TX 큐가 모두 송신될 때까지 대기 (타임아웃 시 false)
+bool uart_tx_wait_idle(UartLink& link, uint32_t timeout_ms);
+
+// 스트리밍 구독 등록 (같은 토픽은 교체, handler NULL = 해제)
+// 등록된 토픽의 메시지는 URC 큐 대신 on_begin/on_chunk/on_end로 전달
+bool uart_register_stream(UartLink& link, const char* topic, const UartStreamHandler* handler);
+
+// 투명 전송 수신 핸들러 설정 (NULL = 해제 후 줄 단위 분배로 복귀)
+// 설정 중에는 AT 엔진이 새 명령을 보내지 않음
+void uart_set_passthrough(UartLink& link, UartPassthroughHandler handler, void* user);
+
+// 링크 밖에서 해석한 MQTT 메시지를 +MQTTSUBRECV와 같은 경로(스트림 또는 URC 큐)로 전달
+// frame_begin으로 시작한 뒤 payload_len 바이트를 frame_data로 나누어 넣으면 마무리됨
+// frame_data 반환: 받아들인 바이트 수 (프레임 남은 길이까지)
+bool uart_mqtt_frame_begin(UartLink& link, const char* topic, uint32_t topic_len, uint32_t payload_len);
+uint32_t uart_mqtt_frame_data(UartLink& link, const char* data, uint32_t len);
+
+// 수신 MQTT 메시지 하나를 복사 없이 조회 (완성된 메시지가 없으면 false)
+// 같은 메시지를 다시 보려면 재호출, 다 쓴 뒤 uart_release_mqtt_frame으로 반환
+bool uart_peek_mqtt_frame(UartLink& link, UartMqttFrame* frame);
 
-// AT 명령 전송
-void uart_send_at_command(const char* cmd);
+// uart_peek_mqtt_frame으로 조회한 메시지 반환 (URC 큐 공간 해제)
+void uart_release_mqtt_frame(UartLink& link);
 
-// 응답 대기
-bool uart_wait_response(const char* expected, uint32_t timeout_ms);
+// RX 깨어남 통계 읽기
+void uart_get_rx_stats(UartLink& link, UartRxStats* stats);
 
-// 수신 버퍼 읽기
-const char* uart_get_rx_buffer(void);
+// 링크 상태 통계 읽기/초기화
+void uart_get_link_stats(UartLink& link, UartLinkStats* stats);
+void uart_reset_link_stats(UartLink& link);
 
-// 수신 버퍼 클리어
-void uart_clear_rx_buffer(void);
+// 링크 상태 통계를 JSON 문자열로 작성 (주기 발행용), 반환: 작성 길이 (실패 시 -1)
+int uart_format_link_stats(UartLink& link, char* buffer, int max_len);
 
-// 원시 데이터 전송 (MQTT raw publish용)
-void uart_send_raw(const char* data, int len);
+// 실측 처리량 읽기
+void uart_get_throughput(UartLink& link, UartThroughput* tp);
 
-// MQTT 메시지 읽기
-int uart_read_mqtt_message(char* buffer, int max_len);
+// AT 왕복 시간 히스토그램 읽기/초기화/출력
+void uart_get_rtt_histogram(UartLink& link, UartRttHistogram* hist);
+void uart_reset_rtt_histogram(UartLink& link);
+void uart_print_rtt_histogram(UartLink& link);
 
 #ifdef __cplusplus
 }
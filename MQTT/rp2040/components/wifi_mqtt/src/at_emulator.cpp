@@ -0,0 +1,107 @@
+#include "at_emulator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#define PUBRAW_CMD "AT+MQTTPUBRAW="
+
+// 응답 송신 예약 (지연 0이면 즉시 송신)
+static void emu_reply(AtEmulator& emu, const char* text) {
+    // 앞선 응답이 아직 남아 있으면 순서 유지를 위해 먼저 송신
+    if (emu.reply_len > 0) {
+        uart_send_raw(*emu.link, emu.reply, (int)emu.reply_len);
+        emu.reply_len = 0;
+    }
+
+    size_t len = strlen(text);
+    if (emu.ack_delay_us == 0) {
+        uart_send_raw(*emu.link, text, (int)len);
+        return;
+    }
+
+    memcpy(emu.reply, text, len);
+    emu.reply_len = (uint32_t)len;
+    emu.reply_at = make_timeout_time_us(emu.ack_delay_us);
+}
+
+// "AT+MQTTPUBRAW=<id>,\"<topic>\",<len>,<qos>,<retain>"에서 <len> 추출 (실패 시 0)
+static uint32_t pubraw_length(const char* line) {
+    const char* quote = strrchr(line, '"');
+    if (!quote || quote[1] != ',') {
+        return 0;
+    }
+    return (uint32_t)strtoul(quote + 2, NULL, 10);
+}
+
+// 완성된 명령 줄 처리
+static void emu_command(AtEmulator& emu) {
+    emu.line[emu.line_len] = '\0';
+    emu.commands++;
+
+    if (strncmp(emu.line, PUBRAW_CMD, strlen(PUBRAW_CMD)) == 0) {
+        uint32_t len = pubraw_length(emu.line);
+        if (len == 0) {
+            emu_reply(emu, "\r\nERROR\r\n");
+            return;
+        }
+        emu.payload_remaining = len;
+        emu_reply(emu, "OK\r\n\r\n>");
+        return;
+    }
+
+    emu_reply(emu, "\r\nOK\r\n");
+}
+
+void at_emu_init(AtEmulator& emu, UartLink& link, uint32_t ack_delay_us) {
+    memset(&emu, 0, sizeof(emu));
+    emu.link = &link;
+    emu.ack_delay_us = ack_delay_us;
+}
+
+void at_emu_poll(AtEmulator& emu) {
+    if (!emu.link) {
+        return;
+    }
+
+    if (emu.reply_len > 0 && time_reached(emu.reply_at)) {
+        uart_send_raw(*emu.link, emu.reply, (int)emu.reply_len);
+        emu.reply_len = 0;
+    }
+
+    char buf[64];
+    int n;
+    while ((n = uart_read_raw(*emu.link, buf, (int)sizeof(buf))) > 0) {
+        for (int i = 0; i < n; i++) {
+            // 페이로드 단계: 길이만큼 버린 뒤 발행 결과 응답
+            if (emu.payload_remaining > 0) {
+                if (--emu.payload_remaining == 0) {
+                    emu.publishes++;
+                    emu_reply(emu, "\r\n+MQTTPUB:OK\r\n");
+                }
+                continue;
+            }
+
+            char c = buf[i];
+            if (c == '\n') {
+                continue;
+            }
+            if (c == '\r') {
+                if (emu.line_len == AT_EMU_LINE_MAX) {
+                    emu_reply(emu, "\r\nERROR\r\n");  // 길이 초과 명령
+                } else if (emu.line_len > 0) {
+                    emu_command(emu);
+                }
+                emu.line_len = 0;
+                continue;
+            }
+            if (emu.line_len < AT_EMU_LINE_MAX - 1) {
+                emu.line[emu.line_len++] = c;
+            } else if (emu.line_len == AT_EMU_LINE_MAX - 1) {
+                // 줄 끝까지 버리고 한 번만 집계
+                emu.overflows++;
+                emu.line_len = AT_EMU_LINE_MAX;
+            }
+        }
+    }
+}
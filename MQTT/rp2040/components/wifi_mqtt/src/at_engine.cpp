@@ -0,0 +1,287 @@
+#include "at_engine.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+// 프롬프트 단계 토큰
+static const char* const PROMPT_RESULT[] = { ">", "ERROR" };
+
+// 차단 래퍼용 완료 상태
+typedef struct {
+    volatile bool done;
+    volatile int result;
+} AtBlockingWait;
+
+static void on_blocking_done(int result, void* user) {
+    AtBlockingWait* wait = (AtBlockingWait*)user;
+    wait->result = result;
+    wait->done = true;
+}
+
+// 현재 명령 완료 처리: 큐에서 꺼내고 콜백 호출
+static void at_complete(AtEngine& engine, int result) {
+    AtSlot& slot = engine.queue[engine.tail % AT_QUEUE_LEN];
+    AtCallback done = slot.req.done;
+    void* user = slot.req.user;
+    bool chain = slot.req.chain;
+
+    engine.tail++;
+    engine.state = AT_STATE_IDLE;
+    engine.last_done = get_absolute_time();
+
+    // 연쇄 명령이 실패하면 마지막(chain=false) 명령까지 취소
+    if (chain) {
+        engine.aborting = (result != 0);
+    } else {
+        engine.aborting = false;
+    }
+
+    if (done) {
+        done(result, user);
+    }
+}
+
+// 현재 명령 전송 (응답 버퍼를 비운 뒤 전송, URC는 분배기가 보존)
+static void at_start(AtEngine& engine) {
+    AtSlot& slot = engine.queue[engine.tail % AT_QUEUE_LEN];
+    UartLink& link = *engine.link;
+
+    uart_clear_rx_buffer(link);
+    uart_send_at_command(link, slot.req.cmd);
+
+    if (slot.req.payload_len > 0) {
+        uart_matcher_init(link, &engine.matcher, PROMPT_RESULT, 2);
+        engine.state = AT_STATE_WAIT_PROMPT;
+    } else {
+        uart_matcher_init(link, &engine.matcher, slot.req.tokens, slot.req.token_count);
+        engine.state = AT_STATE_WAIT_RESULT;
+    }
+    engine.deadline = make_timeout_time_ms(slot.req.timeout_ms);
+}
+
+// 페이로드를 TX 큐 여유만큼 조각으로 넣음 (조각은 전부 들어가거나 하나도 안 들어감), 반환: 모두 넣었는지
+// 조각을 넣을 때마다 제한 시간을 다시 잡으므로 TX가 멈춘 경우에만 시간 초과
+static bool at_send_payload(AtEngine& engine, const AtSlot& slot) {
+    const char* data = (const char*)slot.req.payload;
+    while (engine.payload_sent < slot.req.payload_len) {
+        uint32_t piece = slot.req.payload_len - engine.payload_sent;
+        if (piece > UART_TX_STAGING_CHUNK) {
+            piece = UART_TX_STAGING_CHUNK;
+        }
+        if (!uart_tx_raw_room(*engine.link, piece, 1) ||
+            !uart_send_raw(*engine.link, data + engine.payload_sent, (int)piece)) {
+            return false;
+        }
+        engine.payload_sent += piece;
+        engine.deadline = make_timeout_time_ms(slot.req.timeout_ms);
+    }
+    return true;
+}
+
+void at_engine_init(AtEngine& engine, UartLink& link) {
+    memset(&engine, 0, sizeof(engine));
+    engine.link = &link;
+    engine.state = AT_STATE_IDLE;
+    engine.last_done = get_absolute_time();
+    link.at = &engine;
+}
+
+bool at_submit(AtEngine& engine, const AtRequest& req) {
+    if (!engine.link) {
+        printf("[AT] 엔진 초기화되지 않음\n");
+        return false;
+    }
+
+    // NULL 포인터 및 토큰 검증
+    if (!req.cmd || !req.tokens || req.token_count <= 0 || req.token_count > UART_MATCH_MAX_TOKENS) {
+        printf("[AT] 유효하지 않은 요청\n");
+        return false;
+    }
+
+    if (req.payload_len > 0 && !req.payload) {
+        printf("[AT] 유효하지 않은 페이로드\n");
+        return false;
+    }
+
+    // 복사할 때만 슬롯 크기 제한
+    size_t cmd_len = strlen(req.cmd);
+    if (!req.borrow && cmd_len >= AT_CMD_MAX_LEN) {
+        printf("[AT] 명령어 길이 초과: %u\n", (unsigned)cmd_len);
+        return false;
+    }
+    if (!req.borrow && req.payload_len > AT_PAYLOAD_MAX) {
+        printf("[AT] 페이로드 길이 초과: %u > %d\n", (unsigned)req.payload_len, AT_PAYLOAD_MAX);
+        return false;
+    }
+
+    if (engine.head - engine.tail >= AT_QUEUE_LEN) {
+        printf("[AT] 명령 큐 가득 참: %.*s\n", 32, req.cmd);
+        return false;
+    }
+
+    // 호출 측 버퍼 수명과 무관하도록 명령/페이로드 복사 (borrow면 완료까지 호출 측이 버퍼 유지)
+    AtSlot& slot = engine.queue[engine.head % AT_QUEUE_LEN];
+    slot.req = req;
+    if (!req.borrow) {
+        memcpy(slot.cmd, req.cmd, cmd_len + 1);
+        if (req.payload_len > 0) {
+            memcpy(slot.payload, req.payload, req.payload_len);
+        }
+        slot.req.cmd = slot.cmd;
+        slot.req.payload = slot.payload;
+    }
+    engine.head++;
+    return true;
+}
+
+void at_engine_poll(AtEngine& engine) {
+    if (!engine.link || engine.in_poll) {
+        return;
+    }
+    engine.in_poll = true;
+
+    // 대기 명령이 없어도 URC는 분배
+    uart_link_poll(*engine.link);
+
+    while (engine.tail != engine.head) {
+        AtSlot& slot = engine.queue[engine.tail % AT_QUEUE_LEN];
+
+        if (engine.state == AT_STATE_IDLE) {
+            // 앞선 연쇄 명령 실패 → 전송하지 않고 취소
+            if (engine.aborting) {
+                at_complete(engine, AT_RESULT_ABORTED);
+                continue;
+            }
+            engine.deadline = delayed_by_ms(engine.last_done, slot.req.delay_ms);
+            engine.state = AT_STATE_DELAY;
+        }
+
+        if (engine.state == AT_STATE_DELAY) {
+            // 투명 전송 중에는 보낸 명령이 데이터로 전달되므로 종료될 때까지 대기
+            if (!time_reached(engine.deadline) || engine.link->passthrough) {
+                break;
+            }
+            // TX 큐에 명령("\r\n" 포함 세그먼트 2개)이 바로 들어갈 자리가 없으면 다음 poll에서 시도 (메인 루프 차단 방지)
+            // TX가 응답 제한 시간 넘게 멈춰 있으면 그대로 시작 → 전송 실패는 응답 시간 초과로 끝남
+            if (!uart_tx_room(*engine.link, strlen(slot.req.cmd), 2) &&
+                !time_reached(delayed_by_ms(engine.deadline, slot.req.timeout_ms))) {
+                break;
+            }
+            at_start(engine);
+        }
+
+        if (engine.state == AT_STATE_SEND_PAYLOAD) {
+            if (!at_send_payload(engine, slot)) {
+                if (!time_reached(engine.deadline)) {
+                    break;  // TX 큐 여유 대기 - 다음 poll에서 이어서 넣음
+                }
+                // 모듈은 남은 페이로드를 기다리는 중 → 호출 측은 응답 없음(연결 끊김)으로 처리
+                printf("[AT] 페이로드 전송 시간 초과 (%u/%u 바이트): %.*s\n",
+                       (unsigned)engine.payload_sent, (unsigned)slot.req.payload_len, 32, slot.req.cmd);
+                at_complete(engine, AT_RESULT_TIMEOUT);
+                continue;
+            }
+            uart_matcher_init(*engine.link, &engine.matcher, slot.req.tokens, slot.req.token_count);
+            engine.state = AT_STATE_WAIT_RESULT;
+            engine.deadline = make_timeout_time_ms(slot.req.timeout_ms);
+        }
+
+        int hit = uart_matcher_poll(&engine.matcher);
+        if (hit < 0) {
+            if (!time_reached(engine.deadline)) {
+                break;  // 응답 대기 중 - 다음 poll에서 이어서 검사
+            }
+            printf("[AT] 응답 시간 초과: %.*s\n", 32, slot.req.cmd);
+            at_complete(engine, AT_RESULT_TIMEOUT);
+            continue;
+        }
+
+        if (engine.state == AT_STATE_WAIT_PROMPT) {
+            if (hit != 0) {
+                at_complete(engine, AT_RESULT_PROMPT_FAIL);
+                continue;
+            }
+            // 프롬프트 수신 → 페이로드 전송 후 결과 대기
+            // '>' 앞의 "OK"가 결과 토큰으로 다시 일치하지 않도록 응답 버퍼를 비움
+            uart_clear_rx_buffer(*engine.link);
+            engine.payload_sent = 0;
+            engine.state = AT_STATE_SEND_PAYLOAD;
+            engine.deadline = make_timeout_time_ms(slot.req.timeout_ms);
+            continue;
+        }
+
+        at_complete(engine, hit);
+    }
+
+    engine.in_poll = false;
+}
+
+bool at_engine_busy(AtEngine& engine) {
+    return engine.tail != engine.head;
+}
+
+uint32_t at_engine_pending(AtEngine& engine) {
+    return engine.head - engine.tail;
+}
+
+void at_engine_flush(AtEngine& engine) {
+    while (engine.tail != engine.head) {
+        AtSlot& slot = engine.queue[engine.tail % AT_QUEUE_LEN];
+        AtCallback done = slot.req.done;
+        void* user = slot.req.user;
+        engine.tail++;
+        if (done) {
+            done(AT_RESULT_ABORTED, user);
+        }
+    }
+    engine.state = AT_STATE_IDLE;
+    engine.aborting = false;
+}
+
+int at_execute(AtEngine& engine, const AtRequest& req) {
+    // 콜백 안에서 호출하면 엔진이 진행되지 않아 영원히 대기하게 됨
+    if (engine.in_poll) {
+        printf("[AT] 오류: 완료 콜백 안에서 차단 호출\n");
+        return AT_RESULT_ABORTED;
+    }
+
+    AtBlockingWait wait = { false, AT_RESULT_PENDING };
+    AtRequest blocking = req;
+    blocking.chain = false;
+    blocking.borrow = true;  // 완료될 때까지 여기서 기다리므로 호출 측 버퍼가 유지됨
+    blocking.done = on_blocking_done;
+    blocking.user = &wait;
+
+    // 큐가 가득 차 있으면 (발신 큐/QoS 1 제출 등) 앞선 명령이 끝나 자리가 날 때까지 엔진을 돌림
+    // 요청의 응답 제한 시간 안에 자리가 나지 않으면 시간 초과
+    absolute_time_t give_up = make_timeout_time_ms(req.timeout_ms);
+    while (at_engine_pending(engine) >= AT_QUEUE_LEN) {
+        if (time_reached(give_up)) {
+            printf("[AT] 명령 큐 자리 대기 시간 초과\n");
+            return AT_RESULT_TIMEOUT;
+        }
+        at_engine_poll(engine);
+        uart_wait_event(give_up);
+    }
+    if (!at_submit(engine, blocking)) {
+        return AT_RESULT_ABORTED;
+    }
+
+    while (true) {
+        at_engine_poll(engine);
+        if (wait.done) {
+            return wait.result;
+        }
+        // 다음 이벤트까지 수면 (전송 지연 중이면 그 시각까지)
+        uart_wait_event(engine.deadline);
+    }
+}
+
+int at_command(AtEngine& engine, const char* cmd, const char* const* tokens, int count, uint32_t timeout_ms) {
+    AtRequest req = {};
+    req.cmd = cmd;
+    req.tokens = tokens;
+    req.token_count = count;
+    req.timeout_ms = timeout_ms;
+    return at_execute(engine, req);
+}
@@ -0,0 +1,168 @@
+#include "boot_seq.h"
+#include <stdio.h>
+
+// 단계 종료 기록
+static void stage_finish(BootSeq& seq, BootStage& stage, BootStageState state, uint32_t now) {
+    stage.state = state;
+    stage.end_ms = now;
+    seq.finished++;
+    if (state == BOOT_STAGE_SKIPPED) {
+        printf("[BOOT] %s 건너뜀 (의존 단계 실패)\n", stage.name);
+    } else {
+        printf("[BOOT] %s %s: %lu ms\n", stage.name, state == BOOT_STAGE_DONE ? "완료" : "실패",
+               (unsigned long)(now - stage.start_ms));
+    }
+}
+
+// 단계 결과 반영 (PENDING이면 계속 진행 중)
+static void stage_apply(BootSeq& seq, BootStage& stage, BootStepResult result, uint32_t now) {
+    if (result == BOOT_STEP_DONE) {
+        stage_finish(seq, stage, BOOT_STAGE_DONE, now);
+    } else if (result == BOOT_STEP_FAILED) {
+        stage_finish(seq, stage, BOOT_STAGE_FAILED, now);
+    }
+}
+
+// 의존 단계 확인, 반환: DONE = 모두 완료, FAILED = 하나라도 실패/건너뜀, PENDING = 대기
+static BootStepResult deps_state(const BootSeq& seq, uint32_t deps) {
+    BootStepResult result = BOOT_STEP_DONE;
+    for (uint8_t i = 0; i < seq.count; i++) {
+        if (!(deps & BOOT_DEP(i))) {
+            continue;
+        }
+        BootStageState s = seq.stages[i].state;
+        if (s == BOOT_STAGE_FAILED || s == BOOT_STAGE_SKIPPED) {
+            return BOOT_STEP_FAILED;
+        }
+        if (s != BOOT_STAGE_DONE) {
+            result = BOOT_STEP_PENDING;
+        }
+    }
+    return result;
+}
+
+void boot_seq_init(BootSeq& seq) {
+    seq = BootSeq();
+}
+
+int boot_seq_add(BootSeq& seq, const char* name, BootStartFn start, BootPollFn poll, void* user, uint32_t deps) {
+    if (seq.count >= BOOT_SEQ_MAX_STAGES) {
+        printf("[BOOT] 오류: 단계 수 초과 (%s)\n", name);
+        return -1;
+    }
+    // 뒤에 등록될 단계에 의존하면 순환 가능성이 있으므로 거부 (등록 순서 = 위상 순서)
+    if (deps >> seq.count) {
+        printf("[BOOT] 오류: %s가 아직 등록되지 않은 단계에 의존\n", name);
+        return -1;
+    }
+    BootStage& stage = seq.stages[seq.count];
+    stage = BootStage();
+    stage.name = name;
+    stage.start = start;
+    stage.poll = poll;
+    stage.user = user;
+    stage.deps = deps;
+    stage.state = BOOT_STAGE_WAITING;
+    return seq.count++;
+}
+
+bool boot_seq_poll(BootSeq& seq, uint32_t now) {
+    if (!seq.started) {
+        seq.started = true;
+        seq.start_ms = now;
+    }
+
+    // 등록 순서대로 한 번 훑으면 앞 단계가 끝난 같은 poll 안에서 뒤 단계도 시작됨
+    for (uint8_t i = 0; i < seq.count; i++) {
+        BootStage& stage = seq.stages[i];
+        if (stage.state == BOOT_STAGE_WAITING) {
+            BootStepResult deps = deps_state(seq, stage.deps);
+            if (deps == BOOT_STEP_PENDING) {
+                continue;
+            }
+            stage.start_ms = now;
+            if (deps == BOOT_STEP_FAILED) {
+                stage_finish(seq, stage, BOOT_STAGE_SKIPPED, now);
+                continue;
+            }
+            stage.state = BOOT_STAGE_RUNNING;
+            BootStepResult result = stage.start ? stage.start(stage.user, now) : BOOT_STEP_DONE;
+            if (result == BOOT_STEP_PENDING && !stage.poll) {
+                result = BOOT_STEP_DONE;
+            }
+            stage_apply(seq, stage, result, now);
+        } else if (stage.state == BOOT_STAGE_RUNNING) {
+            stage_apply(seq, stage, stage.poll(stage.user, now), now);
+        }
+    }
+
+    if (boot_seq_finished(seq) && seq.end_ms == 0) {
+        seq.end_ms = now;
+    }
+    return boot_seq_finished(seq);
+}
+
+bool boot_seq_finished(const BootSeq& seq) {
+    return seq.finished == seq.count;
+}
+
+BootStageState boot_seq_state(const BootSeq& seq, int index) {
+    if (index < 0 || index >= seq.count) {
+        return BOOT_STAGE_SKIPPED;
+    }
+    return seq.stages[index].state;
+}
+
+const char* boot_seq_state_name(BootStageState state) {
+    switch (state) {
+    case BOOT_STAGE_WAITING: return "waiting";
+    case BOOT_STAGE_RUNNING: return "running";
+    case BOOT_STAGE_DONE:    return "done";
+    case BOOT_STAGE_FAILED:  return "failed";
+    case BOOT_STAGE_SKIPPED: return "skipped";
+    }
+    return "?";
+}
+
+void boot_seq_report(const BootSeq& seq) {
+    printf("\n=== 부팅 단계 시간 (부팅 후 ms) ===\n");
+    for (uint8_t i = 0; i < seq.count; i++) {
+        const BootStage& stage = seq.stages[i];
+        bool ended = stage.state != BOOT_STAGE_WAITING && stage.state != BOOT_STAGE_RUNNING;
+        printf("  %-16s %6lu → %6lu (%5lu ms) %s\n", stage.name,
+               (unsigned long)stage.start_ms, (unsigned long)stage.end_ms,
+               (unsigned long)(ended ? stage.end_ms - stage.start_ms : 0), boot_seq_state_name(stage.state));
+    }
+    printf("  전체: %lu ms (부팅 후 %lu ms에 종료)\n",
+           (unsigned long)(seq.end_ms - seq.start_ms), (unsigned long)seq.end_ms);
+}
+
+int boot_seq_format_stats(const BootSeq& seq, char* buffer, int max_len) {
+    // NULL 포인터 및 길이 검증
+    if (!buffer || max_len <= 0) {
+        return -1;
+    }
+
+    // 발행 한도(AT_PAYLOAD_MAX) 안에 들도록 단계마다 [시작(조정기 기준), 소요] 배열, 완료가 아니면 상태 추가
+    int written = snprintf(buffer, max_len, "{\"total_ms\":%lu,\"end_ms\":%lu",
+                           (unsigned long)(seq.end_ms - seq.start_ms), (unsigned long)seq.end_ms);
+    for (uint8_t i = 0; i < seq.count && written >= 0 && written < max_len; i++) {
+        const BootStage& stage = seq.stages[i];
+        written += snprintf(buffer + written, max_len - written, ",\"%s\":[%lu,%lu", stage.name,
+                            (unsigned long)(stage.start_ms - seq.start_ms),
+                            (unsigned long)(stage.end_ms - stage.start_ms));
+        if (written >= 0 && written < max_len) {
+            written += stage.state == BOOT_STAGE_DONE
+                ? snprintf(buffer + written, max_len - written, "]")
+                : snprintf(buffer + written, max_len - written, ",\"%s\"]", boot_seq_state_name(stage.state));
+        }
+    }
+    if (written >= 0 && written < max_len) {
+        written += snprintf(buffer + written, max_len - written, "}");
+    }
+    if (written < 0 || written >= max_len) {
+        printf("[BOOT] 통계 JSON 버퍼 부족\n");
+        return -1;
+    }
+    return written;
+}
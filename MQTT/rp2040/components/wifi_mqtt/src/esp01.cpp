@@ -1,138 +1,576 @@
 #include "esp01.h"
 #include "uart_comm.h"
+#include "at_engine.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/watchdog.h"
 
-void esp01_module_init(Esp01Module& module) {
+// 명령 결과 토큰 (AT 엔진 결과 인덱스)
+static const char* const AT_RESULT[] = { "OK", "ERROR" };
+// "WIFI GOT IP"는 URC로 분리되므로 CWJAP 결과는 OK/FAIL로 판정
+static const char* const JOIN_RESULT[] = { "OK", "FAIL", "ERROR" };
+// STATUS:2 = Got IP, STATUS:3 = Connected, STATUS:4 = Connecting, 그 외에는 OK로 종료
+static const char* const CIPSTATUS_RESULT[] = { "STATUS:2", "STATUS:3", "STATUS:4", "OK", "ERROR" };
+
+// 접속 전 준비 명령 최대 수 (SYSSTORE, CWAUTOCONN, CIPSTA 또는 CWDHCP)
+#define ESP01_PREPARE_MAX 3
+
+// WiFi 상태 URC (명령 응답과 분리되어 메인 루프에서 호출)
+static void on_wifi_disconnect(const char* line, uint32_t len, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    module.wifi_connected = false;
+    printf("[ESP-01] URC: WiFi 연결 끊김\n");
+}
+
+static void on_wifi_got_ip(const char* line, uint32_t len, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    module.wifi_connected = true;
+    printf("[ESP-01] URC: IP 획득\n");
+}
+
+// 따옴표로 감싼 값 복사 ("value" → value), 형식 오류/길이 초과 시 false
+static bool copy_quoted(const char* src, char* dst, size_t size) {
+    if (*src != '"') {
+        return false;
+    }
+    const char* end = strchr(src + 1, '"');
+    if (!end || (size_t)(end - src - 1) >= size) {
+        return false;
+    }
+    memcpy(dst, src + 1, end - src - 1);
+    dst[end - src - 1] = '\0';
+    return true;
+}
+
+// +CWJAP:"<ssid>","<bssid>",<channel>,<rssi>,... (AT+CWJAP? 응답) 또는 +CWJAP:<오류 코드> (접속 실패)
+static void on_cwjap_info(const char* line, uint32_t len, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    const char* p = line + 7;
+    if (*p != '"') {
+        // 1 = 시간 초과, 2 = 비밀번호 오류, 3 = AP 없음, 4 = 접속 실패
+        printf("[ESP-01] 접속 실패 코드: %s\n", p);
+        return;
+    }
+    const char* bssid = strstr(p + 1, "\",\"");
+    if (!bssid || !copy_quoted(bssid + 2, module.join_cache.bssid, sizeof(module.join_cache.bssid))) {
+        return;
+    }
+    const char* channel = strchr(bssid + 3, '"');
+    module.join_cache.channel = (channel && channel[1] == ',') ? (uint8_t)atoi(channel + 2) : 0;
+}
+
+// +CIPSTA:ip:"<ip>" / +CIPSTA:gateway:"<gw>" / +CIPSTA:netmask:"<mask>" (AT+CIPSTA? 응답)
+static void on_cipsta_info(const char* line, uint32_t len, void* user) {
+    Esp01JoinCache& cache = ((Esp01Module*)user)->join_cache;
+    const char* p = line + 8;
+    if (strncmp(p, "ip:", 3) == 0) {
+        copy_quoted(p + 3, cache.ip, sizeof(cache.ip));
+    } else if (strncmp(p, "gateway:", 8) == 0) {
+        copy_quoted(p + 8, cache.gateway, sizeof(cache.gateway));
+    } else if (strncmp(p, "netmask:", 8) == 0) {
+        copy_quoted(p + 8, cache.netmask, sizeof(cache.netmask));
+    }
+}
+
+static inline uint32_t esp01_now_ms() {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+// 부팅 완료 기록 (리셋 해제 → 응답 가능 시간)
+static void esp01_mark_ready(Esp01Module& module, const char* how) {
+    module.ready = true;
+    module.ready_ms = esp01_now_ms() - module.reset_ms;
+    printf("[ESP-01] 부팅 완료 (%s): 리셋 후 %lu ms\n", how, (unsigned long)module.ready_ms);
+}
+
+// "ready" 배너 (부팅 완료), 리셋하지 않았는데 오면 모듈이 스스로 재부팅한 것
+// (자체 재부팅은 부팅 기본 보드레이트로 돌아오므로 같은 속도로 통신 중일 때만 감지됨)
+static void on_ready(const char* line, uint32_t len, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    if (!module.ready) {
+        esp01_mark_ready(module, "배너");
+        return;
+    }
+    module.wifi_connected = false;
+    module.rebooted = true;
+    module.join_cache.sysstore_off = false;
+    module.reset_ms = esp01_now_ms();
+    module.ready_ms = 0;
+    printf("[ESP-01] URC: 모듈 재부팅 감지 (WiFi 연결/에코 설정 초기화됨)\n");
+}
+
+// 부팅 확인용 AT 응답
+static void on_ready_probe(int result, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    if (result == 0 && !module.ready) {
+        esp01_mark_ready(module, "AT 응답");
+    }
+}
+
+// 링크에 연결된 AT 엔진 (없으면 NULL)
+static AtEngine* esp01_engine(Esp01Module& module) {
+    if (!module.link || !module.uart || !module.link->at) {
+        printf("[ESP-01] 오류: UART 링크 또는 AT 엔진 없음\n");
+        return NULL;
+    }
+    return module.link->at;
+}
+
+// AT 응답 확인 (보드레이트 전환 검증용 짧은 타임아웃)
+static bool esp01_probe(AtEngine& at, int tries) {
+    for (int i = 0; i < tries; i++) {
+        if (at_command(at, "AT", AT_RESULT, 2, 500) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// AT+CWJAP 명령 생성 (SSID/비밀번호 검증 포함), bssid != NULL이면 해당 AP로만 접속
+static bool esp01_build_join_cmd(Esp01Module& module, char* cmd, size_t cmd_size, const char* bssid) {
+    if (!module.ssid[0]) {
+        printf("[ESP-01] 오류: SSID가 비어있음\n");
+        return false;
+    }
+    
+    // SSID/비밀번호 길이 검증 (AT 명령어 오버헤드 고려)
+    size_t ssid_len = strlen(module.ssid);
+    size_t pass_len = strlen(module.password);
+    if (ssid_len > 32 || pass_len > 63) {
+        printf("[ESP-01] 오류: SSID/비밀번호 길이 초과\n");
+        return false;
+    }
+    
+    // 특수문자 검증 (" 문자 금지)
+    if (strchr(module.ssid, '"') || strchr(module.password, '"')) {
+        printf("[ESP-01] 오류: SSID/비밀번호에 \" 문자 포함 불가\n");
+        return false;
+    }
+    
+    int written = bssid
+        ? snprintf(cmd, cmd_size, "AT+CWJAP=\"%s\",\"%s\",\"%s\"", module.ssid, module.password, bssid)
+        : snprintf(cmd, cmd_size, "AT+CWJAP=\"%s\",\"%s\"", module.ssid, module.password);
+    if (written < 0 || written >= (int)cmd_size) {
+        printf("[ESP-01] 오류: 명령어 생성 실패\n");
+        return false;
+    }
+    return true;
+}
+
+// ===== 빠른 재접속 =====
+
+static void esp01_learn_reset(Esp01JoinCache& cache) {
+    cache.valid = false;
+    cache.bssid[0] = '\0';
+    cache.channel = 0;
+    cache.ip[0] = '\0';
+    cache.gateway[0] = '\0';
+    cache.netmask[0] = '\0';
+}
+
+// 접속 정보 확인 결과 반영 (BSSID/IP/게이트웨이/넷마스크가 모두 있어야 사용)
+static void esp01_learn_finish(Esp01Module& module, bool ok) {
+    Esp01JoinCache& cache = module.join_cache;
+    cache.valid = ok && cache.bssid[0] && cache.ip[0] && cache.gateway[0] && cache.netmask[0] &&
+                  strcmp(cache.ip, "0.0.0.0") != 0;
+    if (cache.valid) {
+        printf("[ESP-01] 접속 정보 저장: BSSID %s (채널 %u), IP %s\n",
+               cache.bssid, cache.channel, cache.ip);
+    }
+}
+
+static void on_learn_done(int result, void* user) {
+    esp01_learn_finish(*(Esp01Module*)user, result == 0);
+}
+
+// AT+CWAUTOCONN=0 완료 (OK일 때만 기록, 실패/취소면 다음 접속에서 다시 보냄)
+static void on_autoconn_done(int result, void* user) {
+    if (result == 0) {
+        ((Esp01Module*)user)->join_cache.autoconn_off = true;
+    }
+}
+
+// AT+SYSSTORE=0 완료 (OK일 때만 기록, 실패/취소면 다음 접속에서 다시 보냄)
+static void on_sysstore_done(int result, void* user) {
+    if (result == 0) {
+        ((Esp01Module*)user)->join_cache.sysstore_off = true;
+    }
+}
+
+// 접속 전 준비 명령 (CWJAP는 준비 명령 결과와 무관하게 진행), 반환: 명령 수 (최대 ESP01_PREPARE_MAX)
+// 모듈 부팅마다 한 번 설정 저장을 끔 (SYSSTORE=1이면 CIPSTA/CWDHCP/CWJAP가 재접속마다 모듈 플래시에 기록됨)
+// 자동 접속은 부팅당 한 번 끔 (모듈이 스스로 스캔/DHCP를 시작해 고정 IP 설정과 겹치지 않도록)
+// 빠른 경로는 저장된 임대 주소를 고정 IP로, 전체 경로는 DHCP를 다시 켬
+static int esp01_fill_prepare(Esp01Module& module, bool fast, AtRequest* reqs, char* sta_cmd, size_t sta_size) {
+    if (!module.fast_rejoin) {
+        return 0;
+    }
+    int n = 0;
+    if (!module.join_cache.sysstore_off) {
+        reqs[n] = AtRequest();
+        reqs[n].cmd = "AT+SYSSTORE=0";
+        reqs[n].done = on_sysstore_done;
+        reqs[n].user = &module;
+        n++;
+    }
+    if (!module.join_cache.autoconn_off) {
+        reqs[n] = AtRequest();
+        reqs[n].cmd = "AT+CWAUTOCONN=0";
+        reqs[n].done = on_autoconn_done;
+        reqs[n].user = &module;
+        n++;
+    }
+    reqs[n] = AtRequest();
+    if (fast) {
+        const Esp01JoinCache& c = module.join_cache;
+        int written = snprintf(sta_cmd, sta_size, "AT+CIPSTA=\"%s\",\"%s\",\"%s\"", c.ip, c.gateway, c.netmask);
+        if (written < 0 || written >= (int)sta_size) {
+            return n;
+        }
+        reqs[n].cmd = sta_cmd;
+    } else {
+        reqs[n].cmd = "AT+CWDHCP=1,1";
+    }
+    n++;
+    for (int i = 0; i < n; i++) {
+        reqs[i].tokens = AT_RESULT;
+        reqs[i].token_count = 2;
+        reqs[i].timeout_ms = 2000;
+    }
+    return n;
+}
+
+// 준비 명령 차단 실행 (at_execute는 req.done을 무시하므로 결과를 직접 전달)
+static void esp01_execute_prepare(AtEngine& at, const AtRequest* reqs, int n) {
+    for (int i = 0; i < n; i++) {
+        int result = at_execute(at, reqs[i]);
+        if (reqs[i].done) {
+            reqs[i].done(result, reqs[i].user);
+        }
+    }
+}
+
+// 접속 성공 기록 (경로별 소요 시간 비교용)
+static void esp01_join_ok(Esp01Module& module, bool fast) {
+    uint32_t took = esp01_now_ms() - module.join_start_ms;
+    Esp01JoinStats& st = module.join_stats;
+    if (fast) {
+        st.fast_ok++;
+        st.last_fast_ms = took;
+    } else {
+        st.full_ok++;
+        st.last_full_ms = took;
+    }
+    printf("[ESP-01] WiFi 연결 성공 (%s): %lu ms\n", fast ? "빠른 재접속" : "전체 접속", (unsigned long)took);
+}
+
+static void esp01_fast_failed(Esp01Module& module, int result) {
+    module.join_stats.fast_failed++;
+    module.join_cache.valid = false;  // AP 교체/임대 변경 가능성 → 전체 접속 후 다시 확인
+    printf("[ESP-01] 빠른 재접속 실패 (%d) - 전체 접속으로 전환\n", result);
+}
+
+// WiFi 연결 재시도 (차단), first_delay_ms = 첫 시도 전 최소 간격
+static bool esp01_join(Esp01Module& module, AtEngine& at, uint32_t first_delay_ms) {
+    // 버퍼 오버플로우 방지 (128 → 256) - 루프 밖에서 한번만 생성
+    char cmd[256];
+    char sta_cmd[80];
+    AtRequest prep[ESP01_PREPARE_MAX];
+    
+    AtRequest join = {};
+    join.cmd = cmd;
+    join.tokens = JOIN_RESULT;
+    join.token_count = 3;
+    join.timeout_ms = 15000;
+    join.delay_ms = first_delay_ms;
+    
+    // 빠른 재접속: 저장된 AP/IP로 한 번 (스캔/DHCP 생략), 실패하면 전체 접속
+    if (module.fast_rejoin && module.join_cache.valid &&
+        esp01_build_join_cmd(module, cmd, sizeof(cmd), module.join_cache.bssid)) {
+        module.join_start_ms = esp01_now_ms();
+        int n = esp01_fill_prepare(module, true, prep, sta_cmd, sizeof(sta_cmd));
+        esp01_execute_prepare(at, prep, n);
+        int result = at_execute(at, join);
+        if (result == 0) {
+            esp01_join_ok(module, true);
+            return true;
+        }
+        esp01_fast_failed(module, result);
+        join.delay_ms = 0;
+    }
+    
+    if (!esp01_build_join_cmd(module, cmd, sizeof(cmd), NULL)) {
+        return false;
+    }
+    module.join_start_ms = esp01_now_ms();
+    int n = esp01_fill_prepare(module, false, prep, sta_cmd, sizeof(sta_cmd));
+    esp01_execute_prepare(at, prep, n);
+    
+    // WiFi 연결 재시도 루프
+    for (int i = 0; i < 3; i++) {
+        // FAIL/ERROR는 15초 타임아웃을 기다리지 않고 즉시 실패 처리
+        if (at_execute(at, join) == 0) {
+            esp01_join_ok(module, false);
+            // 다음 재접속을 위해 AP/임대 주소 확인
+            if (module.fast_rejoin) {
+                esp01_learn_reset(module.join_cache);
+                at_command(at, "AT+CWJAP?", AT_RESULT, 2, 2000);
+                esp01_learn_finish(module, at_command(at, "AT+CIPSTA?", AT_RESULT, 2, 2000) == 0);
+            }
+            return true;
+        }
+        
+        printf("[ESP-01] WiFi 연결 실패 (시도 %d/3)\n", i + 1);
+        if (i < 2) {
+            if (at_command(at, "AT+CWQAP", AT_RESULT, 2, 2000) != 0) {
+                printf("[ESP-01] 경고: WiFi 연결 해제 실패\n");
+            }
+            join.delay_ms = 2000;  // 연결 해제 후 재시도 간격
+        }
+    }
+    return false;
+}
+
+bool esp01_probe_ready_async(Esp01Module& module) {
+    AtEngine* at = module.link ? module.link->at : NULL;
+    if (module.ready || !at || at_engine_busy(*at)) {
+        return false;
+    }
+    AtRequest probe = {};
+    probe.cmd = "AT";
+    probe.tokens = AT_RESULT;
+    probe.token_count = 2;
+    probe.timeout_ms = ESP01_READY_PROBE_MS;
+    probe.done = on_ready_probe;
+    probe.user = &module;
+    return at_submit(*at, probe);
+}
+
+// 부팅 완료 대기 (차단): "ready" 배너 또는 짧은 간격 AT 응답 중 먼저 오는 쪽, 반환: 확인 여부
+// 고정 대기 대신 모듈이 응답하는 즉시 진행 (보통 수백 ms)
+static bool esp01_wait_ready(Esp01Module& module) {
+    AtEngine* at = module.link->at;
+    uint32_t next_probe = module.reset_ms + ESP01_READY_PROBE_MS;
+    while (!module.ready && esp01_now_ms() - module.reset_ms < ESP01_BOOT_WAIT_MS) {
+        if (!at) {
+            uart_link_poll(*module.link);
+        } else {
+            at_engine_poll(*at);  // URC 분배 + 확인 응답 처리
+            uint32_t now = esp01_now_ms();
+            if ((int32_t)(now - next_probe) >= 0 && esp01_probe_ready_async(module)) {
+                next_probe = now + ESP01_READY_PROBE_MS;
+            }
+        }
+        uart_wait_event(make_timeout_time_ms(10));
+    }
+    // 배너보다 먼저 보낸 확인 명령은 응답이 오지 않으므로 타임아웃까지 기다리지 않고 취소
+    if (at) {
+        at_engine_flush(*at);
+    }
+    return module.ready;
+}
+
+bool esp01_module_begin(Esp01Module& module) {
     printf("[ESP-01] 모듈 초기화 시작\n");
     
     // NULL 포인터 검증
-    if (!module.uart) {
-        printf("[ESP-01] 오류: NULL UART 인스턴스\n");
-        return;
+    if (!module.link || !module.uart) {
+        printf("[ESP-01] 오류: NULL UART 링크 또는 인스턴스\n");
+        return false;
     }
     
     // GPIO 핀 범위 검증 (RP2040: 0-29)
     if (module.rst_pin > 29) {
         printf("[ESP-01] 오류: 유효하지 않은 RST 핀 (%u)\n", module.rst_pin);
-        return;
+        return false;
     }
     
     // UART 초기화 (내부에서 핀 및 baudrate 검증)
-    uart_init_esp01(module.uart, module.uart_tx_pin, module.uart_rx_pin, module.uart_baudrate);
+    uart_init_esp01(*module.link, module.uart, module.uart_tx_pin, module.uart_rx_pin, module.uart_baudrate);
     printf("[ESP-01] UART 초기화: TX=%u, RX=%u, Baud=%u\n", 
            module.uart_tx_pin, module.uart_rx_pin, module.uart_baudrate);
     
+    // 리셋으로 진행 중이던 명령은 의미가 없으므로 취소
+    if (module.link->at) {
+        at_engine_flush(*module.link->at);
+    }
+    
+    // WiFi 상태 URC 등록
+    module.wifi_connected = false;
+    uart_register_urc(*module.link, "WIFI DISCONNECT", on_wifi_disconnect, &module);
+    uart_register_urc(*module.link, "WIFI GOT IP", on_wifi_got_ip, &module);
+    uart_register_urc(*module.link, "+CWJAP:", on_cwjap_info, &module);
+    uart_register_urc(*module.link, "+CIPSTA:", on_cipsta_info, &module);
+    uart_register_urc(*module.link, "ready", on_ready, &module);
+    
     // 하드웨어 리셋
     printf("[ESP-01] 하드웨어 리셋 시작 (핀: %u)\n", module.rst_pin);
     gpio_init(module.rst_pin);
     gpio_set_dir(module.rst_pin, GPIO_OUT);
     gpio_put(module.rst_pin, 0);
-    sleep_ms(500);
-    gpio_put(module.rst_pin, 1);
+    module.ready = false;
+    module.rebooted = false;
+    return true;
+}
+
+void esp01_module_init(Esp01Module& module) {
+    if (!esp01_module_begin(module)) {
+        return;
+    }
+    sleep_ms(ESP01_RESET_PULSE_MS);
+    esp01_reset_release(module);
     printf("[ESP-01] 부팅 대기 중...\n");
-    sleep_ms(3000);
+    if (!esp01_wait_ready(module)) {
+        printf("[ESP-01] 경고: %d ms 안에 부팅 확인 못함 - AT 초기화에서 다시 확인\n", ESP01_BOOT_WAIT_MS);
+    }
     printf("[ESP-01] 모듈 초기화 완료\n");
 }
 
-bool esp01_at_init(Esp01Module& module) {
-    printf("[ESP-01] AT 명령 초기화 시작\n");
-    
-    // NULL 포인터 검증
-    if (!module.uart) {
-        printf("[ESP-01] 오류: NULL UART 인스턴스\n");
-        return false;
-    }
-    
+// 기본 설정 명령 (AT 응답 확인 → 에코 끄기 → 스테이션 모드)
+// esp01_at_init과 보드레이트 전환 실패 후 리셋 복구가 같은 순서로 실행
+static bool esp01_at_setup(Esp01Module& module, AtEngine& at) {
     // AT 명령 테스트
+    AtRequest probe = {};
+    probe.cmd = "AT";
+    probe.tokens = AT_RESULT;
+    probe.token_count = 2;
+    probe.timeout_ms = 2000;
     for (int i = 0; i < 3; i++) {
-        uart_clear_rx_buffer();
-        uart_send_at_command("AT");
-        if (uart_wait_response("OK", 2000)) {
+        if (at_execute(at, probe) == 0) {
             printf("[ESP-01] AT 응답 확인\n");
+            if (!module.ready) {
+                esp01_mark_ready(module, "AT 응답");
+            }
             break;
         }
         if (i == 2) {
             printf("[ESP-01] AT 응답 없음\n");
             return false;
         }
-        sleep_ms(500);
+        probe.delay_ms = 500;
     }
     
     // 에코 끄기
-    uart_send_at_command("ATE0");
-    if (!uart_wait_response("OK", 2000)) {
+    if (at_command(at, "ATE0", AT_RESULT, 2, 2000) != 0) {
         printf("[ESP-01] 경고: 에코 끄기 실패\n");
         // 계속 진행 (에코가 켜져있어도 동작 가능)
     }
     
     // WiFi 모드 설정 (Station)
-    uart_send_at_command("AT+CWMODE=1");
-    if (!uart_wait_response("OK", 2000)) {
+    if (at_command(at, "AT+CWMODE=1", AT_RESULT, 2, 2000) != 0) {
         printf("[ESP-01] WiFi 스테이션 모드 설정 실패(AT+CWMODE=1)\n");
         return false;
     }
-    
-    printf("[ESP-01] AT 명령 초기화 완료\n");
     return true;
 }
 
-bool esp01_connect_wifi(Esp01Module& module) {
-    // SSID 출력 시 format string 취약점 방지
-    printf("[ESP-01] WiFi 연결 시작: %.*s\n", (int)sizeof(module.ssid), module.ssid);
+bool esp01_at_init(Esp01Module& module) {
+    printf("[ESP-01] AT 명령 초기화 시작\n");
     
-    // NULL 및 길이 검증
-    if (!module.ssid[0]) {
-        printf("[ESP-01] 오류: SSID가 비어있음\n");
+    // NULL 포인터 검증
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
         return false;
     }
     
-    // SSID/비밀번호 길이 검증 (AT 명령어 오버헤드 고려)
-    size_t ssid_len = strlen(module.ssid);
-    size_t pass_len = strlen(module.password);
-    if (ssid_len > 32 || pass_len > 63) {
-        printf("[ESP-01] 오류: SSID/비밀번호 길이 초과\n");
+    if (!esp01_at_setup(module, *at)) {
         return false;
     }
     
-    // 특수문자 검증 (" 문자 금지)
-    if (strchr(module.ssid, '"') || strchr(module.password, '"')) {
-        printf("[ESP-01] 오류: SSID/비밀번호에 \" 문자 포함 불가\n");
+    // 고속 보드레이트/흐름 제어 협상 (전환에 실패해도 기존 보드레이트로 계속 동작)
+    if (!esp01_negotiate_baudrate(module)) {
+        printf("[ESP-01] 보드레이트 전환 복구 후 모듈 응답 없음\n");
         return false;
     }
     
-    // 버퍼 오버플로우 방지 (128 → 256) - 루프 밖에서 한번만 생성
-    char cmd[256];
-    int written = snprintf(cmd, sizeof(cmd), "AT+CWJAP=\"%s\",\"%s\"", module.ssid, module.password);
+    printf("[ESP-01] AT 명령 초기화 완료\n");
+    return true;
+}
+
+bool esp01_negotiate_baudrate(Esp01Module& module) {
+    bool want_flow = module.uart_cts_pin >= 0 || module.uart_rts_pin >= 0;
+    bool want_baud = module.uart_target_baudrate && module.uart_target_baudrate != module.uart_baudrate;
+    if (!want_baud && !want_flow) {
+        return true;
+    }
+    unsigned int baudrate = want_baud ? module.uart_target_baudrate : module.uart_baudrate;
+    if (esp01_set_baudrate(module, baudrate)) {
+        return true;
+    }
+    printf("[ESP-01] 경고: 보드레이트 전환 실패, %u로 계속 진행\n", module.uart_baudrate);
+    
+    // 거부(ERROR)면 설정이 그대로지만, 리셋 복구를 거쳤으면 초기화 명령까지 성공했는지 확인
+    AtEngine* at = esp01_engine(module);
+    return at && esp01_probe(*at, 1);
+}
+
+bool esp01_set_baudrate(Esp01Module& module, unsigned int baudrate) {
+    // NULL 포인터 검증
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
+        return false;
+    }
+    
+    UartLink& link = *module.link;
+    unsigned int old_baudrate = link.baudrate;
+    int old_cts = link.cts_pin;
+    int old_rts = link.rts_pin;
+    
+    // ESP flow control 비트: 1 = ESP RTS 출력 (우리 CTS 입력), 2 = ESP CTS 입력 (우리 RTS 출력)
+    int flow = (module.uart_cts_pin >= 0 ? 1 : 0) | (module.uart_rts_pin >= 0 ? 2 : 0);
+    
+    char cmd[64];
+    int written = snprintf(cmd, sizeof(cmd), "AT+UART_CUR=%u,8,1,0,%d", baudrate, flow);
     if (written < 0 || written >= (int)sizeof(cmd)) {
         printf("[ESP-01] 오류: 명령어 생성 실패\n");
         return false;
     }
     
-    // WiFi 연결 재시도 루프
+    printf("[ESP-01] 보드레이트 전환 요청: %u -> %u (흐름 제어 %d)\n", old_baudrate, baudrate, flow);
     
-    for (int i = 0; i < 3; i++) {
-        uart_clear_rx_buffer();
-        uart_send_at_command(cmd);
-        
-        if (uart_wait_response("WIFI GOT IP", 15000)) {
-            printf("[ESP-01] WiFi 연결 성공\n");
-            return true;
-        }
-        
-        printf("[ESP-01] WiFi 연결 실패 (시도 %d/3)\n", i + 1);
-        if (i < 2) {
-            uart_clear_rx_buffer();
-            sleep_ms(50);  // 버퍼 안정화 대기
-            uart_send_at_command("AT+CWQAP");
-            if (!uart_wait_response("OK", 2000)) {
-                printf("[ESP-01] 경고: WiFi 연결 해제 실패\n");
-            }
-            sleep_ms(2000);
-        }
+    // OK는 기존 속도로 수신되고, 그 직후 ESP가 새 속도로 전환
+    if (at_command(*at, cmd, AT_RESULT, 2, 2000) != 0) {
+        printf("[ESP-01] AT+UART_CUR 거부 - 기존 보드레이트 유지\n");
+        return false;
+    }
+    
+    // RP2040 측도 같은 설정으로 전환 후 새 속도에서 응답 확인
+    if (uart_switch_baudrate(link, baudrate, module.uart_cts_pin, module.uart_rts_pin) &&
+        esp01_probe(*at, 3)) {
+        UartThroughput tp;
+        uart_get_throughput(link, &tp);
+        printf("[ESP-01] 보드레이트 전환 완료: %lu (이론 최대 %lu B/s)\n",
+               (unsigned long)tp.baudrate, (unsigned long)(tp.baudrate / 10));
+        return true;
+    }
+    
+    // 복구: UART_CUR는 플래시에 저장되지 않으므로 하드웨어 리셋 시 ESP는 부팅 기본 속도로 복귀
+    printf("[ESP-01] 새 보드레이트 응답 없음 - 리셋 후 %u로 복귀\n", module.uart_baudrate);
+    uart_switch_baudrate(link, old_baudrate, old_cts, old_rts);
+    esp01_module_init(module);
+    
+    // 리셋으로 에코/스테이션 모드 설정도 사라졌으므로 초기화 명령 전체를 다시 실행
+    if (!esp01_at_setup(module, *at)) {
+        printf("[ESP-01] 오류: 복귀 후 AT 초기화 실패\n");
+    }
+    return false;
+}
+
+bool esp01_connect_wifi(Esp01Module& module) {
+    // SSID 출력 시 format string 취약점 방지
+    printf("[ESP-01] WiFi 연결 시작: %.*s\n", (int)sizeof(module.ssid), module.ssid);
+    
+    // NULL 포인터 검증
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
+        return false;
+    }
+    
+    if (esp01_join(module, *at, 0)) {
+        return true;
     }
     
     printf("[ESP-01] WiFi 연결 최종 실패\n");
@@ -142,56 +580,226 @@ bool esp01_connect_wifi(Esp01Module& module) {
     return false;
 }
 
-bool esp01_is_connected(Esp01Module& module) {
+// 접속 정보 확인 제출 (응답 줄은 +CWJAP:/+CIPSTA: URC 핸들러가 저장)
+static void esp01_submit_learn(Esp01Module& module, AtEngine& at) {
+    esp01_learn_reset(module.join_cache);
+    AtRequest req = {};
+    req.cmd = "AT+CWJAP?";
+    req.tokens = AT_RESULT;
+    req.token_count = 2;
+    req.timeout_ms = 2000;
+    at_submit(at, req);
+    req.cmd = "AT+CIPSTA?";
+    req.done = on_learn_done;
+    req.user = &module;
+    at_submit(at, req);
+}
+
+static void on_join_done(int result, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    module.wifi_connected = (result == 0);
+    if (result == 0) {
+        esp01_join_ok(module, false);
+        // 다음 재접속을 위해 AP/임대 주소 확인
+        AtEngine* at = esp01_engine(module);
+        if (module.fast_rejoin && at) {
+            esp01_submit_learn(module, *at);
+        }
+    } else if (result != AT_RESULT_ABORTED) {
+        printf("[ESP-01] WiFi 연결 실패 (%d)\n", result);
+    }
+}
+
+static bool esp01_submit_join(Esp01Module& module, AtEngine& at, bool fast);
+
+static void on_fast_join_done(int result, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    module.wifi_connected = (result == 0);
+    if (result == 0) {
+        esp01_join_ok(module, true);
+        return;
+    }
+    if (result == AT_RESULT_ABORTED) {
+        return;  // 큐 비움 (모듈 리셋 등)
+    }
+    esp01_fast_failed(module, result);
+    AtEngine* at = esp01_engine(module);
+    if (!at || !esp01_submit_join(module, *at, false)) {
+        printf("[ESP-01] 전체 접속 제출 실패\n");
+    }
+}
+
+// 준비 명령 + AT+CWJAP 제출 (fast = 저장된 BSSID/고정 IP 사용)
+static bool esp01_submit_join(Esp01Module& module, AtEngine& at, bool fast) {
+    char cmd[256];
+    if (!esp01_build_join_cmd(module, cmd, sizeof(cmd), fast ? module.join_cache.bssid : NULL)) {
+        return false;
+    }
+    
+    // 준비 명령과 접속이 함께 들어갈 자리가 있을 때만 제출
+    if (at_engine_pending(at) > AT_QUEUE_LEN - (ESP01_PREPARE_MAX + 1)) {
+        return false;
+    }
+    
+    char sta_cmd[80];
+    AtRequest prep[ESP01_PREPARE_MAX];
+    module.join_start_ms = esp01_now_ms();
+    int n = esp01_fill_prepare(module, fast, prep, sta_cmd, sizeof(sta_cmd));
+    for (int i = 0; i < n; i++) {
+        at_submit(at, prep[i]);  // 엔진이 명령 복사
+    }
+    
+    AtRequest join = {};
+    join.cmd = cmd;
+    join.tokens = JOIN_RESULT;
+    join.token_count = 3;
+    join.timeout_ms = 15000;
+    join.done = fast ? on_fast_join_done : on_join_done;
+    join.user = &module;
+    return at_submit(at, join);
+}
+
+static void on_status_done(int result, void* user) {
+    Esp01Module& module = *(Esp01Module*)user;
+    if (result != AT_RESULT_ABORTED) {
+        module.wifi_connected = (result >= 0 && result <= 2);
+    }
+}
+
+bool esp01_connect_wifi_async(Esp01Module& module) {
     // NULL 포인터 검증
-    if (!module.uart) {
-        printf("[ESP-01] 오류: NULL UART 인스턴스\n");
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
         return false;
     }
     
-    // Race condition 완화: 버퍼 클리어 후 즉시 전송
-    uart_clear_rx_buffer();
-    sleep_ms(50);  // 버퍼 안정화 대기
-    uart_send_at_command("AT+CIPSTATUS");
+    bool fast = module.fast_rejoin && module.join_cache.valid;
+    if (fast) {
+        printf("[ESP-01] WiFi 빠른 재접속 요청: %.*s (BSSID %s, IP %s)\n", (int)sizeof(module.ssid), module.ssid,
+               module.join_cache.bssid, module.join_cache.ip);
+    } else {
+        printf("[ESP-01] WiFi 연결 요청: %.*s\n", (int)sizeof(module.ssid), module.ssid);
+    }
+    return esp01_submit_join(module, *at, fast);
+}
+
+bool esp01_is_connected(Esp01Module& module) {
+    // NULL 포인터 검증
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
+        return false;
+    }
     
-    if (uart_wait_response("STATUS:", 3000)) {
-        const char* resp = uart_get_rx_buffer();
-        
-        // NULL 포인터 검증
-        if (!resp) {
-            printf("[ESP-01] 경고: NULL 응답 버퍼\n");
-            return false;
-        }
-        
-        // STATUS:2 = Got IP, STATUS:3 = Connected, STATUS:4 = Connecting
-        if (strstr(resp, "STATUS:2") || strstr(resp, "STATUS:3") || strstr(resp, "STATUS:4")) {
-            return true;
-        }
+    // 상태 코드까지 한 번에 판별 (응답 재검사 없음)
+    int result = at_command(*at, "AT+CIPSTATUS", CIPSTATUS_RESULT, 5, 3000);
+    return result >= 0 && result <= 2;
+}
+
+bool esp01_query_status_async(Esp01Module& module) {
+    // NULL 포인터 검증
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
+        return false;
     }
-    return false;
+    
+    AtRequest status = {};
+    status.cmd = "AT+CIPSTATUS";
+    status.tokens = CIPSTATUS_RESULT;
+    status.token_count = 5;
+    status.timeout_ms = 3000;
+    status.done = on_status_done;
+    status.user = &module;
+    return at_submit(*at, status);
 }
 
 bool esp01_reconnect_wifi(Esp01Module& module) {
     printf("[ESP-01] WiFi 재연결 시도...\n");
     
     // NULL 포인터 검증
-    if (!module.uart) {
-        printf("[ESP-01] 오류: NULL UART 인스턴스\n");
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
         return false;
     }
     
     // 현재 WiFi 연결 끊기
-    uart_clear_rx_buffer();
-    uart_send_at_command("AT+CWQAP");
-    uart_wait_response("OK", 2000);
-    sleep_ms(1000);
+    at_command(*at, "AT+CWQAP", AT_RESULT, 2, 2000);
     
-    // WiFi 재연결 시도
-    if (esp01_connect_wifi(module)) {
+    // WiFi 재연결 시도 (연결 해제 후 1초 간격)
+    if (esp01_join(module, *at, 1000)) {
         printf("[ESP-01] WiFi 재연결 성공\n");
         return true;
     }
     
+    printf("[ESP-01] WiFi 연결 최종 실패\n");
+    esp01_module_init(module);  // 모듈 재초기화
     printf("[ESP-01] WiFi 재연결 실패\n");
     return false;
 }
+
+void esp01_reset_assert(Esp01Module& module) {
+    if (!module.link || module.rst_pin > 29) {
+        printf("[ESP-01] 오류: 리셋할 수 없음 (링크/RST 핀)\n");
+        return;
+    }
+    
+    // 리셋으로 진행 중이던 명령은 의미가 없으므로 취소
+    if (module.link->at) {
+        at_engine_flush(*module.link->at);
+    }
+    module.wifi_connected = false;
+    module.ready = false;
+    module.rebooted = false;
+    
+    printf("[ESP-01] 하드웨어 리셋 (비차단, 핀: %u)\n", module.rst_pin);
+    gpio_init(module.rst_pin);
+    gpio_set_dir(module.rst_pin, GPIO_OUT);
+    gpio_put(module.rst_pin, 0);
+    
+    // UART_CUR는 플래시에 저장되지 않으므로 ESP는 부팅 기본 속도로 돌아옴
+    if (module.link->baudrate != module.uart_baudrate || module.link->cts_pin >= 0 || module.link->rts_pin >= 0) {
+        uart_switch_baudrate(*module.link, module.uart_baudrate, -1, -1);
+    }
+}
+
+void esp01_reset_release(Esp01Module& module) {
+    if (module.rst_pin > 29) {
+        return;
+    }
+    module.reset_ms = esp01_now_ms();
+    module.join_cache.sysstore_off = false;
+    gpio_put(module.rst_pin, 1);
+}
+
+bool esp01_at_init_async(Esp01Module& module, AtCallback done, void* user) {
+    // NULL 포인터 검증
+    AtEngine* at = esp01_engine(module);
+    if (!at) {
+        return false;
+    }
+    
+    // 연쇄가 중간에 끊기지 않도록 세 칸이 비어 있을 때만 제출
+    if (at_engine_pending(*at) > AT_QUEUE_LEN - 3) {
+        return false;
+    }
+    
+    // AT 응답 → 에코 끄기 → 스테이션 모드 (앞 명령 실패 시 뒤 명령 취소)
+    static const char* const cmds[] = { "AT", "ATE0", "AT+CWMODE=1" };
+    for (int i = 0; i < 3; i++) {
+        AtRequest req = {};
+        req.cmd = cmds[i];
+        req.tokens = AT_RESULT;
+        req.token_count = 2;
+        req.timeout_ms = 2000;
+        req.chain = (i < 2);
+        if (i == 0) {
+            // 배너를 놓쳤어도 첫 AT 응답으로 부팅 완료 기록
+            req.done = on_ready_probe;
+            req.user = &module;
+        } else if (i == 2) {
+            req.done = done;
+            req.user = user;
+        }
+        at_submit(*at, req);
+    }
+    return true;
+}
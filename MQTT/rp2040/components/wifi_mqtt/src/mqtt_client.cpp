@@ -1,22 +1,94 @@
 #include "mqtt_client.h"
+#include "mqtt_transport.h"
 #include "uart_comm.h"
+#include "at_engine.h"
 #include <stdio.h>
 #include <string.h>
-#include <limits.h>
 #include "pico/stdlib.h"
 
-// AT 명령어 최대 길이 제한
+// 발행 지연 표본 기록
+void mqtt_publish_record(MqttClient& client, int result, uint32_t start_us) {
+    MqttPublishStats& st = client.pub_stats;
+    if (result != 0) {
+        st.failed++;
+        return;
+    }
+    st.published++;
+    if (st.first_ok_ms == 0) {
+        st.first_ok_ms = to_ms_since_boot(get_absolute_time());
+    }
+    st.samples_us[st.sample_count++ % MQTT_PUB_LATENCY_SAMPLES] = time_us_32() - start_us;
+}
+
+// 발행 결과 반영 (차단/비차단 공통)
+// 프롬프트 실패/응답 없음만 연결 끊김으로 판단, 페이로드 전송 후 ERROR/FAIL은 이 메시지만의 실패
+// (브로커 연결 끊김은 +MQTTDISCONNECTED URC로 따로 반영)
+void mqtt_publish_result(MqttClient& client, int result) {
+    if (result == 0) {
+        client.last_activity = to_ms_since_boot(get_absolute_time());
+    } else if (result == AT_RESULT_PROMPT_FAIL) {
+        printf("[MQTT] 발행 준비 실패 (연결 끊김 가능성)\n");
+        client.connected = false;  // 연결 상태 플래그 업데이트
+    } else if (result == AT_RESULT_TIMEOUT) {
+        printf("[MQTT] 발행 응답 없음 (연결 끊김 가능성)\n");
+        client.connected = false;  // 연결 상태 플래그 업데이트
+    } else if (result > 0) {
+        printf("[MQTT] 발행 실패 (모듈 응답 %d)\n", result);
+    }
+}
+
+static void on_publish_done(int result, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    MqttPublishStats& st = client.pub_stats;
+    // 전송 계층은 제출 순서대로 완료하므로 가장 오래된 제출 시각이 이 발행의 시각
+    if (st.pending_tail != st.pending_head) {
+        mqtt_publish_record(client, result, st.pending_start_us[st.pending_tail++ % AT_QUEUE_LEN]);
+    }
+    mqtt_publish_result(client, result);
+}
+
+#if !MQTT_NATIVE_TRANSPORT
+// AT 명령어 최대 길이 제한 (비차단 제출은 AT 엔진 슬롯 크기 AT_CMD_MAX_LEN까지)
 #define MAX_AT_COMMAND_LEN 512
-#define MAX_TOPIC_LEN 128
 #define MAX_CLIENT_ID_LEN 64
 #define MAX_USERNAME_LEN 64
 #define MAX_PASSWORD_LEN 64
-#define MQTT_RX_BUFFER_SIZE 1024  // UART RX_BUFFER_SIZE와 일치
 #define MAX_BROKER_LEN 128
 
-bool mqtt_connect(MqttClient& client) {
+// 명령 결과 토큰 (AT 엔진 결과 인덱스, '>' 프롬프트는 엔진이 처리)
+static const char* const AT_RESULT[] = { "OK", "ERROR" };
+static const char* const PUB_RESULT[] = { "OK", "ERROR", "FAIL" };
+// +MQTTCONN:<LinkID>,<state>,... state 4/5/6 = 연결됨, 그 외에는 OK로 종료
+static const char* const CONN_STATE_RESULT[] = { "+MQTTCONN:0,4", "+MQTTCONN:0,5", "+MQTTCONN:0,6", "OK", "ERROR" };
+
+// 브로커 연결 상태 URC (명령 응답과 분리되어 메인 루프에서 호출)
+static void on_mqtt_connected(const char* line, uint32_t len, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    client.connected = true;
+    client.last_activity = to_ms_since_boot(get_absolute_time());
+}
+
+static void on_mqtt_disconnected(const char* line, uint32_t len, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    if (client.connected) {
+        printf("[MQTT] URC: 브로커 연결 끊김\n");
+    }
+    client.connected = false;
+}
+
+// 링크에 연결된 AT 엔진 (없으면 NULL)
+static AtEngine* mqtt_engine(MqttClient& client) {
+    if (!client.link || !client.link->at) {
+        printf("[MQTT] 오류: UART 링크 또는 AT 엔진 없음\n");
+        return NULL;
+    }
+    return client.link->at;
+}
+
+// 연결 명령 3개 생성 (사용자 설정 / LWT 설정 / 브로커 연결) 및 설정 검증
+static bool mqtt_build_connect_cmds(MqttClient& client, char (*cmds)[MAX_AT_COMMAND_LEN]) {
     // NULL 포인터 검증
-    if (!client.broker || !client.client_id || !client.username || 
+    if (!client.link || !client.broker || !client.client_id || !client.username || 
         !client.password || !client.lwt_topic || !client.lwt_message) {
         printf("[MQTT] NULL 포인터 오류\n");
         return false;
@@ -42,64 +114,214 @@ bool mqtt_connect(MqttClient& client) {
         return false;
     }
     
-    printf("[MQTT] 연결 시작: %.*s:%d\n", MAX_BROKER_LEN, client.broker, client.port);
-    
-    char cmd[MAX_AT_COMMAND_LEN];
-    int cmd_len;
-    
     // 1. MQTT 사용자 설정
-    cmd_len = snprintf(cmd, sizeof(cmd), "AT+MQTTUSERCFG=0,1,\"%s\",\"%s\",\"%s\",0,0,\"\"",
-                       client.client_id, client.username, client.password);
-    if (cmd_len >= (int)sizeof(cmd)) {
+    int cmd_len = snprintf(cmds[0], MAX_AT_COMMAND_LEN, "AT+MQTTUSERCFG=0,1,\"%s\",\"%s\",\"%s\",0,0,\"\"",
+                           client.client_id, client.username, client.password);
+    if (cmd_len >= MAX_AT_COMMAND_LEN) {
         printf("[MQTT] 사용자 설정 명령어 버퍼 오버플로우\n");
         return false;
     }
     
-    uart_send_at_command(cmd);
-    if (!uart_wait_response("OK", 2000)) {
-        printf("[MQTT] 사용자 설정 실패\n");
-        client.connected = false;
-        return false;
-    }
-    sleep_ms(300);
-    
-    // 2. MQTT 연결 설정 (LWT + keepalive 60초)
+    // 2. MQTT 연결 설정 (LWT + keepalive, PINGREQ는 모듈이 처리)
     if (strlen(client.lwt_topic) >= MAX_TOPIC_LEN) {
         printf("[MQTT] LWT 토픽 길이 초과\n");
         return false;
     }
     
-    cmd_len = snprintf(cmd, sizeof(cmd), "AT+MQTTCONNCFG=0,60,0,\"%s\",\"%s\",1,0",
-                       client.lwt_topic, client.lwt_message);
-    if (cmd_len >= (int)sizeof(cmd)) {
+    cmd_len = snprintf(cmds[1], MAX_AT_COMMAND_LEN, "AT+MQTTCONNCFG=0,%d,0,\"%s\",\"%s\",1,0",
+                       MQTT_KEEPALIVE_S, client.lwt_topic, client.lwt_message);
+    if (cmd_len >= MAX_AT_COMMAND_LEN) {
         printf("[MQTT] LWT 설정 명령어 버퍼 오버플로우\n");
         return false;
     }
     
-    uart_send_at_command(cmd);
-    if (!uart_wait_response("OK", 2000)) {
-        printf("[MQTT] 연결 설정 실패\n");
-        client.connected = false;
+    // 3. MQTT 브로커 연결
+    cmd_len = snprintf(cmds[2], MAX_AT_COMMAND_LEN, "AT+MQTTCONN=0,\"%s\",%d,0", client.broker, client.port);
+    if (cmd_len >= MAX_AT_COMMAND_LEN) {
+        printf("[MQTT] 브로커 연결 명령어 버퍼 오버플로우\n");
         return false;
     }
-    sleep_ms(300);
+    return true;
+}
+
+// 연결 요청 3단계 (설정 명령 사이 300ms 간격, 앞 단계 실패 시 나머지 취소)
+static void mqtt_fill_connect_reqs(AtRequest* reqs, char (*cmds)[MAX_AT_COMMAND_LEN]) {
+    for (int i = 0; i < 3; i++) {
+        reqs[i] = AtRequest();
+        reqs[i].cmd = cmds[i];
+        reqs[i].tokens = AT_RESULT;
+        reqs[i].token_count = 2;
+        reqs[i].timeout_ms = 2000;
+        reqs[i].delay_ms = (i > 0) ? 300 : 0;
+        reqs[i].chain = (i < 2);
+    }
+    // +MQTTCONNECTED/+MQTTDISCONNECTED는 URC로 분리되므로 명령 결과(OK/ERROR)로 판정
+    reqs[2].timeout_ms = 10000;
+}
+
+// 연결 상태 URC 등록 (재연결 시에는 같은 항목 교체)
+static void mqtt_register_urcs(MqttClient& client) {
+    uart_register_urc(*client.link, "+MQTTCONNECTED", on_mqtt_connected, &client);
+    uart_register_urc(*client.link, "+MQTTDISCONNECTED", on_mqtt_disconnected, &client);
+}
+
+// 토픽별 명령 접두사 "AT+MQTTPUBRAW=0,\"<topic>\"," (첫 발행 때 검증/포맷 후 클라이언트 캐시에서 재사용)
+#define PUB_PREFIX_HEAD "AT+MQTTPUBRAW=0,\""
+#define PUB_PREFIX_HEAD_LEN (sizeof(PUB_PREFIX_HEAD) - 1)
+
+static const MqttPubPrefix* mqtt_pub_prefix(MqttClient& client, const char* topic) {
+    MqttPubPrefixCache& cache = client.pub_prefix;
     
-    // 3. MQTT 브로커 연결
-    cmd_len = snprintf(cmd, sizeof(cmd), "AT+MQTTCONN=0,\"%s\",%d,0", client.broker, client.port);
-    if (cmd_len >= (int)sizeof(cmd)) {
-        printf("[MQTT] 브로커 연결 명령어 버퍼 오버플로우\n");
+    // 토픽 길이 검증
+    size_t topic_len = strlen(topic);
+    if (topic_len >= MAX_TOPIC_LEN) {
+        printf("[MQTT] 토픽 길이 초과\n");
+        return NULL;
+    }
+    
+    for (int i = 0; i < MQTT_PUB_PREFIX_CACHE; i++) {
+        const MqttPubPrefix& entry = cache.entries[i];
+        if (entry.len && entry.topic_len == topic_len &&
+            memcmp(entry.prefix + PUB_PREFIX_HEAD_LEN, topic, topic_len) == 0) {
+            return &entry;
+        }
+    }
+    
+    MqttPubPrefix& entry = cache.entries[cache.next++ % MQTT_PUB_PREFIX_CACHE];
+    entry.len = (uint16_t)snprintf(entry.prefix, sizeof(entry.prefix), PUB_PREFIX_HEAD "%s\",", topic);
+    entry.topic_len = (uint16_t)topic_len;
+    return &entry;
+}
+
+// 10진수 덧붙이기 (snprintf 대신, 반환: 기록한 끝 위치)
+static char* append_uint(char* p, uint32_t value) {
+    char digits[10];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) {
+        *p++ = digits[--n];
+    }
+    return p;
+}
+
+// 발행 요청 생성 (MQTTPUBRAW + '>' 프롬프트 후 페이로드)
+static bool mqtt_build_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain,
+                               char* cmd, AtRequest& req) {
+    if (!client.connected) {
+        printf("[MQTT] 연결되지 않음\n");
         return false;
     }
     
-    uart_clear_rx_buffer();
-    uart_send_at_command(cmd);
+    // NULL 포인터 검증
+    if (!topic || !message) {
+        printf("[MQTT] NULL 토픽 또는 메시지\n");
+        return false;
+    }
     
-    if (!uart_wait_response("MQTTCONNECTED", 10000)) {
-        printf("[MQTT] 브로커 연결 실패\n");
+    // QoS 검증
+    if (qos < 0 || qos > 2) {
+        printf("[MQTT] 유효하지 않은 QoS: %d\n", qos);
+        return false;
+    }
+    
+    // retain 검증
+    if (retain < 0 || retain > 1) {
+        printf("[MQTT] 유효하지 않은 retain: %d\n", retain);
+        return false;
+    }
+    
+    int msg_len = strlen(message);
+    
+    // 빈 메시지 경고 (허용하지만 의도하지 않은 동작일 수 있음)
+    if (msg_len == 0) {
+        printf("[MQTT] 경고: 빈 메시지 발행\n");
+    }
+    
+    // MQTTPUBRAW 명령 생성: 캐시된 토픽 접두사 + "<len>,<qos>,<retain>"
+    const MqttPubPrefix* prefix = mqtt_pub_prefix(client, topic);
+    if (!prefix) {
+        return false;
+    }
+    memcpy(cmd, prefix->prefix, prefix->len);
+    char* p = append_uint(cmd + prefix->len, (uint32_t)msg_len);
+    *p++ = ',';
+    *p++ = (char)('0' + qos);
+    *p++ = ',';
+    *p++ = (char)('0' + retain);
+    *p = '\0';
+    
+    req = AtRequest();
+    req.cmd = cmd;
+    req.tokens = PUB_RESULT;
+    req.token_count = 3;
+    req.timeout_ms = 3000;
+    req.payload = message;
+    req.payload_len = (uint32_t)msg_len;
+    return true;
+}
+
+static void on_connect_done(int result, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    if (result != 0) {
+        printf("[MQTT] 브로커 연결 실패 (%d)\n", result);
         client.connected = false;
+        return;
+    }
+    
+    client.connected = true;
+    client.last_activity = to_ms_since_boot(get_absolute_time());
+    printf("[MQTT] 연결 성공\n");
+    
+    // 연결 성공 시 online 상태 발행 (콜백 안이므로 제출만)
+    if (!mqtt_publish_async(client, client.lwt_topic, "online", 1, 1)) {
+        printf("[MQTT] 경고: online 상태 발행 실패\n");
+    }
+}
+
+static void on_conn_state_done(int result, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    // +MQTTCONN:0,<state>,... 응답에서 상태까지 한 번에 판별 (취소는 판단 보류)
+    if (result == AT_RESULT_ABORTED || (result >= 0 && result <= 2)) {
+        return;
+    }
+    if (client.connected) {
+        printf("[MQTT] 브로커 연결 끊김 확인\n");
+    }
+    client.connected = false;
+}
+
+// 차단 연결 (first_delay_ms = 직전 명령 완료 후 첫 명령까지 간격)
+static bool mqtt_connect_after(MqttClient& client, uint32_t first_delay_ms) {
+    char cmds[3][MAX_AT_COMMAND_LEN];
+    if (!mqtt_build_connect_cmds(client, cmds)) {
+        return false;
+    }
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
         return false;
     }
     
+    printf("[MQTT] 연결 시작: %.*s:%d\n", MAX_BROKER_LEN, client.broker, client.port);
+    mqtt_register_urcs(client);
+    
+    AtRequest reqs[3];
+    mqtt_fill_connect_reqs(reqs, cmds);
+    reqs[0].delay_ms = first_delay_ms;
+    
+    static const char* const step_errors[] = {
+        "[MQTT] 사용자 설정 실패\n", "[MQTT] 연결 설정 실패\n", "[MQTT] 브로커 연결 실패\n"
+    };
+    for (int i = 0; i < 3; i++) {
+        if (at_execute(*at, reqs[i]) != 0) {
+            printf("%s", step_errors[i]);
+            client.connected = false;
+            return false;
+        }
+    }
+    
     client.connected = true;
     client.last_activity = to_ms_since_boot(get_absolute_time());
     printf("[MQTT] 연결 성공\n");
@@ -112,7 +334,46 @@ bool mqtt_connect(MqttClient& client) {
     return true;
 }
 
-bool mqtt_subscribe(MqttClient& client, const char* topic, int qos) {
+bool mqtt_connect(MqttClient& client) {
+    return mqtt_connect_after(client, 0);
+}
+
+bool mqtt_connect_async(MqttClient& client) {
+    char cmds[3][MAX_AT_COMMAND_LEN];
+    if (!mqtt_build_connect_cmds(client, cmds)) {
+        return false;
+    }
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
+        return false;
+    }
+    
+    printf("[MQTT] 연결 요청: %.*s:%d\n", MAX_BROKER_LEN, client.broker, client.port);
+    mqtt_register_urcs(client);
+    
+    AtRequest reqs[3];
+    mqtt_fill_connect_reqs(reqs, cmds);
+    reqs[2].done = on_connect_done;
+    reqs[2].user = &client;
+    
+    // 3개가 한꺼번에 들어갈 자리가 없으면 제출하지 않음 (중간만 제출되는 것 방지)
+    if (at->head - at->tail > AT_QUEUE_LEN - 3) {
+        printf("[MQTT] AT 큐 여유 없음 - 연결 요청 보류\n");
+        return false;
+    }
+    for (int i = 0; i < 3; i++) {
+        at_submit(*at, reqs[i]);
+    }
+    return true;
+}
+
+bool mqtt_connect_pending(MqttClient& client) {
+    // 연결 명령은 AT 엔진 큐에만 있으므로 at_engine_busy가 곧 진행 중
+    return client.link && client.link->at && at_engine_busy(*client.link->at);
+}
+
+// 구독 명령 생성 및 검증
+static bool mqtt_build_subscribe(MqttClient& client, const char* topic, int qos, char* cmd) {
     if (!client.connected) {
         printf("[MQTT] 연결되지 않음\n");
         return false;
@@ -136,243 +397,862 @@ bool mqtt_subscribe(MqttClient& client, const char* topic, int qos) {
         return false;
     }
     
-    printf("[MQTT] 구독: %.*s (QoS %d)\n", MAX_TOPIC_LEN, topic, qos);
-    
-    char cmd[MAX_AT_COMMAND_LEN];
-    int cmd_len = snprintf(cmd, sizeof(cmd), "AT+MQTTSUB=0,\"%s\",%d", topic, qos);
-    if (cmd_len >= (int)sizeof(cmd)) {
+    int cmd_len = snprintf(cmd, MAX_AT_COMMAND_LEN, "AT+MQTTSUB=0,\"%s\",%d", topic, qos);
+    if (cmd_len >= MAX_AT_COMMAND_LEN) {
         printf("[MQTT] 구독 명령어 버퍼 오버플로우\n");
         return false;
     }
+    return true;
+}
+
+bool mqtt_subscribe(MqttClient& client, const char* topic, int qos) {
+    char cmd[MAX_AT_COMMAND_LEN];
+    if (!mqtt_build_subscribe(client, topic, qos, cmd)) {
+        return false;
+    }
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
+        return false;
+    }
+    
+    printf("[MQTT] 구독: %.*s (QoS %d)\n", MAX_TOPIC_LEN, topic, qos);
+    
+    AtRequest req = {};
+    req.cmd = cmd;
+    req.tokens = AT_RESULT;
+    req.token_count = 2;
+    req.timeout_ms = 3000;
+    req.delay_ms = 300;  // 직전 명령과의 간격
     
     // 재시도 로직 (최대 3회)
     for (int i = 0; i < 3; i++) {
-        uart_clear_rx_buffer();
-        uart_send_at_command(cmd);
-        
-        if (uart_wait_response("OK", 3000)) {
+        if (at_execute(*at, req) == 0) {
             printf("[MQTT] 구독 성공\n");
-            sleep_ms(300);
             return true;
         }
         
         printf("[MQTT] 구독 실패 (시도 %d/3)\n", i + 1);
-        if (i < 2) {
-            sleep_ms(1000);
-        }
+        req.delay_ms = 1000;
     }
     
     printf("[MQTT] 구독 최종 실패\n");
     return false;
 }
 
-bool mqtt_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain) {
-    if (!client.connected) {
-        printf("[MQTT] 연결되지 않음\n");
+bool mqtt_subscribe_async(MqttClient& client, const char* topic, int qos, AtCallback done, void* user) {
+    char cmd[MAX_AT_COMMAND_LEN];
+    if (!mqtt_build_subscribe(client, topic, qos, cmd)) {
         return false;
     }
-    
-    // NULL 포인터 검증
-    if (!topic || !message) {
-        printf("[MQTT] NULL 토픽 또는 메시지\n");
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
         return false;
     }
     
-    // QoS 검증
-    if (qos < 0 || qos > 2) {
-        printf("[MQTT] 유효하지 않은 QoS: %d\n", qos);
+    AtRequest req = {};
+    req.cmd = cmd;
+    req.tokens = AT_RESULT;
+    req.token_count = 2;
+    req.timeout_ms = 3000;
+    req.delay_ms = 300;  // 직전 명령과의 간격
+    req.done = done;
+    req.user = user;
+    return at_submit(*at, req);
+}
+
+bool mqtt_submit_subscribe(MqttClient& client, const char* filter, int qos, AtCallback done, void* user) {
+    char cmd[MAX_AT_COMMAND_LEN];
+    if (!mqtt_build_subscribe(client, filter, qos, cmd)) {
         return false;
     }
-    
-    // retain 검증
-    if (retain < 0 || retain > 1) {
-        printf("[MQTT] 유효하지 않은 retain: %d\n", retain);
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
         return false;
     }
     
-    // 토픽 길이 검증
-    if (strlen(topic) >= MAX_TOPIC_LEN) {
-        printf("[MQTT] 토픽 길이 초과\n");
+    // 구독 관리자용: 지연 없이 연속 제출 (응답 직후 바로 다음 명령)
+    AtRequest req = {};
+    req.cmd = cmd;
+    req.tokens = AT_RESULT;
+    req.token_count = 2;
+    req.timeout_ms = 3000;
+    req.done = done;
+    req.user = user;
+    return at_submit(*at, req);
+}
+
+uint32_t mqtt_submit_room(MqttClient& client) {
+    AtEngine* at = client.link ? client.link->at : NULL;
+    return at ? AT_QUEUE_LEN - at_engine_pending(*at) : 0;
+}
+
+void mqtt_transport_poll(MqttClient& client) {
+    // AT 명령 전송은 at_engine_poll이 모두 진행
+    (void)client;
+}
+
+#endif // !MQTT_NATIVE_TRANSPORT
+
+// ===== 구독 관리자 =====
+bool mqtt_topic_matches(const char* filter, const char* topic) {
+    // NULL 포인터 검증
+    if (!filter || !topic) {
         return false;
     }
     
-    int msg_len = strlen(message);
-    
-    // 빈 메시지 경고 (허용하지만 의도하지 않은 동작일 수 있음)
-    if (msg_len == 0) {
-        printf("[MQTT] 경고: 빈 메시지 발행\n");
+    while (*filter) {
+        if (filter[0] == '#') {
+            return true;  // 나머지 단계 전체 (부모 단계 자체 포함)
+        }
+        if (filter[0] == '+') {
+            // 한 단계 건너뜀
+            while (*topic && *topic != '/') {
+                topic++;
+            }
+            filter++;
+        } else {
+            while (*filter && *filter != '/') {
+                if (*filter++ != *topic++) {
+                    return false;
+                }
+            }
+            if (*topic && *topic != '/') {
+                return false;
+            }
+        }
+        // 단계 구분자
+        if (*filter == '/') {
+            if (*topic != '/') {
+                // "a/#"는 "a"와도 일치
+                return *topic == '\0' && filter[1] == '#' && filter[2] == '\0';
+            }
+            filter++;
+            topic++;
+        } else if (*topic) {
+            return false;
+        }
     }
+    return *topic == '\0';
+}
+
+// 토픽을 단계로 분리 (반환: 단계 수, 초과 시 -1)
+static int topic_split(const char* topic, const char** level, uint8_t* level_len) {
+    int count = 0;
+    const char* start = topic;
+    for (const char* p = topic; ; p++) {
+        if (*p == '/' || *p == '\0') {
+            if (count == MQTT_SUBS_MAX_LEVELS) {
+                return -1;
+            }
+            level[count] = start;
+            level_len[count] = (uint8_t)(p - start);
+            count++;
+            if (*p == '\0') {
+                return count;
+            }
+            start = p + 1;
+        }
+    }
+}
+
+// 원하는 토픽을 필터로 묶음: 첫 단계와 단계 수가 같은 토픽끼리, 서로 다른 단계는 '+'
+static void mqtt_subs_build(MqttSubscriptions& subs) {
+    subs.filter_count = subs.explicit_count;
+    bool assigned[MQTT_SUBS_MAX] = {};
+    
+    for (int i = 0; i < subs.topic_count; i++) {
+        if (assigned[i]) {
+            continue;
+        }
+        
+        // 직접 추가한 필터가 덮는 토픽은 따로 구독하지 않음
+        bool covered = false;
+        for (int f = 0; f < subs.explicit_count && !covered; f++) {
+            covered = mqtt_topic_matches(subs.filters[f].filter, subs.topics[i]);
+        }
+        if (covered) {
+            assigned[i] = true;
+            continue;
+        }
+        
+        const char* level[MQTT_SUBS_MAX_LEVELS];
+        uint8_t level_len[MQTT_SUBS_MAX_LEVELS];
+        int levels = topic_split(subs.topics[i], level, level_len);
+        bool wild[MQTT_SUBS_MAX_LEVELS] = {};
+        uint8_t qos = subs.topic_qos[i];
+        assigned[i] = true;
+        
+        for (int j = i + 1; subs.collapse && levels > 1 && j < subs.topic_count; j++) {
+            if (assigned[j]) {
+                continue;
+            }
+            const char* other[MQTT_SUBS_MAX_LEVELS];
+            uint8_t other_len[MQTT_SUBS_MAX_LEVELS];
+            if (topic_split(subs.topics[j], other, other_len) != levels ||
+                other_len[0] != level_len[0] || memcmp(other[0], level[0], level_len[0]) != 0) {
+                continue;
+            }
+            for (int l = 1; l < levels; l++) {
+                if (other_len[l] != level_len[l] || memcmp(other[l], level[l], level_len[l]) != 0) {
+                    wild[l] = true;
+                }
+            }
+            if (subs.topic_qos[j] > qos) {
+                qos = subs.topic_qos[j];
+            }
+            assigned[j] = true;
+        }
+        
+        // 필터 문자열 작성 (단계 수 초과 토픽은 그대로)
+        MqttSubFilter& out = subs.filters[subs.filter_count++];
+        out.qos = qos;
+        out.subscribed = false;
+        if (levels < 0) {
+            snprintf(out.filter, sizeof(out.filter), "%s", subs.topics[i]);
+            continue;
+        }
+        char* p = out.filter;
+        for (int l = 0; l < levels; l++) {
+            if (l > 0) {
+                *p++ = '/';
+            }
+            if (wild[l]) {
+                *p++ = '+';
+            } else {
+                memcpy(p, level[l], level_len[l]);
+                p += level_len[l];
+            }
+        }
+        *p = '\0';
+    }
+    subs.dirty = false;
     
-    char cmd[MAX_AT_COMMAND_LEN];
-    
-    // RX 버퍼 클리어
-    uart_clear_rx_buffer();
-    sleep_ms(100);
-    
-    // MQTTPUBRAW 명령 전송
-    int cmd_len = snprintf(cmd, sizeof(cmd), "AT+MQTTPUBRAW=0,\"%s\",%d,%d,%d",
-                           topic, msg_len, qos, retain);
-    if (cmd_len >= (int)sizeof(cmd)) {
-        printf("[MQTT] 발행 명령어 버퍼 오버플로우\n");
+    printf("[MQTT] 구독 토픽 %d개 → 필터 %d개\n", subs.topic_count, subs.filter_count);
+    for (int f = 0; f < subs.filter_count; f++) {
+        printf("[MQTT]   %s (QoS %d)\n", subs.filters[f].filter, subs.filters[f].qos);
+    }
+}
+
+void mqtt_subs_init(MqttSubscriptions& subs, bool collapse) {
+    memset(&subs, 0, sizeof(subs));
+    subs.collapse = collapse;
+}
+
+bool mqtt_subs_add(MqttSubscriptions& subs, const char* topic, int qos) {
+    // NULL 포인터, 개수, 길이 검증 (원하는 토픽에는 와일드카드 불가)
+    if (!topic || qos < 0 || qos > 2 || strlen(topic) == 0 || strlen(topic) >= MQTT_SUBS_FILTER_MAX ||
+        strpbrk(topic, "+#")) {
+        printf("[MQTT] 유효하지 않은 구독 토픽\n");
         return false;
     }
-    
-    uart_send_at_command(cmd);
-    
-    // ">" 프롬프트 대기
-    if (!uart_wait_response(">", 2000)) {
-        printf("[MQTT] 발행 준비 실패 (연결 끊김 가능성)\n");
-        client.connected = false;  // 연결 상태 플래그 업데이트
+    if (subs.topic_count + subs.explicit_count >= MQTT_SUBS_MAX) {
+        printf("[MQTT] 구독 토픽 수 초과: %s\n", topic);
+        return false;
+    }
+    subs.topics[subs.topic_count] = topic;
+    subs.topic_qos[subs.topic_count] = (uint8_t)qos;
+    subs.topic_count++;
+    subs.dirty = true;
+    return true;
+}
+
+bool mqtt_subs_add_filter(MqttSubscriptions& subs, const char* filter, int qos) {
+    // NULL 포인터, 개수, 길이 검증
+    if (!filter || qos < 0 || qos > 2 || strlen(filter) == 0 || strlen(filter) >= MQTT_SUBS_FILTER_MAX) {
+        printf("[MQTT] 유효하지 않은 구독 필터\n");
+        return false;
+    }
+    if (subs.topic_count + subs.explicit_count >= MQTT_SUBS_MAX) {
+        printf("[MQTT] 구독 필터 수 초과: %s\n", filter);
         return false;
     }
+    MqttSubFilter& f = subs.filters[subs.explicit_count++];
+    snprintf(f.filter, sizeof(f.filter), "%s", filter);
+    f.qos = (uint8_t)qos;
+    f.subscribed = false;
+    subs.dirty = true;
+    return true;
+}
+
+static void mqtt_subs_submit(MqttClient& client, MqttSubscriptions& subs);
+
+static void on_subs_done(int result, void* user) {
+    MqttSubscriptions& subs = *(MqttSubscriptions*)user;
+    MqttClient& client = *subs.client;
     
-    // 약간의 지연 후 메시지 전송 (race condition 방지: 버퍼 클리어 제거)
-    sleep_ms(50);
+    MqttSubFilter& f = subs.filters[subs.in_flight[subs.in_flight_tail++ % AT_QUEUE_LEN]];
+    if (result == 0) {
+        f.subscribed = true;
+    } else {
+        printf("[MQTT] 구독 실패: %s\n", f.filter);
+        subs.failed++;
+    }
     
-    // 메시지 전송 (개행 없이)
-    uart_send_raw(message, msg_len);
+    // 빈 큐 자리에 다음 필터 제출 (응답 직후 바로 다음 명령)
+    mqtt_subs_submit(client, subs);
+    if (!mqtt_subs_busy(subs)) {
+        subs.last_apply_us = time_us_32() - subs.start_us;
+        printf("[MQTT] 구독 필터 %d개 완료 (실패 %d): %lu ms\n", subs.filter_count, subs.failed,
+               (unsigned long)(subs.last_apply_us / 1000));
+    }
+}
+
+// 구독 안 된 필터를 전송 계층이 허용하는 만큼 지연 없이 제출
+static void mqtt_subs_submit(MqttClient& client, MqttSubscriptions& subs) {
+    while (subs.next < subs.filter_count && mqtt_submit_room(client) > 0) {
+        uint8_t idx = subs.next;
+        MqttSubFilter& f = subs.filters[idx];
+        if (f.subscribed) {
+            subs.next++;
+            continue;
+        }
+        
+        if (!client.connected) {
+            printf("[MQTT] 연결되지 않음\n");
+            subs.next = subs.filter_count;  // 남은 필터는 재연결 후 다시
+            subs.failed++;
+            return;
+        }
+        subs.next++;
+        if (!mqtt_submit_subscribe(client, f.filter, f.qos, on_subs_done, &subs)) {
+            subs.failed++;
+            continue;
+        }
+        subs.in_flight[subs.in_flight_head++ % AT_QUEUE_LEN] = idx;
+    }
+}
+
+static bool mqtt_subs_begin(MqttClient& client, MqttSubscriptions& subs, bool all) {
+    if (mqtt_subs_busy(subs)) {
+        printf("[MQTT] 구독 진행 중\n");
+        return false;
+    }
+    if (subs.dirty) {
+        mqtt_subs_build(subs);
+    }
+    if (all) {
+        for (int f = 0; f < subs.filter_count; f++) {
+            subs.filters[f].subscribed = false;
+        }
+    }
+    subs.client = &client;
+    subs.next = 0;
+    subs.failed = 0;
+    subs.start_us = time_us_32();
+    mqtt_subs_submit(client, subs);
+    
+    // 하나도 제출하지 못했으면 (큐 가득 참) 호출 측이 나중에 다시 시도
+    if (subs.next < subs.filter_count && !mqtt_subs_busy(subs)) {
+        printf("[MQTT] 구독 제출 실패 - 큐 가득 참\n");
+        subs.next = 0;
+        return false;
+    }
+    return true;
+}
+
+bool mqtt_subs_start(MqttClient& client, MqttSubscriptions& subs) {
+    return mqtt_subs_begin(client, subs, true);
+}
+
+bool mqtt_subs_retry(MqttClient& client, MqttSubscriptions& subs) {
+    return mqtt_subs_begin(client, subs, false);
+}
+
+bool mqtt_subs_busy(const MqttSubscriptions& subs) {
+    // 완료 콜백이 빈자리에 다음 필터를 제출하므로 제출된 필터가 없으면 끝남
+    return subs.in_flight_head != subs.in_flight_tail;
+}
+
+int mqtt_subs_failed(const MqttSubscriptions& subs) {
+    return subs.failed;
+}
+
+bool mqtt_subs_apply(MqttClient& client, MqttSubscriptions& subs) {
+    AtEngine* at = client.link ? client.link->at : NULL;
+    if (!at) {
+        printf("[MQTT] 오류: UART 링크 또는 AT 엔진 없음\n");
+        return false;
+    }
+    if (!mqtt_subs_start(client, subs)) {
+        return false;
+    }
+    while (mqtt_subs_busy(subs)) {
+        at_engine_poll(*at);
+        mqtt_transport_poll(client);
+        uart_wait_event(at->deadline);
+    }
+    return subs.failed == 0;
+}
+
+bool mqtt_subs_wanted(const MqttSubscriptions& subs, const char* topic) {
+    // NULL 포인터 검증
+    if (!topic) {
+        return false;
+    }
+    for (int i = 0; i < subs.topic_count; i++) {
+        if (strcmp(subs.topics[i], topic) == 0) {
+            return true;
+        }
+    }
+    for (int f = 0; f < subs.explicit_count; f++) {
+        if (mqtt_topic_matches(subs.filters[f].filter, topic)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if !MQTT_NATIVE_TRANSPORT
+bool mqtt_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain) {
+    char cmd[MAX_AT_COMMAND_LEN];
+    AtRequest req;
+    if (!mqtt_build_publish(client, topic, message, qos, retain, cmd, req)) {
+        return false;
+    }
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
+        return false;
+    }
     
-    // 전송 완료 대기
-    if (!uart_wait_response("OK", 3000)) {
-        printf("[MQTT] 발행 실패 (연결 끊김 가능성)\n");
-        client.connected = false;  // 연결 상태 플래그 업데이트
+    // 응답 버퍼 비우기/프롬프트 대기/페이로드 전송은 엔진이 순서대로 처리 (고정 지연 없음)
+    uint32_t start_us = time_us_32();
+    int result = at_execute(*at, req);
+    mqtt_publish_record(client, result, start_us);
+    mqtt_publish_result(client, result);
+    return result == 0;
+}
+
+// 비차단 발행 제출 (발행 통계의 제출 시각 FIFO에 등록)
+bool mqtt_submit_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain,
+                         AtCallback done) {
+    char cmd[MAX_AT_COMMAND_LEN];
+    AtRequest req;
+    if (!mqtt_build_publish(client, topic, message, qos, retain, cmd, req)) {
+        return false;
+    }
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
         return false;
     }
     
-    sleep_ms(100);
-    client.last_activity = to_ms_since_boot(get_absolute_time());
+    // 토픽/메시지는 엔진 슬롯에 복사되므로 호출 직후 버퍼 재사용 가능 (슬롯보다 길면 제출 안 함)
+    if (req.payload_len > AT_PAYLOAD_MAX) {
+        printf("[MQTT] 비차단 발행 메시지 길이 초과: %u > %d\n", (unsigned)req.payload_len, AT_PAYLOAD_MAX);
+        return false;
+    }
+    req.done = done;
+    req.user = &client;
+    uint32_t start_us = time_us_32();
+    if (!at_submit(*at, req)) {
+        return false;
+    }
+    MqttPublishStats& st = client.pub_stats;
+    st.pending_start_us[st.pending_head++ % AT_QUEUE_LEN] = start_us;
     return true;
 }
+#endif // !MQTT_NATIVE_TRANSPORT
 
-bool mqtt_check_message(MqttClient& client, char* topic, int topic_max_len, char* message, int message_max_len) {
-    if (!client.connected) {
-        return false;  // MQTT 연결되지 않았으면 메시지 체크 안 함
+bool mqtt_publish_async(MqttClient& client, const char* topic, const char* message, int qos, int retain) {
+    return mqtt_submit_publish(client, topic, message, qos, retain, on_publish_done);
+}
+
+// ===== 발신 큐 =====
+static MqttOutboxEntry& outbox_at(MqttOutbox& ob, uint32_t i) {
+    return ob.entries[(ob.head + i) % MQTT_OUTBOX_LEN];
+}
+
+static void outbox_pump(MqttClient& client);
+
+// 결과를 받은 맨 앞 항목을 다시 보낼 때: 뒤 항목들이 이미 제출돼 있으면 그 뒤(다음 제출 위치)로 옮김
+// (결과는 제출 순서대로 도착하므로 맨 앞 = 다음 결과의 주인이 되도록 유지)
+static void outbox_requeue_head(MqttOutbox& ob) {
+    if (ob.in_flight == 0) {
+        return;
+    }
+    MqttOutboxEntry failed = outbox_at(ob, 0);
+    for (uint32_t i = 0; i < ob.in_flight; i++) {
+        outbox_at(ob, i) = outbox_at(ob, i + 1);
+    }
+    outbox_at(ob, ob.in_flight) = failed;
+}
+
+static void on_outbox_done(int result, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    MqttOutbox& ob = client.outbox;
+    on_publish_done(result, user);
+    
+    ob.in_flight--;     // 결과는 제출 순서대로 도착 → 맨 앞 항목(또는 보관 메시지)의 결과
+    if (result == AT_RESULT_ABORTED) {
+        // 리셋/연결 종료로 취소: 시도로 세지 않고, 취소 도중에 다시 제출하지 않음 (다음 mqtt_outbox_poll에서 재전송)
+        if (!ob.replaying) {
+            outbox_requeue_head(ob);
+        }
+        ob.replaying = false;
+        return;
+    }
+    // 실패한 메시지는 맨 앞에 남아 다시 전송, MQTT_OUTBOX_MAX_ATTEMPTS회 실패하면 버림
+    if (ob.replaying) {
+        // 보관 메시지는 성공하거나 버릴 때만 완료 표시, 그 외에는 같은 메시지부터
+        ob.replaying = false;
+        bool give_up = (result != 0 && ++ob.replay_attempts >= MQTT_OUTBOX_MAX_ATTEMPTS);
+        if (give_up) {
+            printf("[MQTT] 보관 메시지 전달 포기 (%u회 실패)\n", ob.replay_attempts);
+            ob.dropped++;
+        }
+        if ((result == 0 || give_up) && client.store) {
+            mqtt_store_ack(*client.store);
+            ob.replay_attempts = 0;
+        }
+    } else if (result == 0) {
+        ob.head = (ob.head + 1) % MQTT_OUTBOX_LEN;
+        ob.count--;
+        ob.sent++;
+    } else if (++outbox_at(ob, 0).attempts >= MQTT_OUTBOX_MAX_ATTEMPTS) {
+        printf("[MQTT] 발신 큐 항목 전달 포기 (%u회 실패): %s\n", outbox_at(ob, 0).attempts, outbox_at(ob, 0).topic);
+        ob.head = (ob.head + 1) % MQTT_OUTBOX_LEN;
+        ob.count--;
+        ob.dropped++;
+    } else {
+        outbox_requeue_head(ob);
+    }
+    outbox_pump(client);
+}
+
+// 맨 앞부터 제출되지 않은 항목을 MQTT_OUTBOX_PIPELINE건까지 제출 (나머지는 큐에 남아 병합 대상 유지)
+// 큐가 비어 있으면 플래시 보관 메시지를 간격을 두고 한 건씩 재전송
+static void outbox_pump(MqttClient& client) {
+    MqttOutbox& ob = client.outbox;
+    if (ob.replaying) {
+        return;
+    }
+    while (ob.in_flight < ob.count && ob.in_flight < MQTT_OUTBOX_PIPELINE &&
+           client.connected && mqtt_submit_room(client) > 0) {
+        const MqttOutboxEntry& e = outbox_at(ob, ob.in_flight);
+        if (!mqtt_submit_publish(client, e.topic, e.message, e.qos, e.retain, on_outbox_done)) {
+            return;
+        }
+        ob.in_flight++;
+    }
+    if (ob.count > 0 || ob.in_flight > 0 || !client.connected || mqtt_submit_room(client) == 0) {
+        return;
     }
     
+    if (!client.store) {
+        return;
+    }
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    if ((int32_t)(now - ob.replay_at) < 0) {
+        return;
+    }
+    MqttStoredMessage msg;
+    if (!mqtt_store_peek(*client.store, &msg)) {
+        return;
+    }
+    if (mqtt_submit_publish(client, msg.topic, msg.payload, msg.qos, msg.retain, on_outbox_done)) {
+        ob.in_flight = 1;
+        ob.replaying = true;
+        ob.replay_at = now + MQTT_STORE_REPLAY_INTERVAL_MS;
+    }
+}
+
+bool mqtt_enqueue(MqttClient& client, const char* topic, const char* message, int qos, int retain, bool coalesce) {
     // NULL 포인터 검증
     if (!topic || !message) {
-        printf("[MQTT] NULL 버퍼\n");
+        printf("[MQTT] NULL 토픽 또는 메시지\n");
         return false;
     }
     
-    char buffer[MQTT_RX_BUFFER_SIZE];  // 상수화된 버퍼 크기
-    int len = uart_read_mqtt_message(buffer, sizeof(buffer));
-    
-    if (len <= 0) {
+    // QoS/retain 검증
+    if (qos < 0 || qos > 2 || retain < 0 || retain > 1) {
+        printf("[MQTT] 유효하지 않은 QoS/retain: %d/%d\n", qos, retain);
         return false;
     }
     
-    // +MQTTSUBRECV:0,"topic",data_len,data 파싱
-    char* p = strstr(buffer, "+MQTTSUBRECV:");
-    if (!p) {
-        printf("[MQTT] 메시지 포맷 오류: MQTTSUBRECV 없음\n");
+    // 길이 검증 (큐 항목에 복사)
+    size_t topic_len = strlen(topic);
+    size_t msg_len = strlen(message);
+    if (topic_len == 0 || topic_len >= MQTT_OUTBOX_TOPIC_MAX || msg_len > MQTT_OUTBOX_MSG_MAX) {
+        printf("[MQTT] 발신 큐 길이 초과: 토픽 %u, 메시지 %u\n", (unsigned)topic_len, (unsigned)msg_len);
         return false;
     }
     
-    // 링크 ID 건너뛰기 (0)
-    p = strchr(p, ',');
-    if (!p) {
-        printf("[MQTT] 메시지 포맷 오류: 링크 ID 없음\n");
-        return false;
+    // 연결 끊김 중: 플래시 로그에 모든 값을 기록 (재연결 후 기록 순서대로 재전송)
+    if (!client.connected && client.store) {
+        return mqtt_store_append(*client.store, topic, message, (uint32_t)msg_len, qos, retain);
     }
-    p++;  // ',' 다음으로
     
-    // 토픽 추출: "topic"
-    char* topic_start = strchr(p, '"');
-    if (!topic_start) {
-        printf("[MQTT] 메시지 포맷 오류: 토픽 시작 없음\n");
-        return false;
+    MqttOutbox& ob = client.outbox;
+    uint32_t first = ob.replaying ? 0 : ob.in_flight;  // 제출된 항목은 이미 송신 측에 복사됨 → 병합/버림 대상 아님
+    
+    // 같은 토픽의 대기 중인 값은 새 값으로 교체 (큐 위치 유지)
+    MqttOutboxEntry* slot = NULL;
+    if (coalesce) {
+        for (uint32_t i = first; i < ob.count; i++) {
+            MqttOutboxEntry& e = outbox_at(ob, i);
+            if (e.coalesce && strcmp(e.topic, topic) == 0) {
+                slot = &e;
+                ob.coalesced++;
+                break;
+            }
+        }
     }
-    topic_start++;  // '"' 다음으로
     
-    char* topic_end = strchr(topic_start, '"');
-    if (!topic_end) {
-        printf("[MQTT] 메시지 포맷 오류: 토픽 끝 없음\n");
-        return false;
+    if (!slot) {
+        if (ob.count == MQTT_OUTBOX_LEN) {
+            if (first >= ob.count) {
+                return false;  // 버릴 수 있는 항목 없음
+            }
+            // 가득 참: 가장 오래된 대기 항목을 버리고 당김
+            for (uint32_t i = first; i + 1 < ob.count; i++) {
+                outbox_at(ob, i) = outbox_at(ob, i + 1);
+            }
+            ob.count--;
+            ob.dropped++;
+        }
+        slot = &outbox_at(ob, ob.count++);
+        memcpy(slot->topic, topic, topic_len + 1);
+        slot->coalesce = coalesce;
+        slot->attempts = 0;
     }
     
-    int topic_len = topic_end - topic_start;
-    if (topic_len >= topic_max_len) {
-        printf("[MQTT] 토픽 버퍼 오버플로우: %d >= %d\n", topic_len, topic_max_len);
+    memcpy(slot->message, message, msg_len + 1);
+    slot->qos = (uint8_t)qos;
+    slot->retain = (uint8_t)retain;
+    
+    outbox_pump(client);
+    return true;
+}
+
+// ===== QoS 1 발행 추적 =====
+static void qos1_pump(MqttClient& client);
+
+static void on_qos1_done(int result, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    MqttQos1& q = client.qos1;
+    on_publish_done(result, user);
+    
+    // 전송 계층은 제출 순서대로 완료하므로 가장 오래된 제출 슬롯이 이 결과의 대상
+    if (q.order_tail == q.order_head) {
+        return;
+    }
+    MqttQos1Message& m = q.slots[q.order[q.order_tail++ % MQTT_QOS1_SLOTS]];
+    
+    if (result == 0) {
+        q.delivered++;
+        m.state = MQTT_QOS1_FREE;
+        if (m.done) {
+            m.done(true, m.user);
+        }
+    } else if (result == AT_RESULT_ABORTED) {
+        // 모듈 리셋/큐 비움 등 로컬에서 취소된 전송만 시도로 세지 않음 (전송 계층 시간 초과는 아래에서 셈)
+        // 취소 도중(at_engine_flush 안)에 다시 제출하지 않고 다음 mqtt_outbox_poll에서 재전송
+        m.attempts--;
+        m.state = MQTT_QOS1_WAITING;
+        return;
+    } else if (m.attempts >= MQTT_QOS1_MAX_ATTEMPTS) {
+        printf("[MQTT] QoS 1 전달 포기 (%u회 실패): %s\n", m.attempts, m.topic);
+        q.expired++;
+        m.state = MQTT_QOS1_FREE;
+        if (m.done) {
+            m.done(false, m.user);
+        }
+    } else {
+        // 슬롯에 남겨 두고 재연결 후 재전송
+        m.state = MQTT_QOS1_WAITING;
+    }
+    qos1_pump(client);
+}
+
+// 전송 대기 메시지를 등록 순서대로 전송 계층 여유만큼 제출 (응답을 기다리지 않고 여러 건)
+static void qos1_pump(MqttClient& client) {
+    MqttQos1& q = client.qos1;
+    
+    while (client.connected && mqtt_submit_room(client) > 0) {
+        MqttQos1Message* oldest = NULL;
+        for (uint32_t i = 0; i < MQTT_QOS1_SLOTS; i++) {
+            MqttQos1Message& m = q.slots[i];
+            if (m.state == MQTT_QOS1_WAITING && (!oldest || (int32_t)(m.seq - oldest->seq) < 0)) {
+                oldest = &m;
+            }
+        }
+        if (!oldest) {
+            return;
+        }
+        if (!mqtt_submit_publish(client, oldest->topic, oldest->message, 1, oldest->retain, on_qos1_done)) {
+            return;
+        }
+        if (oldest->attempts > 0) {
+            q.retransmits++;
+        }
+        oldest->attempts++;
+        oldest->state = MQTT_QOS1_SENT;
+        q.order[q.order_head++ % MQTT_QOS1_SLOTS] = (uint8_t)(oldest - q.slots);
+    }
+}
+
+bool mqtt_publish_qos1(MqttClient& client, const char* topic, const char* message, int retain,
+                       MqttDeliveryCallback done, void* user) {
+    // NULL 포인터 / retain 검증
+    if (!topic || !message || retain < 0 || retain > 1) {
+        printf("[MQTT] 유효하지 않은 QoS 1 발행\n");
         return false;
     }
     
-    strncpy(topic, topic_start, topic_len);
-    topic[topic_len] = '\0';
+    // 길이 검증 (슬롯에 복사)
+    size_t topic_len = strlen(topic);
+    size_t msg_len = strlen(message);
+    if (topic_len == 0 || topic_len >= MQTT_OUTBOX_TOPIC_MAX || msg_len > MQTT_OUTBOX_MSG_MAX) {
+        printf("[MQTT] QoS 1 길이 초과: 토픽 %u, 메시지 %u\n", (unsigned)topic_len, (unsigned)msg_len);
+        return false;
+    }
     
-    // 데이터 길이 파싱: ,len,
-    p = strchr(topic_end + 1, ',');
-    if (!p) {
-        printf("[MQTT] 메시지 포맷 오류: 데이터 길이 구분자 없음\n");
+    MqttQos1& q = client.qos1;
+    MqttQos1Message* slot = NULL;
+    for (uint32_t i = 0; i < MQTT_QOS1_SLOTS && !slot; i++) {
+        if (q.slots[i].state == MQTT_QOS1_FREE) {
+            slot = &q.slots[i];
+        }
+    }
+    if (!slot) {
+        printf("[MQTT] QoS 1 슬롯 가득 참: %s\n", topic);
         return false;
     }
-    p++;  // ',' 다음으로
     
-    // 정수 오버플로우 방지
-    int data_len = 0;
-    int digit_count = 0;
-    char* buffer_end = buffer + len;  // 버퍼 끝 포인터
+    memcpy(slot->topic, topic, topic_len + 1);
+    memcpy(slot->message, message, msg_len + 1);
+    slot->retain = (uint8_t)retain;
+    slot->attempts = 0;
+    slot->seq = q.next_seq++;
+    slot->done = done;
+    slot->user = user;
+    slot->state = MQTT_QOS1_WAITING;
     
-    while (*p >= '0' && *p <= '9' && p < buffer_end) {
-        // INT_MAX 근처에서 오버플로우 방지
-        if (data_len > (INT_MAX - 10) / 10) {
-            printf("[MQTT] 데이터 길이 정수 오버플로우\n");
-            return false;
+    qos1_pump(client);
+    return true;
+}
+
+uint32_t mqtt_qos1_pending(const MqttClient& client) {
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < MQTT_QOS1_SLOTS; i++) {
+        if (client.qos1.slots[i].state != MQTT_QOS1_FREE) {
+            n++;
         }
-        
-        data_len = data_len * 10 + (*p - '0');
-        p++;
-        digit_count++;
-        
-        // 비정상적으로 긴 숫자 문자열 방지 (최대 10자리)
-        if (digit_count > 10) {
-            printf("[MQTT] 데이터 길이 필드 너무 김\n");
-            return false;
+    }
+    return n;
+}
+
+void mqtt_outbox_poll(MqttClient& client) {
+    if (client.store) {
+        mqtt_store_poll(*client.store);
+    }
+    mqtt_transport_poll(client);
+    qos1_pump(client);
+    outbox_pump(client);
+}
+
+void mqtt_get_publish_latency(MqttClient& client, MqttPublishLatency* out) {
+    // NULL 포인터 검증
+    if (!out) {
+        return;
+    }
+    
+    const MqttPublishStats& st = client.pub_stats;
+    uint32_t n = st.sample_count < MQTT_PUB_LATENCY_SAMPLES ? st.sample_count : MQTT_PUB_LATENCY_SAMPLES;
+    
+    // 표본 복사 후 삽입 정렬 (최대 128개, 조회 시에만)
+    uint32_t sorted[MQTT_PUB_LATENCY_SAMPLES];
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t v = st.samples_us[i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
         }
+        sorted[j] = v;
     }
     
-    // 버퍼 끝을 넘어선 경우
-    if (p >= buffer_end) {
-        printf("[MQTT] 파싱 중 버퍼 오버런\n");
+    out->published = st.published;
+    out->failed = st.failed;
+    out->samples = n;
+    out->p50_us = n ? sorted[(n - 1) / 2] : 0;
+    out->p99_us = n ? sorted[(n * 99 + 99) / 100 - 1] : 0;
+    out->max_us = n ? sorted[n - 1] : 0;
+}
+
+void mqtt_reset_publish_stats(MqttClient& client) {
+    MqttPublishStats& st = client.pub_stats;
+    st.published = 0;
+    st.failed = 0;
+    st.sample_count = 0;
+}
+
+bool mqtt_peek_message(MqttClient& client, UartMqttFrame* msg) {
+    if (!client.connected) {
+        return false;  // MQTT 연결되지 않았으면 메시지 체크 안 함
+    }
+    
+    // NULL 포인터 검증
+    if (!msg) {
+        printf("[MQTT] NULL 메시지 뷰\n");
         return false;
     }
     
-    if (*p != ',') {
-        printf("[MQTT] 메시지 포맷 오류: 데이터 시작 구분자 없음\n");
+    // 헤더 해석과 길이만큼의 페이로드 수신은 URC 프레이머가 끝낸 상태
+    if (!uart_peek_mqtt_frame(*client.link, msg)) {
         return false;
     }
-    p++;  // ',' 다음으로 (데이터 시작)
     
-    // 메시지 데이터 복사
-    if (data_len >= message_max_len) {
-        printf("[MQTT] 메시지 버퍼 오버플로우: %d >= %d\n", data_len, message_max_len);
-        // 잘라서라도 복사
-        data_len = message_max_len - 1;
+    client.last_activity = to_ms_since_boot(get_absolute_time());
+    return true;
+}
+
+void mqtt_release_message(MqttClient& client) {
+    uart_release_mqtt_frame(*client.link);
+}
+
+bool mqtt_register_stream(MqttClient& client, const char* topic, const UartStreamHandler* handler) {
+    if (!client.link) {
+        printf("[MQTT] NULL 링크\n");
+        return false;
+    }
+    if (topic && strlen(topic) >= MAX_TOPIC_LEN) {
+        printf("[MQTT] 토픽 길이 초과\n");
+        return false;
+    }
+    return uart_register_stream(*client.link, topic, handler);
+}
+
+bool mqtt_check_message(MqttClient& client, char* topic, int topic_max_len, char* message, int message_max_len) {
+    // NULL 포인터 검증
+    if (!topic || !message || topic_max_len <= 0 || message_max_len <= 0) {
+        printf("[MQTT] NULL 버퍼\n");
+        return false;
     }
     
-    // 실제 남은 데이터 길이 확인
-    int remaining = buffer_end - p;
-    if (remaining < data_len) {
-        printf("[MQTT] 경고: 예상 길이(%d)보다 실제 데이터 적음(%d) - 자동 조정\n", data_len, remaining);
-        printf("[MQTT] 디버그: 원본 버퍼 길이=%d, 파싱 위치=%ld\n", len, (long)(p - buffer));
-        data_len = remaining;
+    UartMqttFrame msg;
+    if (!mqtt_peek_message(client, &msg)) {
+        return false;
     }
     
-    // 음수 길이 방지
-    if (data_len < 0) {
-        printf("[MQTT] 유효하지 않은 데이터 길이: %d\n", data_len);
+    if ((int)msg.topic_len >= topic_max_len) {
+        printf("[MQTT] 토픽 버퍼 오버플로우: %u >= %d\n", (unsigned)msg.topic_len, topic_max_len);
+        mqtt_release_message(client);
         return false;
     }
+    memcpy(topic, msg.topic, msg.topic_len + 1);
     
-    if (data_len > 0) {
-        memcpy(message, p, data_len);
-        message[data_len] = '\0';
-    } else {
-        message[0] = '\0';
+    // 메시지 데이터 복사
+    uint32_t data_len = msg.payload_len;
+    if (data_len >= (uint32_t)message_max_len) {
+        printf("[MQTT] 메시지 버퍼 오버플로우: %u >= %d\n", (unsigned)data_len, message_max_len);
+        // 잘라서라도 복사
+        data_len = message_max_len - 1;
     }
+    memcpy(message, msg.payload, data_len);
+    message[data_len] = '\0';
     
-    printf("[MQTT] 파싱 성공 - 토픽: %s, 길이: %d\n", topic, data_len);
-    client.last_activity = to_ms_since_boot(get_absolute_time());
+    mqtt_release_message(client);
+    printf("[MQTT] 파싱 성공 - 토픽: %s, 길이: %u\n", topic, (unsigned)data_len);
     return true;
 }
 
@@ -380,23 +1260,21 @@ bool mqtt_is_connected(MqttClient& client) {
     return client.connected;
 }
 
+#if !MQTT_NATIVE_TRANSPORT
 bool mqtt_check_connection(MqttClient& client) {
     if (!client.connected) {
         return false;
     }
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
+        return false;
+    }
     
     // AT+MQTTCONN? 명령으로 실제 연결 상태 확인
-    uart_clear_rx_buffer();
-    sleep_ms(50);
-    uart_send_at_command("AT+MQTTCONN?");
-    
-    // +MQTTCONN:0,0,"","",1883,0 응답 대기 (0=연결됨, 1=연결끊김)
-    if (uart_wait_response("+MQTTCONN:", 2000)) {
-        const char* resp = uart_get_rx_buffer();
-        if (resp && strstr(resp, ",0,")) {
-            // 첫 번째 파라미터가 0이면 연결됨
-            return true;
-        }
+    // +MQTTCONN:0,<state>,... 응답에서 상태까지 한 번에 판별
+    int result = at_command(*at, "AT+MQTTCONN?", CONN_STATE_RESULT, 5, 2000);
+    if (result >= 0 && result <= 2) {
+        return true;
     }
     
     // 연결 상태 플래그 업데이트
@@ -404,23 +1282,43 @@ bool mqtt_check_connection(MqttClient& client) {
     return false;
 }
 
+bool mqtt_check_connection_async(MqttClient& client) {
+    if (!client.connected) {
+        return false;
+    }
+    AtEngine* at = mqtt_engine(client);
+    if (!at) {
+        return false;
+    }
+    
+    AtRequest req = {};
+    req.cmd = "AT+MQTTCONN?";
+    req.tokens = CONN_STATE_RESULT;
+    req.token_count = 5;
+    req.timeout_ms = 2000;
+    req.done = on_conn_state_done;
+    req.user = &client;
+    return at_submit(*at, req);
+}
+
 bool mqtt_reconnect(MqttClient& client) {
     printf("[MQTT] 재연결 시도...\n");
     
-    // 기존 연결 정리
+    // 기존 연결 정리 (해제 후 1초 간격)
+    uint32_t delay_ms = 0;
     if (client.connected) {
         mqtt_disconnect(client);
-        sleep_ms(1000);
+        delay_ms = 1000;
     }
     
-    // 재연결 시도 (3회)
+    // 재연결 시도 (3회, 시도 사이 간격은 엔진 전송 지연 - 대기 중에도 URC 분배)
     for (int i = 0; i < 3; i++) {
-        if (mqtt_connect(client)) {
+        if (mqtt_connect_after(client, delay_ms)) {
             printf("[MQTT] 재연결 성공\n");
             return true;
         }
         printf("[MQTT] 재연결 실패 (시도 %d/3)\n", i + 1);
-        sleep_ms(2000);
+        delay_ms = 2000;
     }
     
     printf("[MQTT] 재연결 최종 실패\n");
@@ -429,8 +1327,8 @@ bool mqtt_reconnect(MqttClient& client) {
 
 void mqtt_disconnect(MqttClient& client) {
     if (client.connected) {
-        uart_send_at_command("AT+MQTTCLEAN=0");
-        if (!uart_wait_response("OK", 2000)) {
+        AtEngine* at = mqtt_engine(client);
+        if (at && at_command(*at, "AT+MQTTCLEAN=0", AT_RESULT, 2, 2000) != 0) {
             printf("[MQTT] 연결 해제 실패 (타임아웃)\n");
         }
         client.connected = false;
@@ -438,22 +1336,9 @@ void mqtt_disconnect(MqttClient& client) {
     }
 }
 
-void mqtt_keepalive(MqttClient& client) {
-    if (!client.connected) {
-        return;
-    }
-    
-    uint32_t now = to_ms_since_boot(get_absolute_time());
-    uint32_t elapsed = now - client.last_activity;
-    
-    // 30초 이상 활동 없으면 keepalive 메시지 발송
-    if (elapsed > 30000) {
-        // 빈 메시지를 LWT 토픽으로 발송 (keepalive 목적)
-        if (mqtt_publish(client, client.lwt_topic, "keepalive", 0, 0)) {
-            printf("[MQTT] Keepalive 전송 성공\n");
-        } else {
-            printf("[MQTT] Keepalive 실패 - 연결 끊김 가능성\n");
-            client.connected = false;
-        }
-    }
+void mqtt_link_reset(MqttClient& client) {
+    // 모듈이 MQTT 세션을 들고 있으므로 상태 플래그만 내림 (재연결 시 URC 재등록)
+    client.connected = false;
 }
+
+#endif // !MQTT_NATIVE_TRANSPORT
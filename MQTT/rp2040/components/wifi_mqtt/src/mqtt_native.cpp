@@ -0,0 +1,799 @@
+#include "mqtt_client.h"
+#include "mqtt_transport.h"
+#include "mqtt_packet.h"
+#include "uart_comm.h"
+#include "at_engine.h"
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#if MQTT_NATIVE_TRANSPORT
+
+// 네이티브 전송: ESP-01은 TCP 투명 전송 파이프로만 쓰고 MQTT 3.1.1 패킷은 직접 작성/해석
+// - 연결: AT+CIPMODE=1 → AT+CIPSTART="TCP" → AT+CIPSEND('>') 후 CONNECT/CONNACK
+// - 발행/구독은 명령-응답 왕복 없이 패킷을 연달아 송신, PUBACK/SUBACK은 패킷 ID로 대조
+// - 투명 전송 중 ESP-AT은 TCP가 끊겨도 스스로 다시 연결하고 알리지 않으므로
+//   연결 끊김은 PINGRESP/확인 시간 초과로 판단 → "+++"로 명령 모드 복귀 후 AT+CIPCLOSE
+
+#define MAX_CLIENT_ID_LEN 64
+#define MAX_USERNAME_LEN 64
+#define MAX_PASSWORD_LEN 64
+#define MAX_BROKER_LEN 128
+#define MAX_LWT_MESSAGE_LEN 128
+
+// CIPSTART 명령 / CONNECT 패킷 버퍼
+#define START_CMD_LEN (MAX_BROKER_LEN + 32)
+#define CONNECT_PACKET_MAX (16 + MAX_CLIENT_ID_LEN + MAX_TOPIC_LEN + MAX_LWT_MESSAGE_LEN + \
+                            MAX_USERNAME_LEN + MAX_PASSWORD_LEN)
+
+// 명령 결과 토큰 (AT 엔진 결과 인덱스)
+static const char* const AT_RESULT[] = { "OK", "ERROR" };
+static const char* const CIPSEND_RESULT[] = { ">", "ERROR" };
+
+// 차단 래퍼용 완료 상태
+typedef struct {
+    bool done;
+    int result;
+} NativeWait;
+
+static void on_native_blocking_done(int result, void* user) {
+    NativeWait* wait = (NativeWait*)user;
+    wait->result = result;
+    wait->done = true;
+}
+
+static inline uint32_t now_ms() {
+    return to_ms_since_boot(get_absolute_time());
+}
+
+static inline bool ms_reached(uint32_t deadline_ms) {
+    return (int32_t)(now_ms() - deadline_ms) >= 0;
+}
+
+// 링크에 연결된 AT 엔진 (없으면 NULL)
+static AtEngine* native_engine(MqttClient& client) {
+    if (!client.link || !client.link->at) {
+        printf("[MQTT] 오류: UART 링크 또는 AT 엔진 없음\n");
+        return NULL;
+    }
+    return client.link->at;
+}
+
+// 차단 함수 호출 가능 여부 (완료 콜백 안에서는 엔진이 진행되지 않아 영원히 대기하게 됨)
+static bool native_can_block(MqttClient& client) {
+    if (client.link && client.link->at && client.link->at->in_poll) {
+        printf("[MQTT] 오류: 완료 콜백 안에서 차단 호출\n");
+        return false;
+    }
+    return true;
+}
+
+
+// ===== 완료 대기 요청 =====
+static uint16_t native_packet_id(MqttClient& client) {
+    MqttNative& n = client.native;
+    if (++n.next_packet_id == 0) {
+        n.next_packet_id = 1;   // 0은 MQTT에서 쓰지 않음
+    }
+    return n.next_packet_id;
+}
+
+static bool native_queue_full(MqttClient& client) {
+    return client.native.req_head - client.native.req_tail >= AT_QUEUE_LEN;
+}
+
+static void native_push(MqttClient& client, AtCallback done, void* user, uint16_t packet_id, int result) {
+    MqttNative& n = client.native;
+    MqttNativeRequest& r = n.requests[n.req_head++ % AT_QUEUE_LEN];
+    r.done = done;
+    r.user = user;
+    r.packet_id = packet_id;
+    r.result = (int8_t)result;
+    r.deadline_ms = now_ms() + MQTT_NATIVE_ACK_TIMEOUT_MS;
+}
+
+// 맨 앞부터 결과가 정해진 요청의 완료 콜백 호출 (제출 순서 유지)
+static void native_complete(MqttClient& client) {
+    MqttNative& n = client.native;
+    while (n.req_tail != n.req_head) {
+        MqttNativeRequest& r = n.requests[n.req_tail % AT_QUEUE_LEN];
+        if (r.result == AT_RESULT_PENDING) {
+            return;
+        }
+        AtCallback done = r.done;
+        void* user = r.user;
+        int result = r.result;
+        n.req_tail++;
+        if (done) {
+            done(result, user);
+        }
+    }
+}
+
+// PUBACK/SUBACK 대조 (브로커가 순서를 바꿔 보내도 패킷 ID로 찾음)
+static void native_ack(MqttClient& client, uint16_t packet_id, int result) {
+    MqttNative& n = client.native;
+    for (uint32_t i = n.req_tail; i != n.req_head; i++) {
+        MqttNativeRequest& r = n.requests[i % AT_QUEUE_LEN];
+        if (r.packet_id == packet_id && r.result == AT_RESULT_PENDING) {
+            r.result = (int8_t)result;
+            break;
+        }
+    }
+    native_complete(client);
+}
+
+// ===== 연결 종료 =====
+
+// 투명 전송 종료 시작 ("+++" 단계는 mqtt_transport_poll이 진행)
+// 확인 대기 요청은 모두 result로 완료: 로컬 종료/리셋은 AT_RESULT_ABORTED (시도로 세지 않음),
+// 확인/PINGRESP 시간 초과·송신 실패 등 전송 실패는 AT_RESULT_TIMEOUT (QoS 1/발신 큐가 시도로 셈)
+static void native_close(MqttClient& client, int result) {
+    MqttNative& n = client.native;
+    if (n.phase != MQTT_NATIVE_CONNACK && n.phase != MQTT_NATIVE_ONLINE) {
+        return;
+    }
+    client.connected = false;
+    n.ping_pending = false;
+    n.phase = MQTT_NATIVE_EXIT_GUARD;
+    n.phase_deadline_ms = now_ms() + MQTT_NATIVE_EXIT_GUARD_MS;
+
+    for (uint32_t i = n.req_tail; i != n.req_head; i++) {
+        MqttNativeRequest& r = n.requests[i % AT_QUEUE_LEN];
+        if (r.result == AT_RESULT_PENDING) {
+            r.result = (int8_t)result;
+        }
+    }
+    native_complete(client);
+}
+
+// 패킷(또는 조각) 송신, TX가 멈춰 넣지 못하면 연결 종료
+// (앞 조각만 나간 패킷은 브로커와의 바이트 스트림을 깨뜨리므로 세션을 이어갈 수 없음)
+static bool native_send(MqttClient& client, const void* data, uint32_t len) {
+    if (!uart_send_raw(*client.link, (const char*)data, (int)len)) {
+        printf("[MQTT] 패킷 송신 실패 - 연결 끊김\n");
+        native_close(client, AT_RESULT_TIMEOUT);
+        return false;
+    }
+    client.last_activity = now_ms();
+    return true;
+}
+
+// 명령 모드에서 TCP 소켓 정리 (연결이 없으면 ERROR - 결과 무시)
+static void native_submit_cipclose(MqttClient& client) {
+    AtRequest req = {};
+    req.cmd = "AT+CIPCLOSE";
+    req.tokens = AT_RESULT;
+    req.token_count = 2;
+    req.timeout_ms = 2000;
+    if (client.link->at) {
+        at_submit(*client.link->at, req);
+    }
+}
+
+// ===== 수신 패킷 처리 =====
+static void on_native_packet(uint8_t type, uint8_t flags, const uint8_t* body, uint32_t len, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    MqttNative& n = client.native;
+
+    switch (type) {
+    case MQTT_PKT_CONNACK:
+        if (n.phase != MQTT_NATIVE_CONNACK) {
+            break;
+        }
+        if (len < 2 || body[1] != 0) {
+            printf("[MQTT] 브로커 연결 거부 (CONNACK %d)\n", len < 2 ? -1 : body[1]);
+            native_close(client, AT_RESULT_TIMEOUT);
+            break;
+        }
+        n.phase = MQTT_NATIVE_ONLINE;
+        client.connected = true;
+        printf("[MQTT] 연결 성공\n");
+
+        // 연결 성공 시 online 상태 발행 (콜백 안이므로 제출만)
+        if (!mqtt_publish_async(client, client.lwt_topic, "online", 1, 1)) {
+            printf("[MQTT] 경고: online 상태 발행 실패\n");
+        }
+        break;
+
+    case MQTT_PKT_PUBACK:
+        if (len >= 2) {
+            native_ack(client, (uint16_t)((body[0] << 8) | body[1]), 0);
+        }
+        break;
+
+    case MQTT_PKT_SUBACK:
+        // 반환 코드 0x80 = 구독 거부 (AT 전송의 ERROR와 같은 결과 1)
+        if (len >= 3) {
+            native_ack(client, (uint16_t)((body[0] << 8) | body[1]), body[2] == 0x80 ? 1 : 0);
+        }
+        break;
+
+    case MQTT_PKT_PINGRESP:
+        n.ping_pending = false;
+        break;
+
+    default:
+        // QoS 2는 요청하지 않으므로 PUBREC/PUBCOMP 등은 오지 않음
+        break;
+    }
+}
+
+// 수신 PUBLISH는 +MQTTSUBRECV와 같은 경로(스트림 또는 URC 큐)로 전달 → mqtt_peek_message 그대로 사용
+static void on_native_publish_begin(const char* topic, uint32_t topic_len, uint8_t flags, uint16_t packet_id,
+                                    uint32_t payload_len, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    // 시작 실패 시 이어지는 페이로드는 uart_mqtt_frame_data가 버림
+    uart_mqtt_frame_begin(*client.link, topic, topic_len, payload_len);
+
+    // QoS 1 메시지 확인 (구독은 QoS 1까지만 요청)
+    if (((flags >> 1) & 0x03) == 1) {
+        uint8_t ack[4];
+        native_send(client, ack, mqtt_packet_ack(ack, MQTT_PKT_PUBACK, packet_id));
+    }
+}
+
+static void on_native_publish_data(const char* data, uint32_t len, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    uart_mqtt_frame_data(*client.link, data, len);
+}
+
+// 투명 전송 수신: 줄 분배 없이 디코더로 (uart_link_poll 안, 메인 루프 컨텍스트)
+static void on_native_rx(UartSpan data, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    MqttNative& n = client.native;
+    if (n.phase != MQTT_NATIVE_CONNACK && n.phase != MQTT_NATIVE_ONLINE) {
+        return;  // 종료 중 - 남은 바이트 버림
+    }
+    if (!mqtt_packet_feed(n.decoder, (const uint8_t*)data.data, data.len)) {
+        native_close(client, AT_RESULT_TIMEOUT);  // 스트림 동기 상실 → 다시 연결
+    }
+}
+
+// ===== 연결 =====
+
+// 설정 검증 및 CIPSTART 명령 생성
+static bool native_build_start(MqttClient& client, char* cmd) {
+    // NULL 포인터 검증
+    if (!client.link || !client.broker || !client.client_id || !client.username ||
+        !client.password || !client.lwt_topic || !client.lwt_message) {
+        printf("[MQTT] NULL 포인터 오류\n");
+        return false;
+    }
+
+    // 길이 검증
+    if (strlen(client.client_id) >= MAX_CLIENT_ID_LEN ||
+        strlen(client.username) >= MAX_USERNAME_LEN ||
+        strlen(client.password) >= MAX_PASSWORD_LEN) {
+        printf("[MQTT] 사용자 정보 길이 초과\n");
+        return false;
+    }
+    if (strlen(client.lwt_topic) >= MAX_TOPIC_LEN || strlen(client.lwt_message) >= MAX_LWT_MESSAGE_LEN) {
+        printf("[MQTT] LWT 길이 초과\n");
+        return false;
+    }
+
+    // Broker 주소 길이 검증
+    if (strlen(client.broker) == 0 || strlen(client.broker) >= MAX_BROKER_LEN) {
+        printf("[MQTT] 브로커 주소 유효하지 않음\n");
+        return false;
+    }
+
+    // Port 범위 검증 (1-65535)
+    if (client.port < 1 || client.port > 65535) {
+        printf("[MQTT] 유효하지 않은 포트: %d\n", client.port);
+        return false;
+    }
+
+    snprintf(cmd, START_CMD_LEN, "AT+CIPSTART=\"TCP\",\"%s\",%d", client.broker, client.port);
+    return true;
+}
+
+// 소켓 열기 3단계 (투명 전송 모드 → TCP 연결 → '>' 후 투명 전송 시작), 앞 단계 실패 시 나머지 취소
+static void native_fill_open_reqs(AtRequest* reqs, const char* start_cmd) {
+    for (int i = 0; i < 3; i++) {
+        reqs[i] = AtRequest();
+        reqs[i].tokens = AT_RESULT;
+        reqs[i].token_count = 2;
+        reqs[i].timeout_ms = 2000;
+        reqs[i].chain = (i < 2);
+    }
+    reqs[0].cmd = "AT+CIPMODE=1";
+    reqs[1].cmd = start_cmd;
+    reqs[1].timeout_ms = 10000;
+    // CIPSEND는 페이로드 없이 '>'를 결과 토큰으로 받음 (이후 모든 바이트가 TCP로)
+    reqs[2].cmd = "AT+CIPSEND";
+    reqs[2].tokens = CIPSEND_RESULT;
+}
+
+// '>' 수신 후: 투명 전송 수신 핸들러 설정, CONNECT 송신, CONNACK 대기
+static void native_begin_session(MqttClient& client) {
+    MqttNative& n = client.native;
+
+    MqttConnectOptions opt = {};
+    opt.client_id = client.client_id;
+    opt.username = client.username;
+    opt.password = client.password;
+    opt.will_topic = client.lwt_topic;
+    opt.will_message = client.lwt_message;
+    opt.will_qos = 0;
+    opt.will_retain = true;
+    opt.clean_session = true;
+    opt.keepalive_s = MQTT_KEEPALIVE_S;
+    uint8_t pkt[CONNECT_PACKET_MAX];
+    uint32_t len = mqtt_packet_connect(pkt, sizeof(pkt), opt);
+
+    n.handler.on_packet = on_native_packet;
+    n.handler.on_publish_begin = on_native_publish_begin;
+    n.handler.on_publish_data = on_native_publish_data;
+    n.handler.user = &client;
+    mqtt_packet_decoder_init(n.decoder, &n.handler);
+    n.ping_pending = false;
+    n.phase = MQTT_NATIVE_CONNACK;
+    n.phase_deadline_ms = now_ms() + MQTT_NATIVE_CONNACK_TIMEOUT_MS;
+    uart_set_passthrough(*client.link, on_native_rx, &client);
+
+    if (len == 0) {
+        native_close(client, AT_RESULT_ABORTED);  // 투명 전송은 이미 시작됨 → "+++"로 빠져나옴
+        return;
+    }
+    native_send(client, pkt, len);
+}
+
+static void on_native_open_done(int result, void* user) {
+    MqttClient& client = *(MqttClient*)user;
+    if (result != 0) {
+        printf("[MQTT] TCP 연결 실패 (%d)\n", result);
+        client.native.phase = MQTT_NATIVE_CLOSED;
+        client.connected = false;
+        if (result != AT_RESULT_ABORTED) {
+            native_submit_cipclose(client);  // "ALREADY CONNECTED" 등 남은 소켓 정리
+        }
+        return;
+    }
+    native_begin_session(client);
+}
+
+// 메인 루프 한 바퀴 (차단 래퍼용: 엔진/수신/시간 초과 진행 후 다음 이벤트까지 수면)
+static void native_poll_once(MqttClient& client) {
+    if (client.link->at) {
+        at_engine_poll(*client.link->at);
+    } else {
+        uart_link_poll(*client.link);
+    }
+    mqtt_transport_poll(client);
+    uart_wait_event(make_timeout_time_ms(10));
+}
+
+// 종료 진행 중이면 명령 모드로 돌아올 때까지 대기 (연결 중이면 종료 시작)
+static void native_wait_closed(MqttClient& client) {
+    MqttNative& n = client.native;
+    while (n.phase != MQTT_NATIVE_CLOSED) {
+        native_close(client, AT_RESULT_ABORTED);
+        native_poll_once(client);
+    }
+}
+
+// 차단 연결 (first_delay_ms = 직전 명령 완료 후 첫 명령까지 간격)
+static bool native_connect_after(MqttClient& client, uint32_t first_delay_ms) {
+    char start_cmd[START_CMD_LEN];
+    if (!native_build_start(client, start_cmd)) {
+        return false;
+    }
+    AtEngine* at = native_engine(client);
+    if (!at || !native_can_block(client)) {
+        return false;
+    }
+    MqttNative& n = client.native;
+    if (n.phase != MQTT_NATIVE_CLOSED) {
+        printf("[MQTT] 이전 연결 정리 중\n");
+        native_wait_closed(client);
+    }
+
+    printf("[MQTT] 연결 시작 (네이티브): %.*s:%d\n", MAX_BROKER_LEN, client.broker, client.port);
+    n.phase = MQTT_NATIVE_OPENING;
+
+    AtRequest reqs[3];
+    native_fill_open_reqs(reqs, start_cmd);
+    reqs[0].delay_ms = first_delay_ms;
+
+    static const char* const step_errors[] = {
+        "[MQTT] 투명 전송 설정 실패\n", "[MQTT] TCP 연결 실패\n", "[MQTT] 투명 전송 시작 실패\n"
+    };
+    for (int i = 0; i < 3; i++) {
+        if (at_execute(*at, reqs[i]) != 0) {
+            printf("%s", step_errors[i]);
+            n.phase = MQTT_NATIVE_CLOSED;
+            client.connected = false;
+            at_command(*at, "AT+CIPCLOSE", AT_RESULT, 2, 2000);
+            return false;
+        }
+    }
+
+    native_begin_session(client);
+    while (n.phase == MQTT_NATIVE_CONNACK) {
+        native_poll_once(client);
+    }
+    if (n.phase != MQTT_NATIVE_ONLINE) {
+        printf("[MQTT] 브로커 연결 실패\n");
+        native_wait_closed(client);
+        return false;
+    }
+    return true;
+}
+
+bool mqtt_connect(MqttClient& client) {
+    return native_connect_after(client, 0);
+}
+
+bool mqtt_connect_async(MqttClient& client) {
+    char start_cmd[START_CMD_LEN];
+    if (!native_build_start(client, start_cmd)) {
+        return false;
+    }
+    AtEngine* at = native_engine(client);
+    if (!at) {
+        return false;
+    }
+    if (client.native.phase != MQTT_NATIVE_CLOSED) {
+        printf("[MQTT] 이전 연결 정리 중 - 연결 요청 보류\n");
+        return false;
+    }
+
+    // 3개가 한꺼번에 들어갈 자리가 없으면 제출하지 않음 (중간만 제출되는 것 방지)
+    if (at->head - at->tail > AT_QUEUE_LEN - 3) {
+        printf("[MQTT] AT 큐 여유 없음 - 연결 요청 보류\n");
+        return false;
+    }
+
+    printf("[MQTT] 연결 요청 (네이티브): %.*s:%d\n", MAX_BROKER_LEN, client.broker, client.port);
+    AtRequest reqs[3];
+    native_fill_open_reqs(reqs, start_cmd);
+    reqs[2].done = on_native_open_done;
+    reqs[2].user = &client;
+    for (int i = 0; i < 3; i++) {
+        at_submit(*at, reqs[i]);
+    }
+    client.native.phase = MQTT_NATIVE_OPENING;
+    return true;
+}
+
+bool mqtt_connect_pending(MqttClient& client) {
+    return client.native.phase == MQTT_NATIVE_OPENING || client.native.phase == MQTT_NATIVE_CONNACK;
+}
+
+// ===== 발행/구독 =====
+
+// 발행 패킷 송신 (헤더와 페이로드를 TX 큐에 연달아 복사, 응답을 기다리지 않음)
+// 패킷 전체가 UART_TX_STAGING_SIZE 이하여야 함, TX 큐에 자리가 없으면 false
+static bool native_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain,
+                           AtCallback done, void* user) {
+    if (!client.connected || client.native.phase != MQTT_NATIVE_ONLINE) {
+        printf("[MQTT] 연결되지 않음\n");
+        return false;
+    }
+
+    // NULL 포인터 검증
+    if (!topic || !message) {
+        printf("[MQTT] NULL 토픽 또는 메시지\n");
+        return false;
+    }
+
+    // QoS 검증 (QoS 2 핸드셰이크는 구현하지 않음)
+    if (qos < 0 || qos > 1) {
+        printf("[MQTT] 네이티브 전송은 QoS 0/1만 지원: %d\n", qos);
+        return false;
+    }
+
+    // retain 검증
+    if (retain < 0 || retain > 1) {
+        printf("[MQTT] 유효하지 않은 retain: %d\n", retain);
+        return false;
+    }
+
+    // 토픽 길이 검증
+    if (strlen(topic) >= MAX_TOPIC_LEN) {
+        printf("[MQTT] 토픽 길이 초과\n");
+        return false;
+    }
+
+    uint32_t msg_len = strlen(message);
+
+    // 빈 메시지 경고 (허용하지만 의도하지 않은 동작일 수 있음)
+    if (msg_len == 0) {
+        printf("[MQTT] 경고: 빈 메시지 발행\n");
+    }
+
+    if (native_queue_full(client)) {
+        printf("[MQTT] 확인 대기 큐 가득 참\n");
+        return false;
+    }
+
+    uint16_t packet_id = qos ? native_packet_id(client) : 0;
+    uint8_t header[MAX_TOPIC_LEN + 8];
+    uint32_t header_len = mqtt_packet_publish_header(header, sizeof(header), topic, msg_len, qos, retain, packet_id);
+    if (header_len == 0) {
+        printf("[MQTT] 발행 헤더 작성 실패\n");
+        return false;
+    }
+
+    // 헤더와 페이로드가 함께 들어갈 자리가 있을 때만 송신 (자리가 없으면 아무것도 보내지 않고 나중에 다시)
+    if (header_len + msg_len > UART_TX_STAGING_SIZE) {
+        printf("[MQTT] 발행 패킷 길이 초과: %u 바이트\n", (unsigned)(header_len + msg_len));
+        return false;
+    }
+    if (!uart_tx_raw_room(*client.link, header_len + msg_len, 2)) {
+        return false;
+    }
+    if (!native_send(client, header, header_len) || !native_send(client, message, msg_len)) {
+        return false;
+    }
+
+    // QoS 0은 송신 큐에 넣은 것으로 완료 (다음 poll에서 순서대로 콜백)
+    native_push(client, done, user, packet_id, qos ? AT_RESULT_PENDING : 0);
+    return true;
+}
+
+bool mqtt_submit_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain,
+                         AtCallback done) {
+    uint32_t start_us = time_us_32();
+    if (!native_publish(client, topic, message, qos, retain, done, &client)) {
+        return false;
+    }
+    MqttPublishStats& st = client.pub_stats;
+    st.pending_start_us[st.pending_head++ % AT_QUEUE_LEN] = start_us;
+    return true;
+}
+
+bool mqtt_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain) {
+    if (!native_can_block(client)) {
+        return false;
+    }
+    NativeWait wait = { false, AT_RESULT_PENDING };
+    uint32_t start_us = time_us_32();
+    // 앞서 넣은 패킷이 빠질 때까지 기다려 발행 패킷 전체가 들어갈 자리 확보
+    if (!uart_tx_wait_idle(*client.link, MQTT_NATIVE_ACK_TIMEOUT_MS)) {
+        printf("[MQTT] TX 큐 비우기 시간 초과\n");
+        return false;
+    }
+    if (!native_publish(client, topic, message, qos, retain, on_native_blocking_done, &wait)) {
+        return false;
+    }
+    while (!wait.done) {
+        native_poll_once(client);
+    }
+    mqtt_publish_record(client, wait.result, start_us);
+    mqtt_publish_result(client, wait.result);
+    return wait.result == 0;
+}
+
+bool mqtt_submit_subscribe(MqttClient& client, const char* filter, int qos, AtCallback done, void* user) {
+    if (!client.connected || client.native.phase != MQTT_NATIVE_ONLINE) {
+        printf("[MQTT] 연결되지 않음\n");
+        return false;
+    }
+
+    // NULL 포인터 검증
+    if (!filter) {
+        printf("[MQTT] NULL 토픽\n");
+        return false;
+    }
+
+    // QoS 검증 (MQTT 표준: 0, 1, 2만 유효)
+    if (qos < 0 || qos > 2) {
+        printf("[MQTT] 유효하지 않은 QoS: %d\n", qos);
+        return false;
+    }
+
+    // 토픽 길이 검증
+    if (strlen(filter) >= MAX_TOPIC_LEN) {
+        printf("[MQTT] 토픽 길이 초과\n");
+        return false;
+    }
+
+    if (native_queue_full(client)) {
+        printf("[MQTT] 확인 대기 큐 가득 참\n");
+        return false;
+    }
+
+    // 수신 QoS 2 핸드셰이크는 구현하지 않으므로 QoS 1까지만 요청
+    uint16_t packet_id = native_packet_id(client);
+    uint8_t pkt[MAX_TOPIC_LEN + 8];
+    uint32_t len = mqtt_packet_subscribe(pkt, sizeof(pkt), packet_id, filter, qos > 1 ? 1 : qos);
+    if (len == 0) {
+        printf("[MQTT] 구독 패킷 작성 실패\n");
+        return false;
+    }
+    if (!native_send(client, pkt, len)) {
+        return false;
+    }
+    native_push(client, done, user, packet_id, AT_RESULT_PENDING);
+    return true;
+}
+
+bool mqtt_subscribe_async(MqttClient& client, const char* topic, int qos, AtCallback done, void* user) {
+    return mqtt_submit_subscribe(client, topic, qos, done, user);
+}
+
+bool mqtt_subscribe(MqttClient& client, const char* topic, int qos) {
+    if (!native_can_block(client)) {
+        return false;
+    }
+
+    printf("[MQTT] 구독: %.*s (QoS %d)\n", MAX_TOPIC_LEN, topic ? topic : "", qos);
+
+    // 재시도 로직 (최대 3회, 시도 사이 1초 - 대기 중에도 수신 처리)
+    for (int i = 0; i < 3; i++) {
+        NativeWait wait = { false, AT_RESULT_PENDING };
+        if (!mqtt_submit_subscribe(client, topic, qos, on_native_blocking_done, &wait)) {
+            break;
+        }
+        while (!wait.done) {
+            native_poll_once(client);
+        }
+        if (wait.result == 0) {
+            printf("[MQTT] 구독 성공\n");
+            return true;
+        }
+
+        printf("[MQTT] 구독 실패 (시도 %d/3)\n", i + 1);
+        uint32_t retry_at = now_ms() + 1000;
+        while (client.connected && !ms_reached(retry_at)) {
+            native_poll_once(client);
+        }
+    }
+
+    printf("[MQTT] 구독 최종 실패\n");
+    return false;
+}
+
+uint32_t mqtt_submit_room(MqttClient& client) {
+    const MqttNative& n = client.native;
+    if (!client.connected || n.phase != MQTT_NATIVE_ONLINE) {
+        return 0;
+    }
+    return AT_QUEUE_LEN - (n.req_head - n.req_tail);
+}
+
+// ===== 연결 유지 =====
+static void native_ping(MqttClient& client) {
+    MqttNative& n = client.native;
+    if (n.ping_pending) {
+        return;
+    }
+    uint8_t pkt[2];
+    if (!native_send(client, pkt, mqtt_packet_empty(pkt, MQTT_PKT_PINGREQ))) {
+        return;
+    }
+    n.ping_pending = true;
+    n.ping_deadline_ms = now_ms() + MQTT_NATIVE_PING_TIMEOUT_MS;
+}
+
+void mqtt_transport_poll(MqttClient& client) {
+    MqttNative& n = client.native;
+    switch (n.phase) {
+    case MQTT_NATIVE_CONNACK:
+        if (ms_reached(n.phase_deadline_ms)) {
+            printf("[MQTT] CONNACK 시간 초과\n");
+            native_close(client, AT_RESULT_TIMEOUT);
+        }
+        break;
+
+    case MQTT_NATIVE_ONLINE:
+        native_complete(client);    // QoS 0 발행 완료 콜백
+        if (n.ping_pending && ms_reached(n.ping_deadline_ms)) {
+            n.ping_timeouts++;
+            printf("[MQTT] PINGRESP 시간 초과 - 연결 끊김\n");
+            native_close(client, AT_RESULT_TIMEOUT);
+        } else if (n.req_tail != n.req_head && ms_reached(n.requests[n.req_tail % AT_QUEUE_LEN].deadline_ms)) {
+            printf("[MQTT] PUBACK/SUBACK 시간 초과 - 연결 끊김\n");
+            native_close(client, AT_RESULT_TIMEOUT);
+        } else if ((uint32_t)(now_ms() - client.last_activity) >= MQTT_KEEPALIVE_S * 500u) {
+            native_ping(client);    // keepalive 절반 동안 송신 없음
+        }
+        break;
+
+    case MQTT_NATIVE_EXIT_GUARD:
+        // "+++"는 앞뒤로 데이터가 없어야 명령으로 인식 → 송신이 끝난 뒤부터 간격 계산
+        if (uart_tx_busy(*client.link)) {
+            n.phase_deadline_ms = now_ms() + MQTT_NATIVE_EXIT_GUARD_MS;
+        } else if (ms_reached(n.phase_deadline_ms)) {
+            uart_send_raw(*client.link, "+++", 3);
+            n.phase = MQTT_NATIVE_EXIT_WAIT;
+            n.phase_deadline_ms = now_ms() + MQTT_NATIVE_EXIT_WAIT_MS;
+        }
+        break;
+
+    case MQTT_NATIVE_EXIT_WAIT:
+        if (uart_tx_busy(*client.link)) {
+            n.phase_deadline_ms = now_ms() + MQTT_NATIVE_EXIT_WAIT_MS;
+        } else if (ms_reached(n.phase_deadline_ms)) {
+            uart_set_passthrough(*client.link, NULL, NULL);
+            n.phase = MQTT_NATIVE_CLOSED;
+            printf("[MQTT] 투명 전송 종료\n");
+            native_submit_cipclose(client);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+bool mqtt_check_connection(MqttClient& client) {
+    if (!client.connected || !native_can_block(client)) {
+        return false;
+    }
+
+    // PINGREQ → PINGRESP 왕복으로 실제 연결 상태 확인 (시간 초과 시 종료 시작)
+    native_ping(client);
+    while (client.connected && client.native.ping_pending) {
+        native_poll_once(client);
+    }
+    return client.connected;
+}
+
+bool mqtt_check_connection_async(MqttClient& client) {
+    if (!client.connected) {
+        return false;
+    }
+    // 결과는 PINGRESP 수신 또는 mqtt_transport_poll의 시간 초과로 반영
+    native_ping(client);
+    return true;
+}
+
+bool mqtt_reconnect(MqttClient& client) {
+    printf("[MQTT] 재연결 시도...\n");
+
+    // 기존 연결 정리 (해제 후 1초 간격)
+    uint32_t delay_ms = 0;
+    if (client.connected || client.native.phase != MQTT_NATIVE_CLOSED) {
+        mqtt_disconnect(client);
+        delay_ms = 1000;
+    }
+
+    // 재연결 시도 (3회, 시도 사이 간격은 엔진 전송 지연 - 대기 중에도 URC 분배)
+    for (int i = 0; i < 3; i++) {
+        if (native_connect_after(client, delay_ms)) {
+            printf("[MQTT] 재연결 성공\n");
+            return true;
+        }
+        printf("[MQTT] 재연결 실패 (시도 %d/3)\n", i + 1);
+        delay_ms = 2000;
+    }
+
+    printf("[MQTT] 재연결 최종 실패\n");
+    return false;
+}
+
+void mqtt_disconnect(MqttClient& client) {
+    MqttNative& n = client.native;
+    if (n.phase == MQTT_NATIVE_CLOSED) {
+        client.connected = false;
+        return;
+    }
+
+    // 정상 종료 알림 (브로커는 LWT를 발행하지 않음)
+    if (n.phase == MQTT_NATIVE_ONLINE) {
+        uint8_t pkt[2];
+        native_send(client, pkt, mqtt_packet_empty(pkt, MQTT_PKT_DISCONNECT));
+    }
+    native_close(client, AT_RESULT_ABORTED);
+    if (native_can_block(client)) {
+        native_wait_closed(client);
+    }
+    client.connected = false;
+    printf("[MQTT] 연결 해제\n");
+}
+
+void mqtt_link_reset(MqttClient& client) {
+    // 리셋된 모듈은 명령 모드로 부팅 - "+++" 없이 투명 전송 상태만 정리
+    native_close(client, AT_RESULT_ABORTED);
+    if (client.link) {
+        uart_set_passthrough(*client.link, NULL, NULL);
+    }
+    client.native.phase = MQTT_NATIVE_CLOSED;
+    client.connected = false;
+}
+
+#endif // MQTT_NATIVE_TRANSPORT
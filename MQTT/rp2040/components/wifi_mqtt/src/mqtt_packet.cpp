@@ -0,0 +1,346 @@
+#include "mqtt_packet.h"
+#include <stdio.h>
+#include <string.h>
+
+// 디코더 상태
+enum {
+    DEC_HEADER = 0,     // 고정 헤더 첫 바이트
+    DEC_LENGTH,         // 가변 길이 (1~4바이트)
+    DEC_BODY,           // PUBLISH 외 본문 (앞부분만 버퍼에)
+    DEC_PUB_TOPIC_LEN,  // PUBLISH 토픽 길이 (2바이트)
+    DEC_PUB_TOPIC,
+    DEC_PUB_ID,         // QoS > 0 패킷 ID (2바이트)
+    DEC_PUB_PAYLOAD,
+    DEC_SKIP            // 받지 않는 패킷 나머지 버림
+};
+
+// ===== 인코더 =====
+
+// 가변 길이 필드 바이트 수
+static uint32_t remaining_size(uint32_t len) {
+    return (len < 128) ? 1 : (len < 16384) ? 2 : (len < 2097152) ? 3 : 4;
+}
+
+// 고정 헤더 기록, 반환: 기록한 바이트 수 (전체가 max를 넘으면 0)
+static uint32_t put_fixed_header(uint8_t* buf, uint32_t max, uint8_t first, uint32_t remaining, uint32_t total) {
+    if (remaining > MQTT_PACKET_REMAINING_MAX || 1 + remaining_size(remaining) + total > max) {
+        return 0;
+    }
+    uint8_t* p = buf;
+    *p++ = first;
+    do {
+        uint8_t b = remaining & 0x7F;
+        remaining >>= 7;
+        *p++ = remaining ? (b | 0x80) : b;
+    } while (remaining);
+    return (uint32_t)(p - buf);
+}
+
+static uint8_t* put_u16(uint8_t* p, uint16_t v) {
+    *p++ = (uint8_t)(v >> 8);
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// 길이 접두 문자열 (2바이트 길이 + 내용)
+static uint8_t* put_str(uint8_t* p, const char* s, uint32_t len) {
+    p = put_u16(p, (uint16_t)len);
+    memcpy(p, s, len);
+    return p + len;
+}
+
+uint32_t mqtt_packet_connect(uint8_t* buf, uint32_t max, const MqttConnectOptions& opt) {
+    // NULL 포인터 검증 (클라이언트 ID는 필수, 비밀번호는 사용자명이 있을 때만)
+    if (!buf || !opt.client_id || (opt.password && !opt.username) ||
+        (!opt.will_topic != !opt.will_message) || opt.will_qos > 2) {
+        printf("[MQTT] 유효하지 않은 CONNECT 설정\n");
+        return 0;
+    }
+
+    uint32_t id_len = strlen(opt.client_id);
+    uint32_t will_topic_len = opt.will_topic ? strlen(opt.will_topic) : 0;
+    uint32_t will_msg_len = opt.will_message ? strlen(opt.will_message) : 0;
+    uint32_t user_len = opt.username ? strlen(opt.username) : 0;
+    uint32_t pass_len = opt.password ? strlen(opt.password) : 0;
+    if (id_len > 0xFFFF || will_topic_len > 0xFFFF || will_msg_len > 0xFFFF || user_len > 0xFFFF || pass_len > 0xFFFF) {
+        printf("[MQTT] CONNECT 필드 길이 초과\n");
+        return 0;
+    }
+
+    uint8_t flags = opt.clean_session ? 0x02 : 0;
+    uint32_t remaining = 10 + 2 + id_len;   // 프로토콜 이름/레벨/플래그/keepalive + 클라이언트 ID
+    if (opt.will_topic) {
+        flags |= 0x04 | (uint8_t)(opt.will_qos << 3) | (opt.will_retain ? 0x20 : 0);
+        remaining += 2 + will_topic_len + 2 + will_msg_len;
+    }
+    if (opt.username) {
+        flags |= 0x80;
+        remaining += 2 + user_len;
+    }
+    if (opt.password) {
+        flags |= 0x40;
+        remaining += 2 + pass_len;
+    }
+
+    uint32_t n = put_fixed_header(buf, max, MQTT_PKT_CONNECT << 4, remaining, remaining);
+    if (n == 0) {
+        printf("[MQTT] CONNECT 버퍼 부족\n");
+        return 0;
+    }
+    uint8_t* p = put_str(buf + n, "MQTT", 4);
+    *p++ = 4;   // 프로토콜 레벨 3.1.1
+    *p++ = flags;
+    p = put_u16(p, opt.keepalive_s);
+    p = put_str(p, opt.client_id, id_len);
+    if (opt.will_topic) {
+        p = put_str(p, opt.will_topic, will_topic_len);
+        p = put_str(p, opt.will_message, will_msg_len);
+    }
+    if (opt.username) {
+        p = put_str(p, opt.username, user_len);
+    }
+    if (opt.password) {
+        p = put_str(p, opt.password, pass_len);
+    }
+    return (uint32_t)(p - buf);
+}
+
+uint32_t mqtt_packet_publish_header(uint8_t* buf, uint32_t max, const char* topic, uint32_t payload_len,
+                                    int qos, bool retain, uint16_t packet_id) {
+    // NULL 포인터 / QoS 검증
+    if (!buf || !topic || qos < 0 || qos > 2) {
+        return 0;
+    }
+    uint32_t topic_len = strlen(topic);
+    if (topic_len == 0 || topic_len > 0xFFFF) {
+        return 0;
+    }
+
+    uint32_t header_body = 2 + topic_len + (qos > 0 ? 2 : 0);
+    uint8_t first = (uint8_t)((MQTT_PKT_PUBLISH << 4) | (qos << 1) | (retain ? 1 : 0));
+    uint32_t n = put_fixed_header(buf, max, first, header_body + payload_len, header_body);
+    if (n == 0) {
+        return 0;
+    }
+    uint8_t* p = put_str(buf + n, topic, topic_len);
+    if (qos > 0) {
+        p = put_u16(p, packet_id);
+    }
+    return (uint32_t)(p - buf);
+}
+
+uint32_t mqtt_packet_subscribe(uint8_t* buf, uint32_t max, uint16_t packet_id, const char* filter, int qos) {
+    // NULL 포인터 / QoS 검증
+    if (!buf || !filter || qos < 0 || qos > 2) {
+        return 0;
+    }
+    uint32_t filter_len = strlen(filter);
+    if (filter_len == 0 || filter_len > 0xFFFF) {
+        return 0;
+    }
+
+    // SUBSCRIBE 고정 헤더 하위 비트는 0010 고정
+    uint32_t remaining = 2 + 2 + filter_len + 1;
+    uint32_t n = put_fixed_header(buf, max, (MQTT_PKT_SUBSCRIBE << 4) | 0x02, remaining, remaining);
+    if (n == 0) {
+        return 0;
+    }
+    uint8_t* p = put_u16(buf + n, packet_id);
+    p = put_str(p, filter, filter_len);
+    *p++ = (uint8_t)qos;
+    return (uint32_t)(p - buf);
+}
+
+uint32_t mqtt_packet_ack(uint8_t* buf, uint8_t type, uint16_t packet_id) {
+    // PUBREL만 하위 비트 0010
+    buf[0] = (uint8_t)((type << 4) | (type == MQTT_PKT_PUBREL ? 0x02 : 0));
+    buf[1] = 2;
+    put_u16(buf + 2, packet_id);
+    return 4;
+}
+
+uint32_t mqtt_packet_empty(uint8_t* buf, uint8_t type) {
+    buf[0] = (uint8_t)(type << 4);
+    buf[1] = 0;
+    return 2;
+}
+
+// ===== 디코더 =====
+
+void mqtt_packet_decoder_init(MqttPacketDecoder& dec, const MqttPacketHandler* handler) {
+    memset(&dec, 0, sizeof(dec));
+    dec.handler = handler;
+    dec.state = DEC_HEADER;
+}
+
+static bool decoder_fail(MqttPacketDecoder& dec, const char* reason) {
+    printf("[MQTT] 패킷 형식 오류: %s\n", reason);
+    dec.error = true;
+    return false;
+}
+
+// PUBLISH 토픽/패킷 ID 해석 완료 → 페이로드 전달 시작
+static void publish_begin(MqttPacketDecoder& dec) {
+    const MqttPacketHandler* h = dec.handler;
+    if (h && h->on_publish_begin) {
+        h->on_publish_begin(dec.topic, dec.topic_len, dec.header & 0x0F, dec.packet_id, dec.remaining, h->user);
+    }
+    dec.state = (dec.remaining > 0) ? DEC_PUB_PAYLOAD : DEC_HEADER;
+}
+
+// 고정 헤더 해석 완료 → 본문 단계 결정
+static bool body_begin(MqttPacketDecoder& dec) {
+    dec.got = 0;
+    uint8_t type = dec.header >> 4;
+    if (type == MQTT_PKT_PUBLISH) {
+        if (((dec.header >> 1) & 0x03) == 3) {
+            return decoder_fail(dec, "PUBLISH QoS 3");
+        }
+        dec.state = DEC_PUB_TOPIC_LEN;
+        return true;
+    }
+
+    dec.state = DEC_BODY;
+    if (dec.remaining == 0) {
+        const MqttPacketHandler* h = dec.handler;
+        if (h && h->on_packet) {
+            h->on_packet(type, dec.header & 0x0F, dec.body, 0, h->user);
+        }
+        dec.state = DEC_HEADER;
+    }
+    return true;
+}
+
+bool mqtt_packet_feed(MqttPacketDecoder& dec, const uint8_t* data, uint32_t len) {
+    if (dec.error) {
+        return false;
+    }
+    // NULL 포인터 검증
+    if (!data) {
+        return len == 0;
+    }
+
+    const MqttPacketHandler* h = dec.handler;
+    const uint8_t* end = data + len;
+    while (data < end) {
+        switch (dec.state) {
+        case DEC_HEADER:
+            dec.header = *data++;
+            if ((dec.header >> 4) == 0) {
+                return decoder_fail(dec, "패킷 종류 0");
+            }
+            dec.remaining = 0;
+            dec.len_shift = 0;
+            dec.state = DEC_LENGTH;
+            break;
+
+        case DEC_LENGTH: {
+            uint8_t b = *data++;
+            dec.remaining |= (uint32_t)(b & 0x7F) << dec.len_shift;
+            dec.len_shift += 7;
+            if (b & 0x80) {
+                if (dec.len_shift >= 28) {
+                    return decoder_fail(dec, "가변 길이 초과");
+                }
+                break;
+            }
+            if (!body_begin(dec)) {
+                return false;
+            }
+            break;
+        }
+
+        case DEC_BODY: {
+            uint32_t n = (uint32_t)(end - data);
+            if (n > dec.remaining) {
+                n = dec.remaining;
+            }
+            for (uint32_t i = 0; i < n; i++) {
+                if (dec.got < MQTT_PACKET_BODY_MAX) {
+                    dec.body[dec.got++] = data[i];
+                }
+            }
+            data += n;
+            dec.remaining -= n;
+            if (dec.remaining == 0) {
+                if (h && h->on_packet) {
+                    h->on_packet(dec.header >> 4, dec.header & 0x0F, dec.body, dec.got, h->user);
+                }
+                dec.state = DEC_HEADER;
+            }
+            break;
+        }
+
+        case DEC_PUB_TOPIC_LEN:
+            if (dec.remaining == 0) {
+                return decoder_fail(dec, "PUBLISH 길이");
+            }
+            dec.topic_len = (uint16_t)((dec.topic_len << 8) | *data++);
+            dec.remaining--;
+            if (++dec.got < 2) {
+                break;
+            }
+            dec.got = 0;
+            if ((uint32_t)dec.topic_len + (((dec.header >> 1) & 0x03) ? 2 : 0) > dec.remaining) {
+                return decoder_fail(dec, "PUBLISH 토픽 길이");
+            }
+            if (dec.topic_len == 0 || dec.topic_len > MQTT_PACKET_TOPIC_MAX) {
+                printf("[MQTT] 수신 토픽 길이 %u - 메시지 건너뜀\n", dec.topic_len);
+                dec.skipped++;
+                dec.state = (dec.remaining > 0) ? DEC_SKIP : DEC_HEADER;
+                break;
+            }
+            dec.state = DEC_PUB_TOPIC;
+            break;
+
+        case DEC_PUB_TOPIC: {
+            uint32_t n = (uint32_t)(end - data);
+            if (n > (uint32_t)dec.topic_len - dec.got) {
+                n = dec.topic_len - dec.got;
+            }
+            memcpy(dec.topic + dec.got, data, n);
+            data += n;
+            dec.got += n;
+            dec.remaining -= n;
+            if (dec.got < dec.topic_len) {
+                break;
+            }
+            dec.topic[dec.topic_len] = '\0';
+            dec.got = 0;
+            dec.packet_id = 0;
+            if ((dec.header >> 1) & 0x03) {
+                dec.state = DEC_PUB_ID;
+            } else {
+                publish_begin(dec);
+            }
+            break;
+        }
+
+        case DEC_PUB_ID:
+            dec.packet_id = (uint16_t)((dec.packet_id << 8) | *data++);
+            dec.remaining--;
+            if (++dec.got == 2) {
+                publish_begin(dec);
+            }
+            break;
+
+        case DEC_PUB_PAYLOAD:
+        case DEC_SKIP: {
+            uint32_t n = (uint32_t)(end - data);
+            if (n > dec.remaining) {
+                n = dec.remaining;
+            }
+            if (dec.state == DEC_PUB_PAYLOAD && h && h->on_publish_data) {
+                h->on_publish_data((const char*)data, n, h->user);
+            }
+            data += n;
+            dec.remaining -= n;
+            if (dec.remaining == 0) {
+                dec.state = DEC_HEADER;
+            }
+            break;
+        }
+        }
+    }
+    return true;
+}
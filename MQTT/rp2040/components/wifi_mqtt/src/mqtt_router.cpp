@@ -0,0 +1,226 @@
+#include "mqtt_router.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ROUTER_ROOT 0
+#define ROUTER_NONE (-1)
+
+static_assert((MQTT_ROUTER_HASH_SIZE & (MQTT_ROUTER_HASH_SIZE - 1)) == 0, "해시 테이블 크기는 2의 거듭제곱");
+static_assert(MQTT_ROUTER_HASH_SIZE > MQTT_ROUTER_NODES, "해시 테이블은 노드 수보다 커야 함");
+static_assert(MQTT_ROUTER_NODES <= 0x7FFF && MQTT_ROUTER_ROUTES <= 0x7FFF, "인덱스는 int16_t");
+
+// (부모 노드, 단계 문자열) 해시 (FNV-1a)
+static uint32_t level_hash(uint16_t parent, const char* level, uint32_t len) {
+    uint32_t h = 2166136261u ^ parent;
+    for (uint32_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)level[i]) * 16777619u;
+    }
+    return h;
+}
+
+// 부모 아래 일반 단계 자식 찾기 (반환: 노드, 없으면 -1 / slot = 찾은 칸 또는 빈 칸)
+static int find_child(const MqttRouter& router, uint16_t parent, const char* level, uint32_t len,
+                      uint32_t hash, uint32_t* slot) {
+    uint32_t i = hash & (MQTT_ROUTER_HASH_SIZE - 1);
+    while (router.table[i] != ROUTER_NONE) {
+        const MqttRouterNode& n = router.nodes[router.table[i]];
+        if (n.parent == parent && n.text_len == len && memcmp(router.text + n.text_off, level, len) == 0) {
+            break;
+        }
+        i = (i + 1) & (MQTT_ROUTER_HASH_SIZE - 1);
+    }
+    if (slot) {
+        *slot = i;
+    }
+    return router.table[i];
+}
+
+static int new_node(MqttRouter& router, uint16_t parent) {
+    if (router.node_count >= MQTT_ROUTER_NODES) {
+        printf("[ROUTER] 노드 수 초과\n");
+        return ROUTER_NONE;
+    }
+    MqttRouterNode& n = router.nodes[router.node_count];
+    n.parent = parent;
+    n.text_off = 0;
+    n.text_len = 0;
+    n.plus = ROUTER_NONE;
+    n.routes = ROUTER_NONE;
+    n.hash_routes = ROUTER_NONE;
+    return router.node_count++;
+}
+
+// 핸들러 목록 끝에 추가 (등록 순서대로 호출)
+static bool append_route(MqttRouter& router, int16_t* head, MqttRouteHandler handler, void* user) {
+    if (router.route_count >= MQTT_ROUTER_ROUTES) {
+        printf("[ROUTER] 핸들러 수 초과\n");
+        return false;
+    }
+    int16_t idx = (int16_t)router.route_count++;
+    router.routes[idx].handler = handler;
+    router.routes[idx].user = user;
+    router.routes[idx].next = ROUTER_NONE;
+
+    while (*head != ROUTER_NONE) {
+        head = &router.routes[*head].next;
+    }
+    *head = idx;
+    return true;
+}
+
+void mqtt_router_init(MqttRouter& router) {
+    memset(&router, 0, sizeof(router));
+    memset(router.table, 0xFF, sizeof(router.table));   // 모두 -1
+    new_node(router, ROUTER_ROOT);
+}
+
+bool mqtt_router_add(MqttRouter& router, const char* filter, MqttRouteHandler handler, void* user) {
+    // NULL 포인터 검증
+    if (!filter || !handler || filter[0] == '\0') {
+        printf("[ROUTER] 유효하지 않은 필터\n");
+        return false;
+    }
+
+    uint16_t node = ROUTER_ROOT;
+    const char* p = filter;
+    while (true) {
+        const char* end = strchr(p, '/');
+        uint32_t len = end ? (uint32_t)(end - p) : (uint32_t)strlen(p);
+
+        // 와일드카드는 단계 전체여야 하고 '#'은 마지막 단계에만
+        bool wildcard = memchr(p, '+', len) || memchr(p, '#', len);
+        if (wildcard && len != 1) {
+            printf("[ROUTER] 잘못된 와일드카드: %s\n", filter);
+            return false;
+        }
+        if (p[0] == '#' && len == 1) {
+            if (end) {
+                printf("[ROUTER] '#'은 마지막 단계만 가능: %s\n", filter);
+                return false;
+            }
+            return append_route(router, &router.nodes[node].hash_routes, handler, user);
+        }
+
+        int child;
+        if (p[0] == '+' && len == 1) {
+            child = router.nodes[node].plus;
+            if (child == ROUTER_NONE) {
+                // 디스패치 경로 배열 크기 보장 (경로 수 ≤ 1 + '+' 노드 수)
+                if (router.plus_count + 1 >= MQTT_ROUTER_ACTIVE_MAX) {
+                    printf("[ROUTER] '+' 위치 수 초과 (최대 %d): %s\n", MQTT_ROUTER_ACTIVE_MAX - 1, filter);
+                    return false;
+                }
+                child = new_node(router, node);
+                if (child == ROUTER_NONE) {
+                    return false;
+                }
+                router.nodes[node].plus = (int16_t)child;
+                router.plus_count++;
+            }
+        } else {
+            uint32_t slot;
+            child = find_child(router, node, p, len, level_hash(node, p, len), &slot);
+            if (child == ROUTER_NONE) {
+                if (len > 0xFF || router.text_used + len > MQTT_ROUTER_TEXT_POOL) {
+                    printf("[ROUTER] 단계 문자열 공간 부족: %s\n", filter);
+                    return false;
+                }
+                child = new_node(router, node);
+                if (child == ROUTER_NONE) {
+                    return false;
+                }
+                MqttRouterNode& n = router.nodes[child];
+                n.text_off = router.text_used;
+                n.text_len = (uint8_t)len;
+                memcpy(router.text + router.text_used, p, len);
+                router.text_used += len;
+                router.table[slot] = (int16_t)child;
+            }
+        }
+        node = (uint16_t)child;
+
+        if (!end) {
+            return append_route(router, &router.nodes[node].routes, handler, user);
+        }
+        p = end + 1;
+    }
+}
+
+// 핸들러 목록 전체 호출 (반환: 호출 수)
+static int call_routes(const MqttRouter& router, int16_t head, const char* topic, const char* payload,
+                       uint32_t payload_len) {
+    int calls = 0;
+    for (int16_t r = head; r != ROUTER_NONE; r = router.routes[r].next) {
+        router.routes[r].handler(topic, payload, payload_len, router.routes[r].user);
+        calls++;
+    }
+    return calls;
+}
+
+int mqtt_router_dispatch(MqttRouter& router, const char* topic, const char* payload, uint32_t payload_len) {
+    // NULL 포인터 검증
+    if (!topic) {
+        return 0;
+    }
+    if (!payload) {
+        payload = "";
+        payload_len = 0;
+    }
+
+    // 현재 단계에서 따라가는 노드들 (일반 단계와 '+'가 겹치면 여러 개)
+    // 노드마다 부모가 하나뿐이라 중복이 없고, 늘어나는 경로는 서로 다른 '+' 노드 → 최대 1 + plus_count (등록 시 보장)
+    uint16_t active[MQTT_ROUTER_ACTIVE_MAX];
+    int active_count = 1;
+    active[0] = ROUTER_ROOT;
+
+    // '$'로 시작하는 토픽은 첫 단계 와일드카드와 일치하지 않음 (MQTT 규칙)
+    bool system_topic = topic[0] == '$';
+
+    int calls = 0;
+    const char* p = topic;
+    while (active_count > 0) {
+        const char* end = strchr(p, '/');
+        uint32_t len = end ? (uint32_t)(end - p) : (uint32_t)strlen(p);
+        bool wild_ok = !(system_topic && p == topic);
+
+        uint16_t next[MQTT_ROUTER_ACTIVE_MAX];
+        int next_count = 0;
+        for (int a = 0; a < active_count; a++) {
+            const MqttRouterNode& n = router.nodes[active[a]];
+
+            // '#'은 남은 단계 전체와 일치
+            if (wild_ok) {
+                calls += call_routes(router, n.hash_routes, topic, payload, payload_len);
+            }
+
+            int child = find_child(router, active[a], p, len, level_hash(active[a], p, len), NULL);
+            if (child != ROUTER_NONE) {
+                next[next_count++] = (uint16_t)child;
+            }
+            if (wild_ok && n.plus != ROUTER_NONE) {
+                next[next_count++] = (uint16_t)n.plus;
+            }
+        }
+
+        if (!end) {
+            // 마지막 단계: 여기서 끝나는 필터와 "a/#"처럼 부모 단계까지 포함하는 필터
+            for (int a = 0; a < next_count; a++) {
+                const MqttRouterNode& n = router.nodes[next[a]];
+                calls += call_routes(router, n.routes, topic, payload, payload_len);
+                calls += call_routes(router, n.hash_routes, topic, payload, payload_len);
+            }
+            break;
+        }
+
+        memcpy(active, next, sizeof(next[0]) * next_count);
+        active_count = next_count;
+        p = end + 1;
+    }
+
+    if (calls > 0) {
+        router.dispatched++;
+    } else {
+        router.unmatched++;
+    }
+    return calls;
+}
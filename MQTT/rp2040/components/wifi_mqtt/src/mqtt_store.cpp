@@ -0,0 +1,399 @@
+#include "mqtt_store.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#define STORE_MAGIC 0x3253514Du            // "MQS2" (기록 헤더 형식이 다른 이전 로그는 빈 영역으로 취급)
+#define STORE_SECTOR_HDR 8u                 // magic + seq
+#define STORE_END 0xFFFFu                   // 지워진 플래시 = 기록 끝
+
+// 기록 플래그
+#define REC_QOS_MASK 0x03u
+#define REC_RETAIN   0x04u
+#define REC_BOOT     0x40u                  // 부팅 표시 (토픽/페이로드 없음, 부팅 번호만)
+#define REC_PENDING  0x80u                  // 1 = 미전송, 전송 완료 시 0으로 덮어씀
+
+typedef struct {
+    uint16_t payload_len;
+    uint8_t topic_len;
+    uint8_t flags;
+    uint32_t boot;                          // 기록한 부팅 번호
+} StoreRecordHeader;
+
+static inline uint32_t rec_size(uint32_t topic_len, uint32_t payload_len) {
+    return (uint32_t)(sizeof(StoreRecordHeader) + topic_len + 1 + payload_len + 1 + 3) & ~3u;
+}
+
+static inline uint32_t sector_base(const MqttStore& store, uint32_t seq) {
+    return store.base + (seq % store.sectors) * FLASH_SECTOR_SIZE;
+}
+
+static inline const uint8_t* flash_ptr(uint32_t offset) {
+    return (const uint8_t*)(XIP_BASE + offset);
+}
+
+// ===== 플래시 작업 (XIP가 멈추므로 인터럽트 차단 상태에서 실행) =====
+// 섹터 지우기는 45~400 ms, 페이지 기록은 약 1 ms 동안 CPU가 멈춤
+// RX DMA는 그동안에도 링에 계속 쓰지만 메인 루프가 비우지 못하므로 링보다 많이 들어오면 덮어씀
+// → pause_link(RTS 배선 시)로 모듈 송신을 멈추고, RTS가 없으면 RX 링이 그만큼 담아야 함
+//   (115200 bps에서 400 ms = 약 4.6 KB, connectBroker는 UART_RX_BUFFER_SIZE 8 KB)
+static void store_pause(MqttStore& store, bool pause) {
+    if (store.pause_link) {
+        uart_rx_pause(*store.pause_link, pause);
+    }
+}
+
+static void store_erase(MqttStore& store) {
+    store_pause(store, true);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_erase(sector_base(store, store.write_seq), FLASH_SECTOR_SIZE);
+    restore_interrupts(irq);
+    store_pause(store, false);
+    store.erase_pending = false;
+    store.erases++;
+}
+
+static void store_program_page(MqttStore& store, uint32_t offset, const uint8_t* data) {
+    store_pause(store, true);
+    uint32_t irq = save_and_disable_interrupts();
+    flash_range_program(offset, data, FLASH_PAGE_SIZE);
+    restore_interrupts(irq);
+    store_pause(store, false);
+}
+
+// RAM 페이지 기록 (같은 페이지를 다시 기록해도 이미 쓴 바이트는 그대로 유지)
+static void store_flush_page(MqttStore& store) {
+    if (store.erase_pending) {
+        store_erase(store);
+    }
+    store_program_page(store, sector_base(store, store.write_seq) + store.page_off, store.page);
+    store.page_dirty = false;
+    store.flushed_off = store.write_off;
+}
+
+// 전송 완료 표시: 플래그 바이트만 0으로, 나머지는 0xFF (덮어써도 변하지 않음)
+static void store_program_ack(MqttStore& store) {
+    uint8_t buf[FLASH_PAGE_SIZE];
+    memset(buf, 0xFF, sizeof(buf));
+    buf[store.ack_off % FLASH_PAGE_SIZE] = (uint8_t)~REC_PENDING;
+    store_program_page(store, store.ack_off & ~(FLASH_PAGE_SIZE - 1), buf);
+    store.ack_off = 0;
+}
+
+// (seq, off)의 기록 헤더, 기록 끝이거나 손상(기록 중 전원 차단)이면 NULL
+static const StoreRecordHeader* store_record(const MqttStore& store, uint32_t seq, uint32_t off) {
+    uint32_t limit = (seq == store.write_seq) ? store.flushed_off : FLASH_SECTOR_SIZE;
+    if (off + sizeof(StoreRecordHeader) > limit) {
+        return NULL;
+    }
+
+    const uint8_t* p = flash_ptr(sector_base(store, seq) + off);
+    const StoreRecordHeader* hdr = (const StoreRecordHeader*)p;
+    if (hdr->payload_len == STORE_END || (hdr->topic_len == 0 && !(hdr->flags & REC_BOOT)) ||
+        hdr->payload_len > MQTT_STORE_PAYLOAD_MAX) {
+        return NULL;
+    }
+    if (off + rec_size(hdr->topic_len, hdr->payload_len) > limit) {
+        return NULL;
+    }
+
+    const char* topic = (const char*)(p + sizeof(StoreRecordHeader));
+    if (topic[hdr->topic_len] != '\0' || topic[hdr->topic_len + 1 + hdr->payload_len] != '\0') {
+        return NULL;
+    }
+    return hdr;
+}
+
+// 섹터의 off 이후 미전송 기록 수
+static uint32_t store_count_pending(const MqttStore& store, uint32_t seq, uint32_t off) {
+    uint32_t count = 0;
+    const StoreRecordHeader* hdr;
+    while ((hdr = store_record(store, seq, off)) != NULL) {
+        if (hdr->flags & REC_PENDING) {
+            count++;
+        }
+        off += rec_size(hdr->topic_len, hdr->payload_len);
+    }
+    return count;
+}
+
+// 섹터의 마지막 기록에 남은 부팅 번호 (기록이 없으면 0, 번호는 로그 순서대로 증가)
+static uint32_t store_last_boot(const MqttStore& store, uint32_t seq) {
+    uint32_t boot = 0;
+    uint32_t off = STORE_SECTOR_HDR;
+    const StoreRecordHeader* hdr;
+    while ((hdr = store_record(store, seq, off)) != NULL) {
+        boot = hdr->boot;
+        off += rec_size(hdr->topic_len, hdr->payload_len);
+    }
+    return boot;
+}
+
+// 다음 섹터로 이동 (지우기는 mqtt_store_poll로 미룸, 가장 오래된 섹터의 미전송 기록은 버림)
+static void store_next_sector(MqttStore& store) {
+    if (store.page_dirty) {
+        store_flush_page(store);
+    }
+
+    store.write_seq++;
+    uint32_t evicted = store.write_seq - store.sectors;
+    if (store.write_seq >= store.sectors && store.read_seq <= evicted) {
+        uint32_t lost = store_count_pending(store, evicted, store.read_off);
+        if (lost > 0) {
+            printf("[STORE] 보관 한도 초과 - 미전송 %lu건 삭제\n", (unsigned long)lost);
+        }
+        store.dropped += lost;
+        store.pending -= lost;
+        store.read_seq = evicted + 1;
+        store.read_off = STORE_SECTOR_HDR;
+        store.peek_off = 0;
+        if (store.ack_off >= sector_base(store, evicted) &&
+            store.ack_off < sector_base(store, evicted) + FLASH_SECTOR_SIZE) {
+            store.ack_off = 0;
+        }
+    }
+
+    store.erase_pending = true;
+    store.page_off = 0;
+    memset(store.page, 0xFF, sizeof(store.page));
+    uint32_t header[2] = { STORE_MAGIC, store.write_seq };
+    memcpy(store.page, header, sizeof(header));
+    store.page_dirty = true;
+    store.write_off = STORE_SECTOR_HDR;
+    store.flushed_off = 0;
+}
+
+// RAM 페이지에 이어 쓰기 (페이지가 차면 기록 후 다음 페이지)
+static void store_put(MqttStore& store, const void* data, uint32_t len) {
+    const uint8_t* src = (const uint8_t*)data;
+    while (len > 0) {
+        if (store.write_off - store.page_off == FLASH_PAGE_SIZE) {
+            store_flush_page(store);
+            store.page_off += FLASH_PAGE_SIZE;
+            memset(store.page, 0xFF, sizeof(store.page));
+        }
+        uint32_t room = FLASH_PAGE_SIZE - (store.write_off - store.page_off);
+        uint32_t n = len < room ? len : room;
+        memcpy(store.page + (store.write_off - store.page_off), src, n);
+        store.write_off += n;
+        store.page_dirty = true;
+        src += n;
+        len -= n;
+    }
+}
+
+// 기록 하나를 RAM 페이지에 추가 (섹터에 자리가 없으면 다음 섹터로)
+static void store_write(MqttStore& store, const char* topic, uint32_t topic_len, const char* payload,
+                        uint32_t payload_len, uint8_t flags) {
+    uint32_t size = rec_size(topic_len, payload_len);
+    if (store.write_off + size > FLASH_SECTOR_SIZE) {
+        store_next_sector(store);
+    }
+
+    StoreRecordHeader hdr;
+    hdr.payload_len = (uint16_t)payload_len;
+    hdr.topic_len = (uint8_t)topic_len;
+    hdr.flags = flags;
+    hdr.boot = store.boot;
+
+    static const uint8_t pad[4] = { 0, 0xFF, 0xFF, 0xFF };   // 페이로드 NUL + 정렬 채움
+    uint32_t start = store.write_off;
+    store_put(store, &hdr, sizeof(hdr));
+    store_put(store, topic, topic_len + 1);
+    store_put(store, payload, payload_len);
+    store_put(store, pad, start + size - store.write_off);
+    store.last_append_ms = to_ms_since_boot(get_absolute_time());
+}
+
+// 이번 부팅 번호를 정해 표시 기록 추가 (보관 기록이 없는 부팅도 번호를 차지 → 번호가 부팅마다 유일)
+static void store_mark_boot(MqttStore& store, uint32_t last_boot) {
+    store.boot = last_boot + 1;
+    if (store.boot == 0) {
+        store.boot = 1;     // 0은 "열리지 않음"
+    }
+    store_write(store, "", 0, "", 0, REC_BOOT);
+}
+
+bool mqtt_store_init(MqttStore& store) {
+    memset(&store, 0, sizeof(store));
+    store.sectors = MQTT_STORE_SECTORS;
+    store.base = PICO_FLASH_SIZE_BYTES - MQTT_STORE_SECTORS * FLASH_SECTOR_SIZE;
+    if (store.sectors < 2) {
+        printf("[STORE] 보관 영역은 2섹터 이상이어야 함\n");
+        return false;
+    }
+
+    // 유효한 섹터 중 가장 최근/가장 오래된 순번 찾기
+    bool found = false;
+    uint32_t newest = 0;
+    uint32_t oldest = 0;
+    for (uint32_t i = 0; i < store.sectors; i++) {
+        const uint32_t* header = (const uint32_t*)flash_ptr(store.base + i * FLASH_SECTOR_SIZE);
+        if (header[0] != STORE_MAGIC || header[1] % store.sectors != i) {
+            continue;
+        }
+        if (!found || (int32_t)(header[1] - newest) > 0) {
+            newest = header[1];
+        }
+        if (!found || (int32_t)(header[1] - oldest) < 0) {
+            oldest = header[1];
+        }
+        found = true;
+    }
+
+    if (!found) {
+        // 빈 영역: 0번 섹터부터 (첫 기록 전에 지움)
+        store.write_seq = (uint32_t)-1;
+        store.read_seq = 0;
+        store_next_sector(store);
+        store.page_dirty = false;   // 헤더는 첫 기록과 함께 기록
+        store.read_off = STORE_SECTOR_HDR;
+        store_mark_boot(store, 0);
+        printf("[STORE] 보관 영역 초기화: %lu 섹터 @ 0x%08lx\n",
+               (unsigned long)store.sectors, (unsigned long)store.base);
+        return true;
+    }
+
+    if (newest - oldest >= store.sectors) {
+        oldest = newest - store.sectors + 1;
+    }
+
+    // 쓰기 위치: 최신 섹터의 마지막 유효 기록 뒤
+    store.write_seq = newest;
+    store.flushed_off = FLASH_SECTOR_SIZE;
+    uint32_t off = STORE_SECTOR_HDR;
+    const StoreRecordHeader* hdr;
+    while ((hdr = store_record(store, newest, off)) != NULL) {
+        off += rec_size(hdr->topic_len, hdr->payload_len);
+    }
+    store.write_off = off;
+    store.flushed_off = off;
+    store.page_off = (off - 1) & ~(FLASH_PAGE_SIZE - 1);   // 섹터가 꽉 찬 경우에도 섹터 안의 페이지
+    memcpy(store.page, flash_ptr(sector_base(store, newest) + store.page_off), FLASH_PAGE_SIZE);
+
+    // 읽기 위치 / 미전송 수
+    store.read_seq = oldest;
+    store.read_off = STORE_SECTOR_HDR;
+    for (uint32_t seq = oldest; seq != newest + 1; seq++) {
+        store.pending += store_count_pending(store, seq, STORE_SECTOR_HDR);
+    }
+
+    // 가장 최근 부팅 번호 (새 섹터로 넘어간 직후라 기록이 없으면 앞 섹터에서)
+    uint32_t last_boot = 0;
+    for (uint32_t seq = newest; last_boot == 0; seq--) {
+        last_boot = store_last_boot(store, seq);
+        if (seq == oldest) {
+            break;
+        }
+    }
+
+    // 기록 중 끊긴 잔여 바이트가 있으면 그 위에 덧쓰지 않도록 새 섹터에서 시작
+    const uint8_t* tail = flash_ptr(sector_base(store, newest));
+    for (uint32_t i = off; i < FLASH_SECTOR_SIZE; i++) {
+        if (tail[i] != 0xFF) {
+            store_next_sector(store);
+            break;
+        }
+    }
+
+    store_mark_boot(store, last_boot);
+    printf("[STORE] 보관 로그 복구: 섹터 %lu~%lu, 미전송 %lu건, 부팅 #%lu\n",
+           (unsigned long)oldest, (unsigned long)newest, (unsigned long)store.pending, (unsigned long)store.boot);
+    return true;
+}
+
+bool mqtt_store_append(MqttStore& store, const char* topic, const char* payload, uint32_t payload_len,
+                       int qos, int retain) {
+    // NULL 포인터 및 길이 검증
+    if (!store.sectors || !topic || !payload) {
+        return false;
+    }
+    size_t topic_len = strlen(topic);
+    if (topic_len == 0 || topic_len > MQTT_STORE_TOPIC_MAX || payload_len > MQTT_STORE_PAYLOAD_MAX) {
+        printf("[STORE] 기록 길이 초과: 토픽 %u, 페이로드 %lu\n", (unsigned)topic_len, (unsigned long)payload_len);
+        store.dropped++;
+        return false;
+    }
+
+    store_write(store, topic, (uint32_t)topic_len, payload, payload_len,
+                (uint8_t)(REC_PENDING | (qos & REC_QOS_MASK) | (retain ? REC_RETAIN : 0)));
+    store.stored++;
+    store.pending++;
+    return true;
+}
+
+bool mqtt_store_peek(MqttStore& store, MqttStoredMessage* msg) {
+    // NULL 포인터 검증
+    if (!msg || !store.sectors) {
+        return false;
+    }
+
+    while (true) {
+        const StoreRecordHeader* hdr = store_record(store, store.read_seq, store.read_off);
+        if (!hdr) {
+            if (store.read_seq == store.write_seq) {
+                return false;  // 플래시에 기록된 미전송 기록 없음
+            }
+            store.read_seq++;
+            store.read_off = STORE_SECTOR_HDR;
+            continue;
+        }
+        if (!(hdr->flags & REC_PENDING)) {
+            // 재부팅 전에 이미 전송된 기록
+            store.read_off += rec_size(hdr->topic_len, hdr->payload_len);
+            continue;
+        }
+
+        const char* topic = (const char*)(hdr + 1);
+        msg->topic = topic;
+        msg->payload = topic + hdr->topic_len + 1;
+        msg->payload_len = hdr->payload_len;
+        msg->qos = hdr->flags & REC_QOS_MASK;
+        msg->retain = (hdr->flags & REC_RETAIN) ? 1 : 0;
+        store.peek_seq = store.read_seq;
+        store.peek_off = store.read_off;
+        return true;
+    }
+}
+
+void mqtt_store_ack(MqttStore& store) {
+    // peek 이후 보관 한도 초과로 지워졌으면 무시
+    if (store.peek_off == 0 || store.peek_seq != store.read_seq || store.peek_off != store.read_off) {
+        return;
+    }
+    const StoreRecordHeader* hdr = store_record(store, store.read_seq, store.read_off);
+    if (!hdr) {
+        return;
+    }
+
+    // 완료 표시는 다음 poll에서 기록 (앞선 표시가 남아 있으면 먼저 기록)
+    if (store.ack_off) {
+        store_program_ack(store);
+    }
+    store.ack_off = sector_base(store, store.read_seq) + store.read_off + offsetof(StoreRecordHeader, flags);
+    store.read_off += rec_size(hdr->topic_len, hdr->payload_len);
+    store.peek_off = 0;
+    store.pending--;
+    store.replayed++;
+}
+
+void mqtt_store_poll(MqttStore& store) {
+    if (!store.sectors) {
+        return;
+    }
+
+    // 호출당 플래시 작업 하나 (지우기 > 완료 표시 > 부분 페이지 기록 순)
+    if (store.erase_pending && store.page_dirty) {
+        store_erase(store);
+        return;
+    }
+    if (store.ack_off) {
+        store_program_ack(store);
+        return;
+    }
+    if (store.page_dirty && to_ms_since_boot(get_absolute_time()) - store.last_append_ms >= MQTT_STORE_FLUSH_MS) {
+        store_flush_page(store);
+    }
+}
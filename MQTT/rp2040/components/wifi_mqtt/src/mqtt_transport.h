@@ -0,0 +1,27 @@
+#ifndef MQTT_TRANSPORT_H
+#define MQTT_TRANSPORT_H
+
+// 전송 계층 내부 함수 (라이브러리 내부 전용)
+// 발신 큐/QoS 1/구독 관리자는 이 함수들만 사용하고, 구현은 MQTT_NATIVE_TRANSPORT에 따라
+// mqtt_client.cpp(AT 명령) 또는 mqtt_native.cpp(투명 전송 + MQTT 패킷)가 제공
+
+#include "mqtt_client.h"
+
+// 비차단 발행 제출 (발행 통계의 제출 시각 FIFO에 등록), 완료 콜백은 제출 순서대로 호출
+bool mqtt_submit_publish(MqttClient& client, const char* topic, const char* message, int qos, int retain,
+                         AtCallback done);
+
+// 비차단 구독 제출 (재시도/지연 없음), 결과 0 = 성공
+bool mqtt_submit_subscribe(MqttClient& client, const char* filter, int qos, AtCallback done, void* user);
+
+// 지금 더 제출할 수 있는 요청 수 (0 = 완료를 기다려야 함)
+uint32_t mqtt_submit_room(MqttClient& client);
+
+// 전송 계층 진행 (mqtt_outbox_poll에서 호출: 확인 시간 초과, 연결 단계 전환 등)
+void mqtt_transport_poll(MqttClient& client);
+
+// 발행 결과 공통 처리 (지연 표본 기록 / 연결 상태 반영)
+void mqtt_publish_record(MqttClient& client, int result, uint32_t start_us);
+void mqtt_publish_result(MqttClient& client, int result);
+
+#endif // MQTT_TRANSPORT_H
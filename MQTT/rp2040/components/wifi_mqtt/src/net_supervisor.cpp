@@ -0,0 +1,387 @@
+#include "net_supervisor.h"
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/unique_id.h"
+
+static inline bool ms_reached(uint32_t now, uint32_t at_ms) {
+    return (int32_t)(now - at_ms) >= 0;
+}
+
+// xorshift32 (지터용, 보드마다 다른 수열)
+static uint32_t sup_rand(NetSupervisor& sup) {
+    uint32_t x = sup.rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sup.rng = x;
+    return x;
+}
+
+// [limit/2, limit] 안의 대기 시간 (절반은 보장해 연속 실패 시 간격이 확실히 늘어남)
+static uint32_t sup_jitter(NetSupervisor& sup, uint32_t limit_ms) {
+    uint32_t half = limit_ms / 2;
+    return half + sup_rand(sup) % (limit_ms - half + 1);
+}
+
+static void on_init_done(int result, void* user) {
+    NetSupervisor& sup = *(NetSupervisor*)user;
+    sup.init_result = result;
+}
+
+// ===== 콜드 스타트 측정 =====
+
+// 리셋 직후 호출: 이후 첫 발행 성공까지 시간 측정 (발행 통계의 첫 성공 시각을 비워 다시 기록)
+static void sup_cold_start(NetSupervisor& sup) {
+    sup.cold_pending = true;
+    sup.mqtt->pub_stats.first_ok_ms = 0;
+}
+
+// 첫 발행 성공 확인 (리셋 해제 → 발행 완료, 모듈 부팅 시간 포함)
+// 감시자가 알아챈 시각이 아니라 발행 통계에 남은 성공 시각으로 계산 (감시자가 늦게 만들어져도 정확)
+static void sup_track_cold_start(NetSupervisor& sup) {
+    uint32_t ok_ms = sup.mqtt->pub_stats.first_ok_ms;
+    if (!sup.cold_pending || ok_ms == 0) {
+        return;
+    }
+    sup.cold_pending = false;
+    uint32_t took = ok_ms - sup.esp01->reset_ms;
+    NetSupervisorStats& st = sup.stats;
+    st.cold_starts++;
+    st.last_cold_ms = took;
+    if (took > st.max_cold_ms) {
+        st.max_cold_ms = took;
+    }
+    printf("[NET] 콜드 스타트: 리셋 → 첫 발행 %lu ms (모듈 부팅 %lu ms)\n",
+           (unsigned long)took, (unsigned long)sup.esp01->ready_ms);
+}
+
+// ===== 상태 전이 =====
+
+// 다음 시도 예약 (지수 백오프 + 지터)
+static void sup_schedule(NetSupervisor& sup, uint32_t now) {
+    uint32_t wait = sup_jitter(sup, sup.backoff_ms);
+    sup.backoff_ms = (sup.backoff_ms >= NET_SUP_BACKOFF_MAX_MS / 2) ? NET_SUP_BACKOFF_MAX_MS : sup.backoff_ms * 2;
+    sup.retry_at = now + wait;
+    sup.state = NET_SUP_BACKOFF;
+    printf("[NET] %lu ms 후 재시도 (%s 단계)\n", (unsigned long)wait, net_supervisor_tier_name(sup.tier));
+}
+
+// 시도 실패: 같은 단계에서 한도만큼 실패하면 다음 단계로 격상
+static void sup_fail(NetSupervisor& sup, uint32_t now) {
+    if (++sup.tier_failures >= NET_SUP_TIER_ATTEMPTS && sup.tier < NET_TIER_RESET) {
+        sup.tier = (NetTier)(sup.tier + 1);
+        sup.tier_failures = 0;
+        printf("[NET] 복구 단계 격상: %s\n", net_supervisor_tier_name(sup.tier));
+    }
+    sup_schedule(sup, now);
+}
+
+static void sup_join_wifi(NetSupervisor& sup, uint32_t now) {
+    sup.stats.wifi_rejoins++;
+    if (esp01_connect_wifi_async(*sup.esp01)) {
+        sup.state = NET_SUP_WIFI_JOIN;
+    } else {
+        sup_fail(sup, now);
+    }
+}
+
+static void sup_connect_mqtt(NetSupervisor& sup, uint32_t now) {
+    if (mqtt_connect_async(*sup.mqtt)) {
+        sup.state = NET_SUP_MQTT_CONNECT;
+    } else {
+        sup_fail(sup, now);
+    }
+}
+
+static void sup_recovered(NetSupervisor& sup, uint32_t now) {
+    uint32_t took = now - sup.down_since;
+    NetSupervisorStats& st = sup.stats;
+    st.recoveries++;
+    st.last_recover_ms = took;
+    st.total_recover_ms += took;
+    if (took > st.max_recover_ms) {
+        st.max_recover_ms = took;
+    }
+    printf("[NET] 복구 완료: %lu ms (%s 단계, 누적 시도 %lu)\n",
+           (unsigned long)took, net_supervisor_tier_name(sup.tier), (unsigned long)st.attempts);
+
+    sup.state = NET_SUP_ONLINE;
+    sup.tier = NET_TIER_MQTT;
+    sup.tier_failures = 0;
+    sup.backoff_ms = NET_SUP_BACKOFF_BASE_MS;
+    sup.last_check = now;
+}
+
+// 브로커 연결 확인 후 앱 복원 시작 (복원 훅이 없으면 바로 정상)
+static void sup_begin_restore(NetSupervisor& sup, uint32_t now) {
+    if (!sup.restore) {
+        sup_recovered(sup, now);
+        return;
+    }
+    if (sup.restore->submit(*sup.mqtt, sup.restore_attempt, sup.restore->user)) {
+        sup.state = NET_SUP_RESTORE;
+    }
+}
+
+// 끊김 시작 기록, 복구는 MQTT 단계부터
+static void sup_outage(NetSupervisor& sup, uint32_t now) {
+    sup.stats.outages++;
+    sup.down_since = now;
+    sup.tier = NET_TIER_MQTT;
+    sup.tier_failures = 0;
+    sup.backoff_ms = NET_SUP_BACKOFF_BASE_MS;
+}
+
+// 모듈이 스스로 재부팅: 부팅은 이미 끝났으므로 리셋 펄스 없이 재초기화부터
+static void sup_module_rebooted(NetSupervisor& sup, uint32_t now) {
+    printf("[NET] 모듈 재부팅 감지 - 재초기화\n");
+    if (sup.state == NET_SUP_ONLINE) {
+        sup_outage(sup, now);
+    }
+    mqtt_link_reset(*sup.mqtt);
+    sup.tier = NET_TIER_RESET;
+    sup.tier_failures = 0;
+    sup_cold_start(sup);
+    sup.boot_deadline = now;
+    sup.retry_at = now;
+    sup.state = NET_SUP_RESET_BOOT;
+}
+
+// 현재 단계의 시도 시작
+static void sup_attempt(NetSupervisor& sup, uint32_t now) {
+    sup.stats.attempts++;
+    switch (sup.tier) {
+    case NET_TIER_MQTT:
+        esp01_query_status_async(*sup.esp01);
+        sup.state = NET_SUP_WIFI_CHECK;
+        break;
+
+    case NET_TIER_WIFI:
+        printf("[NET] WiFi 재접속\n");
+        sup_join_wifi(sup, now);
+        break;
+
+    case NET_TIER_RESET:
+        printf("[NET] 모듈 리셋\n");
+        sup.stats.module_resets++;
+        mqtt_link_reset(*sup.mqtt);
+        esp01_reset_assert(*sup.esp01);
+        sup_cold_start(sup);
+        sup.retry_at = now + ESP01_RESET_PULSE_MS;
+        sup.state = NET_SUP_RESET_PULSE;
+        break;
+    }
+}
+
+// ===== 공개 API =====
+
+void net_supervisor_init(NetSupervisor& sup, Esp01Module& esp01, MqttClient& mqtt, const NetRestoreHooks* restore) {
+    sup = NetSupervisor();
+    sup.esp01 = &esp01;
+    sup.mqtt = &mqtt;
+    sup.at = esp01.link ? esp01.link->at : NULL;
+    sup.restore = restore;
+    sup.state = NET_SUP_ONLINE;
+    sup.tier = NET_TIER_MQTT;
+    sup.backoff_ms = NET_SUP_BACKOFF_BASE_MS;
+    sup.init_result = AT_RESULT_PENDING;
+    sup.check_interval_ms = NET_SUP_CHECK_INTERVAL_MS;
+
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    sup.last_check = now;
+    sup.retry_at = now;
+
+    // 보드 고유 ID로 시드 → 같은 펌웨어라도 보드마다 재시도 시각이 흩어짐
+    pico_unique_board_id_t board_id;
+    pico_get_unique_board_id(&board_id);
+    uint32_t seed = 2166136261u;  // FNV-1a
+    for (int i = 0; i < PICO_UNIQUE_BOARD_ID_SIZE_BYTES; i++) {
+        seed = (seed ^ board_id.id[i]) * 16777619u;
+    }
+    sup.rng = seed ? seed : 1;
+
+    // 부팅 리셋부터 첫 발행까지 (이미 발행했으면 그 성공 시각으로 지금 기록)
+    sup.cold_pending = true;
+    sup_track_cold_start(sup);
+}
+
+void net_supervisor_poll(NetSupervisor& sup, uint32_t now) {
+    sup_track_cold_start(sup);
+    if (!sup.at || at_engine_busy(*sup.at) || !ms_reached(now, sup.retry_at)) {
+        return;
+    }
+
+    // 리셋 중이 아닐 때 온 "ready" 배너 (WiFi/MQTT 연결이 이미 사라짐)
+    if (sup.esp01->rebooted) {
+        sup.esp01->rebooted = false;
+        sup_module_rebooted(sup, now);
+        return;
+    }
+
+    MqttClient& mqtt = *sup.mqtt;
+    switch (sup.state) {
+    case NET_SUP_ONLINE:
+        if (mqtt_is_connected(mqtt)) {
+            if (now - sup.last_check >= sup.check_interval_ms) {
+                sup.last_check = now;
+                mqtt_check_connection_async(mqtt);
+            }
+            return;
+        }
+        printf("[NET] MQTT 연결 끊김 감지\n");
+        sup_outage(sup, now);
+        // 첫 시도도 지터만큼 늦춤 (같은 AP의 보드들이 동시에 끊김을 감지하므로)
+        sup.retry_at = now + sup_rand(sup) % NET_SUP_BACKOFF_BASE_MS;
+        sup.state = NET_SUP_BACKOFF;
+        break;
+
+    case NET_SUP_BACKOFF:
+        sup_attempt(sup, now);
+        break;
+
+    case NET_SUP_WIFI_CHECK:
+        if (sup.esp01->wifi_connected) {
+            // WiFi는 연결됨, MQTT만 재연결 (확인 중 URC로 이미 복구됐으면 바로 복원)
+            sup.restore_attempt = 0;
+            if (mqtt_is_connected(mqtt)) {
+                sup_begin_restore(sup, now);
+            } else {
+                sup_connect_mqtt(sup, now);
+            }
+        } else {
+            // WiFi 끊김은 확인된 원인이므로 실패로 세지 않고 바로 재접속 단계로
+            printf("[NET] WiFi 연결 끊김 감지\n");
+            sup.tier = NET_TIER_WIFI;
+            sup.tier_failures = 0;
+            sup_join_wifi(sup, now);
+        }
+        break;
+
+    case NET_SUP_WIFI_JOIN:
+        if (sup.esp01->wifi_connected) {
+            sup.restore_attempt = 0;
+            sup_connect_mqtt(sup, now);
+        } else {
+            sup_fail(sup, now);
+        }
+        break;
+
+    case NET_SUP_MQTT_CONNECT:
+        if (mqtt_connect_pending(mqtt)) {
+            return;  // 네이티브 전송: 투명 전송 시작 후 CONNACK 대기 중
+        }
+        if (!mqtt_is_connected(mqtt)) {
+            sup_fail(sup, now);
+            break;
+        }
+        sup_begin_restore(sup, now);
+        break;
+
+    case NET_SUP_RESTORE: {
+        if (!mqtt_is_connected(mqtt)) {
+            sup_fail(sup, now);
+            break;
+        }
+        NetRestoreResult r = sup.restore->check(mqtt, sup.restore_attempt, sup.restore->user);
+        if (r == NET_RESTORE_DONE) {
+            sup_recovered(sup, now);
+        } else if (r == NET_RESTORE_RETRY) {
+            // 연결은 살아 있으므로 단계 격상 없이 짧은 간격 후 다시 제출
+            sup.restore_attempt++;
+            sup.retry_at = now + NET_SUP_RESTORE_RETRY_MS;
+            sup.state = NET_SUP_MQTT_CONNECT;
+        }
+        break;
+    }
+
+    case NET_SUP_RESET_PULSE:
+        esp01_reset_release(*sup.esp01);
+        sup.boot_deadline = now + ESP01_BOOT_WAIT_MS;
+        sup.state = NET_SUP_RESET_BOOT;
+        break;
+
+    case NET_SUP_RESET_BOOT:
+        // "ready" 배너나 짧은 간격 AT 응답이 오면 바로, 없으면 한도까지 기다린 뒤 재초기화의 AT로 확인
+        if (!sup.esp01->ready && !ms_reached(now, sup.boot_deadline)) {
+            if (esp01_probe_ready_async(*sup.esp01)) {
+                sup.retry_at = now + ESP01_READY_PROBE_MS;
+            }
+            return;
+        }
+        sup.init_result = AT_RESULT_PENDING;
+        if (esp01_at_init_async(*sup.esp01, on_init_done, &sup)) {
+            sup.state = NET_SUP_RESET_INIT;
+        } else {
+            sup_fail(sup, now);
+        }
+        break;
+
+    case NET_SUP_RESET_INIT:
+        if (sup.init_result != 0) {
+            printf("[NET] 모듈 재초기화 실패 (%d)\n", sup.init_result);
+            sup_fail(sup, now);
+            break;
+        }
+        sup_join_wifi(sup, now);
+        break;
+    }
+}
+
+bool net_supervisor_online(const NetSupervisor& sup) {
+    return sup.state == NET_SUP_ONLINE;
+}
+
+uint32_t net_supervisor_down_ms(const NetSupervisor& sup, uint32_t now) {
+    return sup.state == NET_SUP_ONLINE ? 0 : now - sup.down_since;
+}
+
+const char* net_supervisor_state_name(NetSupervisorState state) {
+    switch (state) {
+    case NET_SUP_ONLINE:       return "online";
+    case NET_SUP_BACKOFF:      return "backoff";
+    case NET_SUP_WIFI_CHECK:   return "wifi_check";
+    case NET_SUP_WIFI_JOIN:    return "wifi_join";
+    case NET_SUP_MQTT_CONNECT: return "mqtt_connect";
+    case NET_SUP_RESTORE:      return "restore";
+    case NET_SUP_RESET_PULSE:  return "reset_pulse";
+    case NET_SUP_RESET_BOOT:   return "reset_boot";
+    case NET_SUP_RESET_INIT:   return "reset_init";
+    }
+    return "?";
+}
+
+const char* net_supervisor_tier_name(NetTier tier) {
+    switch (tier) {
+    case NET_TIER_MQTT:  return "mqtt";
+    case NET_TIER_WIFI:  return "wifi";
+    case NET_TIER_RESET: return "reset";
+    }
+    return "?";
+}
+
+int net_supervisor_format_stats(const NetSupervisor& sup, uint32_t now, char* buffer, int max_len) {
+    // NULL 포인터 및 길이 검증
+    if (!buffer || max_len <= 0) {
+        return -1;
+    }
+
+    const NetSupervisorStats& st = sup.stats;
+    uint32_t avg = st.recoveries ? (uint32_t)(st.total_recover_ms / st.recoveries) : 0;
+    int written = snprintf(buffer, max_len,
+                           "{\"state\":\"%s\",\"tier\":\"%s\",\"down_ms\":%lu,\"outages\":%lu,\"recoveries\":%lu,"
+                           "\"attempts\":%lu,\"rejoins\":%lu,\"resets\":%lu,\"last_ms\":%lu,\"avg_ms\":%lu,\"max_ms\":%lu,"
+                           "\"cold_starts\":%lu,\"cold_ms\":%lu,\"cold_max_ms\":%lu,\"boot_ms\":%lu}",
+                           net_supervisor_state_name(sup.state), net_supervisor_tier_name(sup.tier),
+                           (unsigned long)net_supervisor_down_ms(sup, now), (unsigned long)st.outages,
+                           (unsigned long)st.recoveries, (unsigned long)st.attempts,
+                           (unsigned long)st.wifi_rejoins, (unsigned long)st.module_resets,
+                           (unsigned long)st.last_recover_ms, (unsigned long)avg,
+                           (unsigned long)st.max_recover_ms, (unsigned long)st.cold_starts,
+                           (unsigned long)st.last_cold_ms, (unsigned long)st.max_cold_ms,
+                           (unsigned long)sup.esp01->ready_ms);
+    if (written < 0 || written >= max_len) {
+        printf("[NET] 통계 JSON 버퍼 부족\n");
+        return -1;
+    }
+    return written;
+}
@@ -1,266 +1,1734 @@
 #include "uart_comm.h"
+#include "at_engine.h"  // at_engine_pending (수신 감시 타이머 가동 조건)
 #include <string.h>
 #include <stdio.h>
 #include "pico/stdlib.h"
 #include "hardware/irq.h"
-#include "hardware/sync.h"  // save_and_disable_interrupts, restore_interrupts
+#include "hardware/sync.h"  // __sev
+#include "hardware/dma.h"
 
-#define RX_BUFFER_SIZE 1024  // ESP-01 긴 응답 처리를 위해 복원
+// 응답 대기 방식: 0 = RX 이벤트(SEV)로 깨어나는 WFE 대기, N > 0 = 기존 N ms 폴링 (전/후 비교 측정용)
+#ifndef UART_WAIT_POLL_MS
+#define UART_WAIT_POLL_MS 0
+#endif
 
 // RP2040 GPIO 유효 범위
 #define GPIO_MIN 0
 #define GPIO_MAX 29
 
-static uart_inst_t* g_uart = NULL;
-static volatile char rx_buffer[RX_BUFFER_SIZE];
-static volatile uint16_t rx_head = 0;  // 쓰기 위치 (생산자)
-static volatile uint16_t rx_tail = 0;  // 읽기 위치 (소비자)
+// RP2040 UART 개수 (uart0, uart1)
+#define NUM_UARTS 2
 
+// TX 큐가 비기를 기다리는 최대 시간 (보드레이트 전환 전)
+#define UART_SWITCH_TX_TIMEOUT_MS 100
+
+// 복사 전송이 TX 공간을 기다리는 최대 시간 (DMA가 멈춰 있으면 - CTS 정지 등 - 포기)
+#define UART_TX_WAIT_TIMEOUT_MS 200
+
+// AT 왕복 시간 히스토그램 구간 경계
+static const uint32_t RTT_BUCKET_LIMIT_MS[UART_RTT_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000
+};
+
+static const char CRLF[] = "\r\n";
+
+// UART 오류 인터럽트 (IMSC/MIS/ICR 비트 위치 동일)
+#define UART_ERROR_IRQ_BITS (UART_UARTIMSC_OEIM_BITS | UART_UARTIMSC_BEIM_BITS | \
+                             UART_UARTIMSC_PEIM_BITS | UART_UARTIMSC_FEIM_BITS)
+
+// UART 인덱스 → 링크 (인터럽트 핸들러에서 컨텍스트 조회용)
+static UartLink* s_links[NUM_UARTS] = { NULL, NULL };
+
+// ===== 통계 =====
+// ISR 처리 시간 최대값 갱신
+static inline void isr_time_record(UartLink& link, uint32_t start_us) {
+    uint32_t elapsed = time_us_32() - start_us;
+    if (elapsed > link.max_isr_us) {
+        link.max_isr_us = elapsed;
+    }
+}
+
+// 인터럽트 금지 구간 시작/종료 (금지 시간 최대값 기록)
+static inline uint32_t irq_mask_begin(uint32_t* start_us) {
+    *start_us = time_us_32();
+    return save_and_disable_interrupts();
+}
+
+static inline void irq_mask_end(UartLink& link, uint32_t irq_state, uint32_t start_us) {
+    uint32_t elapsed = time_us_32() - start_us;
+    restore_interrupts(irq_state);
+    if (elapsed > link.max_irq_masked_us) {
+        link.max_irq_masked_us = elapsed;
+    }
+}
+
+// 링버퍼 점유량 최대값 갱신
+static inline void rx_hwm_record(UartLink& link, uint32_t used) {
+    if (used > link.rx_hwm) {
+        link.rx_hwm = used;
+    }
+}
+
+// UART 오류 플래그 집계 후 해제 (RX 인터럽트와 같은 벡터에서 처리)
+static void uart_count_errors(UartLink& link) {
+    uart_hw_t* hw = uart_get_hw(link.uart);
+    uint32_t mis = hw->mis & UART_ERROR_IRQ_BITS;
+    if (!mis) {
+        return;
+    }
+    if (mis & UART_UARTMIS_OEMIS_BITS) {
+        link.err_overrun++;
+    }
+    if (mis & UART_UARTMIS_FEMIS_BITS) {
+        link.err_framing++;
+    }
+    if (mis & UART_UARTMIS_BEMIS_BITS) {
+        link.err_break++;
+    }
+    if (mis & UART_UARTMIS_PEMIS_BITS) {
+        link.err_parity++;
+    }
+    hw->icr = mis;
+    hw->rsr = 0;  // 수신 상태(sticky) 오류 플래그 해제
+}
+
+// ===== RX =====
+#if UART_RX_USE_DMA
+// DMA가 지금까지 링버퍼에 쓴 누적 바이트 수
+// 읽는 사이 링 한 바퀴 ISR이 끼어들면 runs/transfer_count가 어긋나므로 다시 읽음
+static uint32_t rx_dma_total(UartLink& link) {
+    uint32_t runs;
+    uint32_t remaining;
+    do {
+        runs = link.rx_dma_runs;
+        remaining = dma_channel_hw_addr(link.rx_dma_chan)->transfer_count;
+    } while (runs != link.rx_dma_runs);
+    return runs * UartRxRing::CAPACITY + (UartRxRing::CAPACITY - remaining);
+}
+
+// 깨어날 때마다 그 사이 DMA가 옮긴 바이트를 집계
+static void rx_dma_account_wakeup(UartLink& link) {
+    uint32_t total = rx_dma_total(link);
+    link.rx_stats.bytes += total - link.rx_dma_last_total;
+    link.rx_stats.wakeups++;
+    link.rx_dma_last_total = total;
+}
+
+// UART 인터럽트: 수신 오류 집계만 담당
+// (RXDMAE 설정 시 DMA가 FIFO를 바로 비우므로 수신 타임아웃(RTIM)은 깨어남 수단이 되지 못함)
+static void link_uart_irq(UartLink& link) {
+    uint32_t start_us = time_us_32();
+    uart_count_errors(link);
+    isr_time_record(link, start_us);
+}
+
+// 수신 감시 타이머 (알람 인터럽트): DMA 쓰기 위치가 움직였으면 WFE 대기 중인 코어 깨움
+// 수신이 없어도 인터럽트 진입이므로 매번 깨어남 통계에 셈 (bytes / wakeups가 실제 비용을 반영)
+// 알람/DMA 인터럽트는 같은 우선순위라 서로 선점하지 않음 → rx_dma_account_wakeup 공유 가능
+static bool rx_dma_watch(repeating_timer_t* rt) {
+    UartLink& link = *(UartLink*)rt->user_data;
+    uint32_t start_us = time_us_32();
+    if (link.rx_dma_chan >= 0) {
+        uint32_t last_total = link.rx_dma_last_total;
+        rx_dma_account_wakeup(link);
+        if (link.rx_dma_last_total != last_total) {
+            __sev();
+        }
+    }
+    isr_time_record(link, start_us);
+    return true;
+}
+
+// 감시 타이머가 필요한 링크: 응답(진행 중인 AT 명령, uart_wait_any)이나 남은 프레임 페이로드,
+// 투명 전송 데이터를 기다리는 동안만 (그 외 수신은 uart_wait_event의 10 ms 상한 안에 처리)
+static bool rx_watch_wanted(UartLink& link) {
+    return (link.at && at_engine_pending(*link.at) > 0) || link.rx_waiters > 0 ||
+           link.frame_active || link.passthrough;
+}
+
+// 대기 직전에 링크별 감시 타이머를 필요에 맞게 켜고 끔 (메인 루프 전용, 유휴 상태에서는 알람 인터럽트 없음)
+static void rx_watch_update() {
+    static bool warned = false;
+    for (int i = 0; i < NUM_UARTS; i++) {
+        UartLink* link = s_links[i];
+        if (!link || link->rx_dma_chan < 0) {
+            continue;
+        }
+        bool wanted = rx_watch_wanted(*link);
+        if (wanted && !link->rx_watch_active) {
+            link->rx_watch_active = add_repeating_timer_us(-(int64_t)UART_RX_DMA_WATCH_US, rx_dma_watch, link,
+                                                           &link->rx_watch_timer);
+            if (!link->rx_watch_active && !warned) {
+                printf("[UART] 수신 감시 타이머 등록 실패 - 응답 대기는 10 ms 주기로 동작\n");
+                warned = true;
+            }
+        } else if (!wanted && link->rx_watch_active) {
+            cancel_repeating_timer(&link->rx_watch_timer);
+            link->rx_watch_active = false;
+        }
+    }
+}
+
+// DMA 인터럽트: 링 한 바퀴 완료 시 같은 링에 다시 전송 시작
+static void link_rx_dma_irq(UartLink& link) {
+    if (link.rx_dma_chan < 0 || !dma_channel_get_irq0_status(link.rx_dma_chan)) {
+        return;
+    }
+    uint32_t start_us = time_us_32();
+    dma_channel_acknowledge_irq0(link.rx_dma_chan);
+    link.rx_dma_runs++;
+    dma_channel_set_trans_count(link.rx_dma_chan, UartRxRing::CAPACITY, true);
+    rx_dma_account_wakeup(link);
+    __sev();
+    isr_time_record(link, start_us);
+}
+
+// DMA 쓰기 주소까지 링의 head 공개 (깨어남 여부와 무관하게 항상 최신)
+// 메인 루프만 호출 → head 기록자는 하나뿐이므로 SPSC 조건 유지
+static inline void rx_sync(UartLink& link) {
+    if (link.rx_dma_chan < 0) {
+        return;
+    }
+    uintptr_t write_addr = dma_channel_hw_addr(link.rx_dma_chan)->write_addr;
+    uint32_t pos = (uint32_t)(write_addr - (uintptr_t)link.rx_ring.storage());
+    uint32_t head = link.rx_ring.head();
+    head += (pos - head) & UartRxRing::MASK;
+
+    // DMA가 읽지 않은 데이터를 덮어썼으면 (링 한 바퀴 이상 앞섬) 남은 최신 CAPACITY 바이트만 유효
+    uint32_t total = rx_dma_total(link);
+    uint32_t tail = link.rx_ring.tail();
+    if ((int32_t)(total - tail) > (int32_t)UartRxRing::CAPACITY) {
+        link.rx_dropped += total - tail - UartRxRing::CAPACITY;
+        link.rx_ring.publish(total);
+        link.rx_ring.consume_to(total - UartRxRing::CAPACITY);
+        rx_hwm_record(link, UartRxRing::CAPACITY);
+        return;
+    }
+
+    link.rx_ring.publish(head);
+    rx_hwm_record(link, head - tail);
+}
+
+static void rx_dma_start(UartLink& link) {
+    if (link.rx_dma_chan < 0) {
+        link.rx_dma_chan = dma_claim_unused_channel(true);
+    } else {
+        dma_channel_abort(link.rx_dma_chan);  // 재초기화 (esp01_module_init 재호출)
+    }
+
+    dma_channel_config cfg = dma_channel_get_default_config(link.rx_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, false);
+    channel_config_set_write_increment(&cfg, true);
+    channel_config_set_ring(&cfg, true, UartRxRing::BITS);  // 쓰기 주소를 링버퍼 안에서 순환
+    channel_config_set_dreq(&cfg, uart_get_dreq(link.uart, false));
+
+    link.rx_dma_runs = 0;
+    link.rx_dma_last_total = 0;
+
+    dma_channel_set_irq0_enabled(link.rx_dma_chan, true);
+    dma_channel_configure(link.rx_dma_chan, &cfg, link.rx_ring.storage(), &uart_get_hw(link.uart)->dr,
+                          UartRxRing::CAPACITY, true);
+    hw_set_bits(&uart_get_hw(link.uart)->dmacr, UART_UARTDMACR_RXDMAE_BITS);
+    // 감시 타이머는 uart_wait_event가 응답을 기다릴 때 켬 (rx_watch_update)
+}
+#else
 // UART RX 인터럽트 핸들러
-static void on_uart_rx(void) {
-    while (uart_is_readable(g_uart)) {
-        char ch = uart_getc(g_uart);
-        uint16_t next_head = (rx_head + 1) % RX_BUFFER_SIZE;
-        if (next_head != rx_tail) {
-            rx_buffer[rx_head] = ch;
-            rx_head = next_head;
+static void link_uart_irq(UartLink& link) {
+    uint32_t start_us = time_us_32();
+    uint32_t moved = 0;
+    uint32_t dropped = 0;
+    bool line_end = false;
+    uart_count_errors(link);
+    while (uart_is_readable(link.uart)) {
+        char ch = uart_getc(link.uart);
+        if (link.rx_ring.push(ch)) {
+            moved++;
+        } else {
+            dropped++;  // 링버퍼 가득 참
+        }
+        // 라인 종료 또는 발행 프롬프트(개행 없음)
+        if (ch == '\n' || ch == '>') {
+            line_end = true;
+        }
+    }
+    link.rx_stats.bytes += moved;
+    link.rx_stats.wakeups++;
+    link.rx_dropped += dropped;
+    rx_hwm_record(link, link.rx_ring.head() - link.rx_ring.tail());
+
+    if (line_end) {
+        __sev();  // WFE 대기 중인 코어 깨움
+    }
+    isr_time_record(link, start_us);
+}
+
+static void link_rx_dma_irq(UartLink& link) {
+}
+
+// 인터럽트 모드에서는 ISR이 직접 head를 공개
+static inline void rx_sync(UartLink& link) {
+}
+#endif
+
+// ===== URC 분배 =====
+// rx_ring의 [from, to) 구간을 응답 링으로 복사 (가득 차면 가장 오래된 응답부터 버림)
+static void resp_append(UartLink& link, uint32_t from, uint32_t to) {
+    uint32_t len = to - from;
+    if (len > UartRespRing::CAPACITY) {
+        from = to - UartRespRing::CAPACITY;
+        len = UartRespRing::CAPACITY;
+    }
+    uint32_t space = UartRespRing::CAPACITY - link.resp_ring.size();
+    if (len > space) {
+        link.resp_ring.consume(len - space);  // 응답 링은 생산/소비 모두 메인 루프
+    }
+    for (uint32_t pos = from; pos != to; pos++) {
+        link.resp_ring.push(link.rx_ring.at(pos));
+    }
+}
+
+// rx_ring의 [from, to) 구간이 prefix로 시작하는지
+static bool line_has_prefix(UartLink& link, uint32_t from, uint32_t to, const char* prefix, uint32_t prefix_len) {
+    if (to - from < prefix_len) {
+        return false;
+    }
+    for (uint32_t i = 0; i < prefix_len; i++) {
+        if (link.rx_ring.at(from + i) != prefix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 완성된 한 줄 [from, to) ('\n' 포함) 분배
+static void demux_line(UartLink& link, uint32_t from, uint32_t to) {
+    for (int i = 0; i < link.urc_count; i++) {
+        const UartUrcEntry& entry = link.urc_table[i];
+        if (!line_has_prefix(link, from, to, entry.prefix, entry.prefix_len)) {
+            continue;
+        }
+
+        if (!entry.handler) {
+            // 큐잉 URC는 frame_begin이 헤더를 해석해 받음 → 여기 온 줄은 헤더 형식 오류
+            link.urc_dropped++;
+            printf("[UART] %s 헤더 형식 오류 - %u 바이트 줄 버림\n", entry.prefix, (unsigned)(to - from));
+            return;
+        }
+
+        // 콜백 URC: 줄 끝 "\r\n"을 뺀 연속 복사본 전달
+        uint32_t len = 0;
+        for (uint32_t pos = from; pos != to && len < UART_URC_LINE_MAX - 1; pos++) {
+            char ch = link.rx_ring.at(pos);
+            if (ch == '\r' || ch == '\n') {
+                break;
+            }
+            link.urc_line[len++] = ch;
+        }
+        link.urc_line[len] = '\0';
+        entry.handler(link.urc_line, len, entry.user);
+        return;
+    }
+
+    resp_append(link, from, to);
+}
+
+// ===== +MQTTSUBRECV 프레이머 =====
+// URC 큐 프레임: [헤더 8][토픽 + NUL][페이로드 + NUL]을 8바이트 단위로 정렬해 저장
+// 프레임은 링 끝에서 나뉘지 않음 (남은 공간이 모자라면 패딩 프레임으로 링 처음까지 건너뜀)
+// → 토픽/페이로드를 연속 포인터 하나로 넘길 수 있음
+#define URC_FRAME_ALIGN 8
+#define URC_FRAME_PAD 0xFFFF     // topic_len 자리에 기록 = 링 끝까지 건너뜀
+
+typedef struct {
+    uint16_t topic_len;
+    uint16_t reserved;
+    uint32_t payload_len;
+} UrcFrameHeader;
+
+static_assert(sizeof(UrcFrameHeader) == URC_FRAME_ALIGN, "프레임 헤더는 정렬 단위 크기");
+static_assert(UartUrcRing::CAPACITY % URC_FRAME_ALIGN == 0, "URC 큐 크기는 정렬 단위의 배수");
+
+static inline uint32_t frame_size(uint32_t topic_len, uint32_t payload_len) {
+    uint32_t len = sizeof(UrcFrameHeader) + topic_len + 1 + payload_len + 1;
+    return (len + URC_FRAME_ALIGN - 1) & ~(uint32_t)(URC_FRAME_ALIGN - 1);
+}
+
+static void urc_fill(UartLink& link, uint32_t len) {
+    while (len--) {
+        link.urc_ring.push('\0');
+    }
+}
+
+// 10진수 필드 해석 (pos는 다음 위치로 이동)
+// 반환: 1 = 구분자 ch까지 완료, 0 = 데이터 더 필요, -1 = 형식 오류
+static int frame_parse_uint(UartLink& link, uint32_t* pos, uint32_t head, char end_ch, uint32_t* value) {
+    uint32_t v = 0;
+    int digits = 0;
+    while (*pos != head) {
+        char ch = link.rx_ring.at(*pos);
+        if (ch == end_ch) {
+            if (digits == 0) {
+                return -1;
+            }
+            (*pos)++;
+            *value = v;
+            return 1;
+        }
+        // 비정상적으로 긴 숫자 문자열 방지 (최대 9자리 - 오버플로우 없음)
+        if (ch < '0' || ch > '9' || ++digits > 9) {
+            return -1;
+        }
+        v = v * 10 + (uint32_t)(ch - '0');
+        (*pos)++;
+    }
+    return 0;
+}
+
+// 페이로드 수신 완료: NUL + 정렬 바이트로 프레임 마무리 (이 시점부터 읽기 가능)
+static void frame_finish(UartLink& link) {
+    const UartStreamHandler* stream = link.frame_stream;
+    link.frame_active = false;
+    link.frame_stream = NULL;
+    link.demux_scan = link.rx_ring.tail();
+
+    if (stream) {
+        // 수신 도중 RX 링 손실이 있었으면 불완전
+        if (stream->on_end) {
+            stream->on_end(link.rx_dropped == link.frame_rx_dropped, stream->user);
+        }
+    } else if (!link.frame_drop) {
+        urc_fill(link, link.frame_pad);
+    }
+}
+
+// 토픽에 등록된 스트리밍 구독 찾기
+static const UartStreamHandler* stream_find(UartLink& link, const char* topic) {
+    for (int i = 0; i < link.stream_count; i++) {
+        if (strcmp(link.stream_table[i].topic, topic) == 0) {
+            return &link.stream_table[i].handler;
+        }
+    }
+    return NULL;
+}
+
+static void frame_start(UartLink& link, uint32_t topic_len, uint32_t payload_len);
+
+// 줄 시작 tail에서 큐잉 URC 헤더 "<prefix>:<id>,\"<topic>\",<len>," 해석 후 프레임 시작
+// 반환: 1 = 시작함, 0 = 헤더가 아직 덜 옴, -1 = 큐잉 URC 아님 (또는 형식 오류 → 줄 단위 처리)
+static int frame_begin(UartLink& link, uint32_t tail, uint32_t head) {
+    const UartUrcEntry* entry = NULL;
+    for (int i = 0; i < link.urc_count; i++) {
+        const UartUrcEntry& e = link.urc_table[i];
+        if (!e.handler && line_has_prefix(link, tail, head, e.prefix, e.prefix_len)) {
+            entry = &e;
+            break;
+        }
+    }
+    if (!entry) {
+        return -1;
+    }
+
+    uint32_t pos = tail + entry->prefix_len;
+    if (pos == head) {
+        return 0;
+    }
+    if (link.rx_ring.at(pos++) != ':') {
+        return -1;
+    }
+
+    // 링크 ID
+    uint32_t link_id;
+    int r = frame_parse_uint(link, &pos, head, ',', &link_id);
+    if (r <= 0) {
+        return r;
+    }
+
+    // 토픽: "..." 다음에 ','
+    if (pos == head) {
+        return 0;
+    }
+    if (link.rx_ring.at(pos++) != '"') {
+        return -1;
+    }
+    uint32_t topic_from = pos;
+    while (true) {
+        if (pos == head) {
+            return 0;
+        }
+        char ch = link.rx_ring.at(pos);
+        if (ch == '"') {
+            break;
+        }
+        if (ch == '\n' || pos - topic_from >= UART_MQTT_TOPIC_MAX) {
+            return -1;
+        }
+        pos++;
+    }
+    uint32_t topic_len = pos - topic_from;
+    pos++;
+    if (pos == head) {
+        return 0;
+    }
+    if (link.rx_ring.at(pos++) != ',') {
+        return -1;
+    }
+
+    // 페이로드 길이 (이후 바이트는 개행과 무관하게 이 길이만큼 페이로드)
+    uint32_t payload_len;
+    r = frame_parse_uint(link, &pos, head, ',', &payload_len);
+    if (r <= 0) {
+        return r;
+    }
+
+    // 토픽 연속 복사본 (스트림 조회/on_begin 전달/URC 큐 기록용)
+    for (uint32_t i = 0; i < topic_len; i++) {
+        link.frame_topic[i] = link.rx_ring.at(topic_from + i);
+    }
+    link.frame_topic[topic_len] = '\0';
+
+    link.rx_ring.consume_to(pos);
+    frame_start(link, topic_len, payload_len);
+    return 1;
+}
+
+// frame_topic에 토픽이 준비된 상태에서 프레임 시작 (스트림 전달 또는 URC 큐 자리 예약)
+static void frame_start(UartLink& link, uint32_t topic_len, uint32_t payload_len) {
+    link.frame_active = true;
+    link.frame_remaining = payload_len;
+    link.frame_rx_dropped = link.rx_dropped;
+
+    // 스트리밍 구독 토픽: URC 큐를 거치지 않고 도착하는 대로 전달 (크기 제한 없음)
+    link.frame_stream = stream_find(link, link.frame_topic);
+    if (link.frame_stream) {
+        link.frame_drop = false;
+        if (link.frame_stream->on_begin) {
+            link.frame_stream->on_begin(link.frame_topic, payload_len, link.frame_stream->user);
+        }
+        if (payload_len == 0) {
+            frame_finish(link);
+        }
+        return;
+    }
+
+    // URC 큐에 프레임 전체 자리 예약 (랩 경계에 걸리면 패딩 프레임으로 건너뜀)
+    uint32_t size = frame_size(topic_len, payload_len);
+    uint32_t to_end = UartUrcRing::CAPACITY - (link.urc_ring.head() & UartUrcRing::MASK);
+    uint32_t need = size + (size > to_end ? to_end : 0);
+    uint32_t space = UartUrcRing::CAPACITY - link.urc_ring.size();
+
+    link.frame_drop = (size > UartUrcRing::CAPACITY || need > space);
+    if (link.frame_drop) {
+        link.urc_dropped++;
+        printf("[UART] URC 큐 공간 부족 - %u 바이트 메시지 버림\n", (unsigned)payload_len);
+    } else {
+        if (size > to_end) {
+            UrcFrameHeader pad = { URC_FRAME_PAD, 0, 0 };
+            link.urc_ring.write((const char*)&pad, sizeof(pad));
+            urc_fill(link, to_end - sizeof(pad));
+        }
+        UrcFrameHeader hdr = { (uint16_t)topic_len, 0, payload_len };
+        link.urc_ring.write((const char*)&hdr, sizeof(hdr));
+        link.urc_ring.write(link.frame_topic, topic_len + 1);
+    }
+
+    link.frame_pad = size - sizeof(UrcFrameHeader) - topic_len - 1 - payload_len;
+    if (payload_len == 0) {
+        frame_finish(link);
+    }
+}
+
+// 페이로드 구간을 스트림(복사 없이 on_chunk) 또는 URC 큐로 전달
+static void frame_put(UartLink& link, const UartSpan* spans, int count, uint32_t len) {
+    const UartStreamHandler* stream = link.frame_stream;
+    for (int i = 0; i < count; i++) {
+        if (spans[i].len == 0) {
+            continue;
+        }
+        if (stream) {
+            if (stream->on_chunk) {
+                stream->on_chunk(spans[i], stream->user);
+            }
+        } else if (!link.frame_drop) {
+            link.urc_ring.write(spans[i].data, spans[i].len);
+        }
+    }
+    link.frame_remaining -= len;
+}
+
+// 도착한 페이로드 바이트를 URC 큐로 이동 (랩 경계는 최대 2구간 복사)
+// 스트리밍 구독이면 복사 없이 RX 링 구간을 그대로 on_chunk로 전달
+static void frame_feed(UartLink& link) {
+    UartSpan spans[2];
+    uint32_t n = link.rx_ring.peek(spans, link.frame_remaining);
+    frame_put(link, spans, 2, n);
+    link.rx_ring.consume(n);
+    if (link.frame_remaining == 0) {
+        frame_finish(link);
+    }
+}
+
+bool uart_mqtt_frame_begin(UartLink& link, const char* topic, uint32_t topic_len, uint32_t payload_len) {
+    // NULL 포인터 및 길이 검증
+    if (!topic || topic_len > UART_MQTT_TOPIC_MAX) {
+        printf("[UART] 유효하지 않은 프레임 토픽\n");
+        return false;
+    }
+    if (link.frame_active) {
+        printf("[UART] 이전 프레임 수신 중\n");
+        return false;
+    }
+
+    memcpy(link.frame_topic, topic, topic_len);
+    link.frame_topic[topic_len] = '\0';
+    link.frame_rx_dropped = link.rx_dropped;
+    frame_start(link, topic_len, payload_len);
+    return true;
+}
+
+uint32_t uart_mqtt_frame_data(UartLink& link, const char* data, uint32_t len) {
+    if (!link.frame_active || !data) {
+        return 0;
+    }
+    UartSpan span;
+    span.data = data;
+    span.len = (len < link.frame_remaining) ? len : link.frame_remaining;
+    frame_put(link, &span, 1, span.len);
+    if (link.frame_remaining == 0) {
+        frame_finish(link);
+    }
+    return span.len;
+}
+
+void uart_set_passthrough(UartLink& link, UartPassthroughHandler handler, void* user) {
+    // 수신 중이던 프레임은 남은 길이를 0으로 채워 마무리 (스트림은 불완전 종료 알림)
+    if (link.frame_active) {
+        printf("[UART] 수신 중 프레임 중단: %s\n", link.frame_topic);
+        if (link.frame_stream) {
+            if (link.frame_stream->on_end) {
+                link.frame_stream->on_end(false, link.frame_stream->user);
+            }
+            link.frame_stream = NULL;
+            link.frame_drop = true;     // frame_finish가 다시 알리거나 큐에 쓰지 않도록
+        } else if (!link.frame_drop) {
+            urc_fill(link, link.frame_remaining);
+        }
+        link.frame_remaining = 0;
+        frame_finish(link);
+    }
+
+    link.passthrough = handler;
+    link.passthrough_user = user;
+    link.demux_scan = link.rx_ring.tail();
+}
+
+bool uart_register_stream(UartLink& link, const char* topic, const UartStreamHandler* handler) {
+    // NULL 포인터 및 길이 검증
+    if (!topic || strlen(topic) == 0 || strlen(topic) > UART_MQTT_TOPIC_MAX) {
+        printf("[UART] 유효하지 않은 스트림 토픽\n");
+        return false;
+    }
+
+    int slot = link.stream_count;
+    for (int i = 0; i < link.stream_count; i++) {
+        if (strcmp(link.stream_table[i].topic, topic) == 0) {
+            slot = i;
+            break;
+        }
+    }
+
+    // 해제: 마지막 항목을 빈 자리로 옮김 (수신 중인 스트림은 프레임 끝까지 유지)
+    if (!handler) {
+        if (slot < link.stream_count) {
+            if (link.frame_stream == &link.stream_table[slot].handler) {
+                printf("[UART] 수신 중인 스트림은 해제할 수 없음: %s\n", topic);
+                return false;
+            }
+            link.stream_table[slot] = link.stream_table[--link.stream_count];
+            if (link.frame_stream == &link.stream_table[link.stream_count].handler) {
+                link.frame_stream = &link.stream_table[slot].handler;  // 옮겨진 항목이 수신 중
+            }
+        }
+        return true;
+    }
+
+    if (slot >= UART_STREAM_MAX_HANDLERS) {
+        printf("[UART] 스트림 등록 한도 초과: %s\n", topic);
+        return false;
+    }
+    link.stream_table[slot].topic = topic;
+    link.stream_table[slot].handler = *handler;
+    if (slot == link.stream_count) {
+        link.stream_count++;
+    }
+    return true;
+}
+
+bool uart_register_urc(UartLink& link, const char* prefix, UartUrcHandler handler, void* user) {
+    // NULL 포인터 및 길이 검증
+    if (!prefix) {
+        printf("[UART] NULL URC prefix\n");
+        return false;
+    }
+    size_t len = strlen(prefix);
+    if (len == 0 || len > UART_MATCH_MAX_TOKEN_LEN) {
+        printf("[UART] 유효하지 않은 URC prefix 길이: %u\n", (unsigned)len);
+        return false;
+    }
+
+    // 같은 prefix는 교체 (재초기화/재연결 시 중복 등록 방지)
+    int slot = link.urc_count;
+    for (int i = 0; i < link.urc_count; i++) {
+        if (strcmp(link.urc_table[i].prefix, prefix) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot >= UART_URC_MAX_HANDLERS) {
+        printf("[UART] URC 등록 한도 초과: %s\n", prefix);
+        return false;
+    }
+
+    UartUrcEntry& entry = link.urc_table[slot];
+    entry.prefix = prefix;
+    entry.prefix_len = (uint8_t)len;
+    entry.handler = handler;
+    entry.user = user;
+    if (slot == link.urc_count) {
+        link.urc_count++;
+    }
+    return true;
+}
+
+static void tx_deliver_done(UartLink& link);
+
+void uart_link_poll(UartLink& link) {
+    tx_deliver_done(link);
+    rx_sync(link);
+    uint32_t head = link.rx_ring.head();
+
+    // 투명 전송: 줄 분배 없이 도착한 바이트 전체를 핸들러로 (랩 경계는 최대 2구간)
+    if (link.passthrough) {
+        UartSpan spans[2];
+        uint32_t n = link.rx_ring.peek(spans);
+        for (int i = 0; i < 2 && link.passthrough; i++) {
+            if (spans[i].len > 0) {
+                link.passthrough(spans[i], link.passthrough_user);
+            }
+        }
+        link.rx_ring.consume(n);
+        link.demux_scan = link.rx_ring.tail();
+        return;
+    }
+
+    while (true) {
+        uint32_t tail = link.rx_ring.tail();
+        if (tail == head) {
+            link.demux_scan = tail;
+            return;
+        }
+
+        // 길이 기반 프레임 페이로드 수신 중: 줄 구분 없이 남은 길이만큼 이동
+        if (link.frame_active) {
+            frame_feed(link);
+            if (link.frame_active) {
+                return;
+            }
+            continue;
+        }
+
+        // 손실로 tail이 검사 위치를 앞질렀으면 처음부터 다시
+        if (link.demux_scan - tail > head - tail) {
+            link.demux_scan = tail;
+        }
+
+        // 줄 시작이 큐잉 URC 헤더면 길이 기반 프레임으로 받음
+        int framed = frame_begin(link, tail, head);
+        if (framed == 0) {
+            // 헤더가 링을 다 채울 만큼 길 수는 없음 (UART_MQTT_TOPIC_MAX 제한)
+            return;
+        }
+        if (framed > 0) {
+            continue;
+        }
+
+        // 발행 프롬프트 '>'는 개행 없이 오므로 줄 시작에서 바로 응답으로 전달
+        if (link.demux_scan == tail && link.rx_ring.at(tail) == '>') {
+            resp_append(link, tail, tail + 1);
+            link.rx_ring.consume(1);
+            link.demux_scan = tail + 1;
+            continue;
+        }
+
+        uint32_t pos = link.demux_scan;
+        while (pos != head && link.rx_ring.at(pos) != '\n') {
+            pos++;
+        }
+
+        if (pos == head) {
+            // 미완성 줄: 링이 가득 찼으면 더 기다릴 수 없으므로 응답으로 넘김
+            if (head - tail >= UartRxRing::CAPACITY) {
+                resp_append(link, tail, head);
+                link.rx_ring.consume_to(head);
+                pos = head;
+            }
+            link.demux_scan = pos;
+            return;
+        }
+
+        demux_line(link, tail, pos + 1);
+        link.rx_ring.consume_to(pos + 1);
+        link.demux_scan = pos + 1;
+    }
+}
+
+// ===== DMA TX 큐 =====
+// 큐의 다음 세그먼트 전송 시작 (ISR 또는 DMA가 멈춰 있을 때 메인 루프에서 호출)
+static void tx_start_next(UartLink& link) {
+    if (link.tx_slot_tail == link.tx_slot_head) {
+        link.tx_active = false;
+        return;
+    }
+    const UartTxSlot& slot = link.tx_slots[link.tx_slot_tail % UART_TX_QUEUE_LEN];
+    link.tx_active = true;
+    dma_channel_transfer_from_buffer_now(link.tx_dma_chan, slot.data, slot.len);
+}
+
+// DMA 인터럽트: 세그먼트 전송 완료 → 다음 세그먼트 시작, 콜백은 기록만 (uart_link_poll에서 호출)
+static void link_tx_dma_irq(UartLink& link) {
+    if (link.tx_dma_chan < 0 || !dma_channel_get_irq0_status(link.tx_dma_chan)) {
+        return;
+    }
+    dma_channel_acknowledge_irq0(link.tx_dma_chan);
+
+    UartTxSlot slot = link.tx_slots[link.tx_slot_tail % UART_TX_QUEUE_LEN];
+    link.tx_staging_tail += slot.staging_release;
+    link.tx_bytes += slot.len;
+    link.tx_slot_tail++;
+    tx_start_next(link);
+
+    // 제출 시 자리를 예약했으므로 tx_done은 넘치지 않음
+    if (slot.done) {
+        UartTxDone& entry = link.tx_done[link.tx_done_head % UART_TX_QUEUE_LEN];
+        entry.done = slot.done;
+        entry.user = slot.user;
+        link.tx_done_head++;
+    }
+}
+
+// 완료된 요청의 콜백 호출 (메인 루프, uart_link_poll)
+// 제출 도중이 아니므로 콜백이 다시 제출해도 다른 요청의 세그먼트와 섞이지 않음
+static void tx_deliver_done(UartLink& link) {
+    while (link.tx_done_tail != link.tx_done_head) {
+        UartTxDone entry = link.tx_done[link.tx_done_tail % UART_TX_QUEUE_LEN];
+        link.tx_done_tail++;
+        link.tx_done_reserved--;
+        entry.done(entry.user);
+    }
+}
+
+static void tx_dma_start(UartLink& link) {
+    if (link.tx_dma_chan < 0) {
+        link.tx_dma_chan = dma_claim_unused_channel(true);
+    } else {
+        dma_channel_abort(link.tx_dma_chan);  // 재초기화 - 대기 중인 전송은 폐기
+    }
+
+    link.tx_slot_head = 0;
+    link.tx_slot_tail = 0;
+    link.tx_staging_head = 0;
+    link.tx_staging_tail = 0;
+    link.tx_active = false;
+    link.tx_done_head = 0;
+    link.tx_done_tail = 0;
+    link.tx_done_reserved = 0;
+
+    dma_channel_config cfg = dma_channel_get_default_config(link.tx_dma_chan);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_8);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, uart_get_dreq(link.uart, true));
+    dma_channel_configure(link.tx_dma_chan, &cfg, &uart_get_hw(link.uart)->dr, NULL, 0, false);
+
+    dma_channel_set_irq0_enabled(link.tx_dma_chan, true);
+    hw_set_bits(&uart_get_hw(link.uart)->dmacr, UART_UARTDMACR_TXDMAE_BITS);
+}
+
+// 스테이징 len 바이트 할당에 필요한 공간 (링 끝에 안 맞으면 감기 패딩 포함)
+static inline uint32_t tx_staging_need(UartLink& link, uint32_t len) {
+    uint32_t pos = link.tx_staging_head % UART_TX_STAGING_SIZE;
+    return (pos + len > UART_TX_STAGING_SIZE) ? (UART_TX_STAGING_SIZE - pos) + len : len;
+}
+
+// 슬롯 slots개와 스테이징 staging 바이트가 비어 있는지
+static inline bool tx_has_room(UartLink& link, uint32_t slots, uint32_t staging) {
+    return link.tx_slot_head - link.tx_slot_tail + slots <= UART_TX_QUEUE_LEN &&
+           link.tx_staging_head - link.tx_staging_tail + staging <= UART_TX_STAGING_SIZE;
+}
+
+// 제출 가능 여부: 링크 초기화됨 + 인터럽트 밖
+// (ISR에서 공간을 기다리면 같은 우선순위의 DMA 완료 인터럽트가 돌지 못해 영원히 멈춤)
+static bool tx_can_submit(UartLink& link) {
+    if (!link.uart || link.tx_dma_chan < 0) {
+        printf("[UART] UART 초기화되지 않음\n");
+        return false;
+    }
+    if (__get_current_exception() != 0) {
+        printf("[UART] 인터럽트 컨텍스트에서는 TX 제출 불가\n");
+        return false;
+    }
+    return true;
+}
+
+// 스테이징 버퍼에서 연속 len 바이트 할당 (끝에 안 맞으면 앞으로 감기) + 뒤따를 세그먼트 슬롯 확보
+// 공간이 없으면 앞선 전송이 끝날 때까지 대기 (UART_TX_WAIT_TIMEOUT_MS 후 포기 → NULL)
+// 감기 패딩 + len이 버퍼보다 크면 비워져도 채울 수 없으므로 바로 NULL (UART_TX_STAGING_CHUNK 이하는 항상 가능)
+// 성공하면 이어지는 tx_enqueue(segments개)는 대기 없이 들어감
+static uint8_t* tx_staging_alloc(UartLink& link, uint32_t len, int segments, uint32_t* release) {
+    uint32_t need = tx_staging_need(link, len);
+    if (need > UART_TX_STAGING_SIZE) {
+        printf("[UART] 스테이징 할당 불가: %u 바이트 (감기 패딩 %u)\n", (unsigned)len, (unsigned)(need - len));
+        return NULL;
+    }
+
+    absolute_time_t deadline = make_timeout_time_ms(UART_TX_WAIT_TIMEOUT_MS);
+    while (!tx_has_room(link, segments, need)) {
+        if (time_reached(deadline)) {
+            printf("[UART] TX 큐 공간 대기 시간 초과 - %u 바이트 버림\n", (unsigned)len);
+            return NULL;
         }
+        tight_loop_contents();
     }
+
+    uint32_t pos = link.tx_staging_head % UART_TX_STAGING_SIZE;
+    link.tx_staging_head += need;
+    *release = need;
+    return &link.tx_staging[need > len ? 0 : pos];
+}
+
+// 세그먼트들을 큐에 한 번에 넣고 DMA가 멈춰 있으면 시작 (대기하지 않음)
+// 슬롯이 모자라거나 콜백 자리가 없으면 아무것도 넣지 않고 false
+// releases[i]는 해당 세그먼트 완료 시 반환할 스테이징 바이트
+static bool tx_enqueue(UartLink& link, const UartTxSegment* segs, const uint32_t* releases, int count,
+                       UartTxCallback done, void* user) {
+    // 빈 세그먼트를 제외한 마지막 세그먼트와 필요한 슬롯 수 확인
+    int last = -1;
+    uint32_t used = 0;
+    for (int i = 0; i < count; i++) {
+        if (segs[i].len > 0) {
+            last = i;
+            used++;
+        }
+    }
+    if (last < 0) {
+        if (done) {
+            done(user);  // 보낼 데이터 없음 - 즉시 완료
+        }
+        return true;
+    }
+
+    if (!tx_has_room(link, used, 0)) {
+        return false;  // DMA ISR이 슬롯을 반환한 뒤 다시 제출
+    }
+    if (done) {
+        if (link.tx_done_reserved >= UART_TX_QUEUE_LEN) {
+            return false;  // 호출되지 않은 콜백이 가득 참 - uart_link_poll 후 다시 제출
+        }
+        link.tx_done_reserved++;
+    }
+
+    for (int i = 0; i <= last; i++) {
+        if (segs[i].len == 0) {
+            continue;
+        }
+
+        UartTxSlot& slot = link.tx_slots[link.tx_slot_head % UART_TX_QUEUE_LEN];
+        slot.data = (const uint8_t*)segs[i].data;
+        slot.len = segs[i].len;
+        slot.staging_release = releases ? releases[i] : 0;
+        slot.done = (i == last) ? done : NULL;
+        slot.user = (i == last) ? user : NULL;
+
+        // 인터럽트 금지 불필요: ISR은 메인 루프 사이에 통째로 실행되므로
+        // head++ 이후 ISR이 끼어들면 ISR이 새 슬롯을 시작하고 tx_active가 true로 보임
+        link.tx_slot_head++;
+        if (!link.tx_active) {
+            tx_start_next(link);
+        }
+    }
+    return true;
+}
+
+// ===== 인터럽트 트램펄린 =====
+static void on_uart0_irq(void) {
+    if (s_links[0]) {
+        link_uart_irq(*s_links[0]);
+    }
+}
+
+static void on_uart1_irq(void) {
+    if (s_links[1]) {
+        link_uart_irq(*s_links[1]);
+    }
+}
+
+// DMA_IRQ_0은 모든 링크의 RX/TX 채널이 공유 - 각 링크가 자기 채널만 처리
+static void on_uart_dma_irq(void) {
+    for (int i = 0; i < NUM_UARTS; i++) {
+        if (s_links[i]) {
+            link_rx_dma_irq(*s_links[i]);
+            link_tx_dma_irq(*s_links[i]);
+        }
+    }
+}
+
+bool uart_tx_submit(UartLink& link, const UartTxSegment* segs, int count, UartTxCallback done, void* user) {
+    if (!tx_can_submit(link)) {
+        return false;
+    }
+
+    // NULL 포인터 및 개수 검증
+    if (!segs || count <= 0) {
+        printf("[UART] 유효하지 않은 TX 세그먼트\n");
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (segs[i].len > 0 && !segs[i].data) {
+            printf("[UART] NULL TX 세그먼트 데이터\n");
+            return false;
+        }
+    }
+
+    return tx_enqueue(link, segs, NULL, count, done, user);
+}
+
+bool uart_tx_room(UartLink& link, uint32_t len, int segments) {
+    if (!link.uart || link.tx_dma_chan < 0 || segments < 0) {
+        return false;
+    }
+    return tx_has_room(link, (uint32_t)segments, tx_staging_need(link, len));
+}
+
+bool uart_tx_raw_room(UartLink& link, uint32_t len, int sends) {
+    if (!link.uart || link.tx_dma_chan < 0 || len > UART_TX_STAGING_SIZE || sends <= 0) {
+        return false;
+    }
+    return tx_has_room(link, 2 * sends, len);  // 한 번에 링 끝에서 나뉘면 세그먼트 2개
+}
+
+bool uart_tx_busy(UartLink& link) {
+    return link.tx_active || link.tx_slot_tail != link.tx_slot_head;
 }
 
-void uart_init_esp01(uart_inst_t* uart, unsigned int tx_pin, unsigned int rx_pin, unsigned int baudrate) {
+bool uart_tx_wait_idle(UartLink& link, uint32_t timeout_ms) {
+    if (!link.uart) {
+        return true;
+    }
+
+    uint32_t start = to_ms_since_boot(get_absolute_time());
+    while (uart_tx_busy(link)) {
+        if (to_ms_since_boot(get_absolute_time()) - start >= timeout_ms) {
+            return false;
+        }
+        tight_loop_contents();
+    }
+
+    // DMA 완료 후 FIFO에 남은 바이트까지 송신
+    uart_tx_wait_blocking(link.uart);
+    return true;
+}
+
+// 처리량 측정 구간 재시작
+static void tp_reset(UartLink& link) {
+    link.tp_start_us = time_us_64();
+    link.tp_rx_base = link.rx_stats.bytes;
+    link.tp_tx_base = link.tx_bytes;
+}
+
+// RP2040 흐름 제어 핀 배치: 4핀 단위 그룹의 3번째 = CTS, 4번째 = RTS
+// 8핀마다 uart0/uart1이 번갈아 배정 (GPIO 0-3 = uart0, 4-7 = uart1, 8-11 = uart1, 12-15 = uart0 ...)
+static bool flow_pin_valid(unsigned int index, int pin, int slot) {
+    if (pin < 0) {
+        return true;  // 미사용
+    }
+    if (pin > GPIO_MAX || pin % 4 != slot) {
+        return false;
+    }
+    return (unsigned int)(((pin + 4) / 8) % 2) == index;
+}
+
+void uart_init_esp01(UartLink& link, uart_inst_t* uart, unsigned int tx_pin, unsigned int rx_pin, unsigned int baudrate) {
+    static bool dma_irq_installed = false;
+
     // NULL 포인터 검증
     if (!uart) {
         printf("[UART] NULL UART 인스턴스\n");
         return;
     }
-    
+
     // 핀 번호 검증
     if (tx_pin < GPIO_MIN || tx_pin > GPIO_MAX) {
         printf("[UART] 유효하지 않은 TX 핀: %d\n", tx_pin);
         return;
     }
-    
+
     if (rx_pin < GPIO_MIN || rx_pin > GPIO_MAX) {
         printf("[UART] 유효하지 않은 RX 핀: %d\n", rx_pin);
         return;
     }
-    
+
     // baudrate 검증 (일반적인 범위)
-    if (baudrate < 300 || baudrate > 921600) {
+    if (baudrate < UART_BAUD_MIN || baudrate > UART_BAUD_MAX) {
         printf("[UART] 유효하지 않은 baudrate: %d\n", baudrate);
         return;
     }
-    
-    g_uart = uart;
-    
-    uart_init(uart, baudrate);
+
+    // 같은 UART를 다른 링크가 사용 중인지 확인
+    unsigned int index = uart_get_index(uart);
+    if (s_links[index] && s_links[index] != &link) {
+        printf("[UART] uart%u는 이미 다른 링크가 사용 중\n", index);
+        return;
+    }
+
+    // 처음 초기화되는 링크는 DMA 채널 미할당 상태로 표시
+    if (link.uart == NULL) {
+        link.rx_dma_chan = -1;
+        link.tx_dma_chan = -1;
+        link.rx_watch_active = false;
+    }
+    link.uart = uart;
+    link.cts_pin = -1;
+    link.rts_pin = -1;
+
+    link.baudrate = uart_init(uart, baudrate);
     gpio_set_function(tx_pin, GPIO_FUNC_UART);
     gpio_set_function(rx_pin, GPIO_FUNC_UART);
     uart_set_hw_flow(uart, false, false);
     uart_set_format(uart, 8, 1, UART_PARITY_NONE);
     uart_set_fifo_enabled(uart, true);
-    
+
+    tx_dma_start(link);
+
+    link.rx_ring.reset();
+    link.resp_ring.reset();
+    link.urc_ring.reset();
+    link.demux_scan = 0;
+
+    // 수신 중이던 스트림은 불완전 종료 알림
+    if (link.frame_active && link.frame_stream && link.frame_stream->on_end) {
+        link.frame_stream->on_end(false, link.frame_stream->user);
+    }
+    link.frame_active = false;
+    link.frame_stream = NULL;
+    link.passthrough = NULL;
+    link.rx_stats.wakeups = 0;
+    link.rx_stats.bytes = 0;
+    link.tx_bytes = 0;
+    link.rtt_pending = false;
+    uart_reset_link_stats(link);
+
+    // 수신 MQTT 메시지는 명령 응답과 분리해 큐에 보관
+    uart_register_urc(link, "+MQTTSUBRECV", NULL, NULL);
+    tp_reset(link);
+
+    s_links[index] = &link;
+
+    if (!dma_irq_installed) {
+        irq_add_shared_handler(DMA_IRQ_0, on_uart_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+        dma_irq_installed = true;
+    }
+
     // 인터럽트 설정
-    int uart_irq = (uart == uart0) ? UART0_IRQ : UART1_IRQ;
-    irq_set_exclusive_handler(uart_irq, on_uart_rx);
+    int uart_irq = (index == 0) ? UART0_IRQ : UART1_IRQ;
+    irq_set_exclusive_handler(uart_irq, (index == 0) ? on_uart0_irq : on_uart1_irq);
     irq_set_enabled(uart_irq, true);
+#if UART_RX_USE_DMA
+    // 바이트 이동은 DMA가 담당, CPU는 감시 타이머가 새 수신을 볼 때와 링 한 바퀴에서만 깨어남
+    rx_dma_start(link);
+    uart_set_irq_enables(uart, false, false);
+    hw_set_bits(&uart_get_hw(uart)->imsc, UART_ERROR_IRQ_BITS);
+#else
+    link.rx_dma_chan = -1;
     uart_set_irq_enables(uart, true, false);
-    
-    rx_head = 0;
-    rx_tail = 0;
+    hw_set_bits(&uart_get_hw(uart)->imsc, UART_ERROR_IRQ_BITS);
+#endif
 }
 
-void uart_send_at_command(const char* cmd) {
-    if (!g_uart) {
+bool uart_switch_baudrate(UartLink& link, unsigned int baudrate, int cts_pin, int rts_pin) {
+    if (!link.uart) {
         printf("[UART] UART 초기화되지 않음\n");
+        return false;
+    }
+
+    if (baudrate < UART_BAUD_MIN || baudrate > UART_BAUD_MAX) {
+        printf("[UART] 유효하지 않은 baudrate: %u\n", baudrate);
+        return false;
+    }
+
+    unsigned int index = uart_get_index(link.uart);
+    if (!flow_pin_valid(index, cts_pin, 2) || !flow_pin_valid(index, rts_pin, 3)) {
+        printf("[UART] uart%u에 사용할 수 없는 흐름 제어 핀: CTS=%d, RTS=%d\n", index, cts_pin, rts_pin);
+        return false;
+    }
+
+    // 이전 속도로 보낼 바이트(AT 명령 등)가 모두 나간 뒤 전환
+    if (!uart_tx_wait_idle(link, UART_SWITCH_TX_TIMEOUT_MS)) {
+        printf("[UART] 전환 전 TX 완료 대기 타임아웃\n");
+        return false;
+    }
+
+    // 더 이상 쓰지 않는 흐름 제어 핀 해제
+    if (link.cts_pin >= 0 && link.cts_pin != cts_pin) {
+        gpio_set_function(link.cts_pin, GPIO_FUNC_NULL);
+    }
+    if (link.rts_pin >= 0 && link.rts_pin != rts_pin) {
+        gpio_set_function(link.rts_pin, GPIO_FUNC_NULL);
+    }
+    if (cts_pin >= 0) {
+        gpio_set_function(cts_pin, GPIO_FUNC_UART);
+    }
+    if (rts_pin >= 0) {
+        gpio_set_function(rts_pin, GPIO_FUNC_UART);
+    }
+
+    // 분주비와 흐름 제어를 한 번에 적용 (중간 상태에서 ISR이 돌지 않도록)
+    uint32_t mask_start;
+    uint32_t irq_state = irq_mask_begin(&mask_start);
+    uint32_t actual = uart_set_baudrate(link.uart, baudrate);
+    uart_set_hw_flow(link.uart, cts_pin >= 0, rts_pin >= 0);
+    irq_mask_end(link, irq_state, mask_start);
+
+    link.baudrate = actual;
+    link.cts_pin = cts_pin;
+    link.rts_pin = rts_pin;
+
+    // 전환 구간에 깨진 수신 바이트 폐기
+    rx_sync(link);
+    link.rx_ring.clear();
+    tp_reset(link);
+
+    printf("[UART] 보드레이트 전환: %lu (요청 %u), 흐름 제어 %s\n",
+           (unsigned long)actual, baudrate, (cts_pin >= 0 || rts_pin >= 0) ? "사용" : "미사용");
+    return true;
+}
+
+bool uart_rx_pause(UartLink& link, bool pause) {
+    if (!link.uart || link.rts_pin < 0) {
+        return false;
+    }
+    if (pause) {
+        gpio_put(link.rts_pin, 1);      // RTS는 low가 수신 가능
+        gpio_set_dir(link.rts_pin, GPIO_OUT);
+        gpio_set_function(link.rts_pin, GPIO_FUNC_SIO);
+    } else {
+        gpio_set_function(link.rts_pin, GPIO_FUNC_UART);
+    }
+    return true;
+}
+
+void uart_deinit_esp01(UartLink& link) {
+    if (!link.uart) {
+        return;
+    }
+
+    unsigned int index = uart_get_index(link.uart);
+    int uart_irq = (index == 0) ? UART0_IRQ : UART1_IRQ;
+    irq_set_enabled(uart_irq, false);
+    uart_set_irq_enables(link.uart, false, false);
+    hw_clear_bits(&uart_get_hw(link.uart)->imsc, UART_UARTIMSC_RTIM_BITS | UART_ERROR_IRQ_BITS);
+    hw_clear_bits(&uart_get_hw(link.uart)->dmacr, UART_UARTDMACR_RXDMAE_BITS | UART_UARTDMACR_TXDMAE_BITS);
+
+    if (link.rx_watch_active) {
+        cancel_repeating_timer(&link.rx_watch_timer);
+        link.rx_watch_active = false;
+    }
+    if (link.rx_dma_chan >= 0) {
+        dma_channel_set_irq0_enabled(link.rx_dma_chan, false);
+        dma_channel_abort(link.rx_dma_chan);
+        dma_channel_unclaim(link.rx_dma_chan);
+        link.rx_dma_chan = -1;
+    }
+    if (link.tx_dma_chan >= 0) {
+        dma_channel_set_irq0_enabled(link.tx_dma_chan, false);
+        dma_channel_abort(link.tx_dma_chan);
+        dma_channel_unclaim(link.tx_dma_chan);
+        link.tx_dma_chan = -1;
+    }
+
+    s_links[index] = NULL;
+    // UART 자체는 초기화된 상태로 남겨 직접 접근(시리얼 브릿지) 가능
+    // 링크는 미초기화 상태로 → 이후 송수신 호출은 거절, uart_init_esp01로 다시 사용
+    link.uart = NULL;
+}
+
+void uart_send_at_command(UartLink& link, const char* cmd) {
+    if (!tx_can_submit(link)) {
         return;
     }
-    
+
     // NULL 포인터 검증
     if (!cmd) {
         printf("[UART] NULL 명령어\n");
         return;
     }
-    
-    // TX FIFO가 비워질 때까지 대기
-    uart_tx_wait_blocking(g_uart);
-    
-    uart_puts(g_uart, cmd);
-    uart_puts(g_uart, "\r\n");
-    
-    // 전송 완료 대기
-    uart_tx_wait_blocking(g_uart);
+
+    // 명령어는 스테이징 버퍼로 복사, "\r\n"은 상수 세그먼트로 분산-수집 전송
+    uint32_t cmd_len = strlen(cmd);
+    if (cmd_len > UART_TX_STAGING_CHUNK) {
+        printf("[UART] 명령어 길이 초과: %u\n", (unsigned)cmd_len);
+        return;
+    }
+    UartTxSegment segs[2];
+    uint32_t releases[2] = {0, 0};
+    uint8_t* staged = tx_staging_alloc(link, cmd_len, 2, &releases[0]);
+    if (!staged) {
+        return;
+    }
+    memcpy(staged, cmd, cmd_len);
+    segs[0].data = staged;
+    segs[0].len = cmd_len;
+    segs[1].data = CRLF;
+    segs[1].len = 2;
+
+    tx_enqueue(link, segs, releases, 2, NULL, NULL);
+
+    link.rtt_cmd_sent_us = time_us_64();
+    link.rtt_pending = true;
 }
 
-bool uart_wait_response(const char* expected, uint32_t timeout_ms) {
-    // NULL 포인터 검증
-    if (!expected) {
-        printf("[UART] NULL 예상 응답\n");
+// 명령 제출 이후 첫 응답 일치까지의 시간을 히스토그램에 기록
+static void rtt_record(UartLink& link) {
+    if (!link.rtt_pending) {
+        return;
+    }
+    link.rtt_pending = false;
+
+    uint32_t rtt_us = (uint32_t)(time_us_64() - link.rtt_cmd_sent_us);
+    int bucket = UART_RTT_BUCKETS - 1;
+    for (int i = 0; i < UART_RTT_BUCKETS - 1; i++) {
+        if (rtt_us < RTT_BUCKET_LIMIT_MS[i] * 1000) {
+            bucket = i;
+            break;
+        }
+    }
+    UartRttHistogram& hist = link.rtt_hist;
+    hist.count[bucket]++;
+    hist.samples++;
+    hist.total_us += rtt_us;
+    if (rtt_us > hist.max_us) {
+        hist.max_us = rtt_us;
+    }
+}
+
+bool uart_matcher_init(UartLink& link, UartMatcher* matcher, const char* const* tokens, int count) {
+    // NULL 포인터 및 개수 검증
+    if (!matcher || !tokens || count <= 0 || count > UART_MATCH_MAX_TOKENS) {
+        printf("[UART] 유효하지 않은 매처 토큰 목록\n");
         return false;
     }
-    
-    uint32_t start = to_ms_since_boot(get_absolute_time());
-    static char temp_buf[RX_BUFFER_SIZE];
-    
-    while (to_ms_since_boot(get_absolute_time()) - start < timeout_ms) {
-        // Critical Section: 링버퍼 읽기 (ISR의 rx_head 업데이트와 충돌 방지)
-        uint32_t irq_status = save_and_disable_interrupts();
-        
-        // 버퍼에서 데이터 복사
-        int i = 0;
-        uint16_t pos = rx_tail;
-        while (pos != rx_head && i < RX_BUFFER_SIZE - 1) {
-            temp_buf[i++] = rx_buffer[pos];
-            pos = (pos + 1) % RX_BUFFER_SIZE;
-        }
-        temp_buf[i] = '\0';
-        
-        restore_interrupts(irq_status);
-        
-        char* found = strstr(temp_buf, expected);
-        if (found) {
-            // Critical Section: rx_tail 업데이트 보호
-            irq_status = save_and_disable_interrupts();
-            
-            // 찾은 문자열까지 버퍼에서 소비
-            int consume_len = (found - temp_buf) + strlen(expected);
-            for (int j = 0; j < consume_len && rx_tail != rx_head; j++) {
-                rx_tail = (rx_tail + 1) % RX_BUFFER_SIZE;
+
+    for (int t = 0; t < count; t++) {
+        if (!tokens[t]) {
+            printf("[UART] NULL 예상 응답\n");
+            return false;
+        }
+        size_t len = strlen(tokens[t]);
+        if (len == 0 || len > UART_MATCH_MAX_TOKEN_LEN) {
+            printf("[UART] 유효하지 않은 토큰 길이: %u\n", (unsigned)len);
+            return false;
+        }
+
+        matcher->tokens[t] = tokens[t];
+        matcher->token_len[t] = (uint8_t)len;
+        matcher->progress[t] = 0;
+
+        // KMP 실패 함수: 불일치 시 되돌아갈 접두사 길이 (이미 본 바이트를 다시 읽지 않음)
+        uint8_t* fail = matcher->fail[t];
+        fail[0] = 0;
+        uint8_t k = 0;
+        for (size_t i = 1; i < len; i++) {
+            while (k > 0 && tokens[t][i] != tokens[t][k]) {
+                k = fail[k - 1];
             }
-            
-            restore_interrupts(irq_status);
-            return true;
+            if (tokens[t][i] == tokens[t][k]) {
+                k++;
+            }
+            fail[i] = k;
         }
-        sleep_ms(10);
     }
-    return false;
+
+    matcher->link = &link;
+    matcher->count = count;
+    matcher->scan_pos = link.resp_ring.tail();
+    return true;
 }
 
-const char* uart_get_rx_buffer(void) {
-    static char out_buf[RX_BUFFER_SIZE];
-    int i = 0;
-    uint16_t pos = rx_tail;
-    
-    while (pos != rx_head && i < RX_BUFFER_SIZE - 1) {
-        out_buf[i++] = rx_buffer[pos];
-        pos = (pos + 1) % RX_BUFFER_SIZE; // 간단하지만 안전한 원형 버퍼 읽기
+int uart_matcher_poll(UartMatcher* matcher) {
+    if (!matcher || !matcher->link || matcher->count <= 0) {
+        return -1;
+    }
+
+    UartLink& link = *matcher->link;
+    uart_link_poll(link);
+    uint32_t tail = link.resp_ring.tail();
+    uint32_t head = link.resp_ring.head();
+    uint32_t avail = head - tail;
+    uint32_t scanned = matcher->scan_pos - tail;
+
+    // 그 사이 버퍼가 비워졌으면 (uart_clear_rx_buffer) 처음부터 다시 검사
+    if (scanned > avail) {
+        matcher->scan_pos = tail;
+        for (int t = 0; t < matcher->count; t++) {
+            matcher->progress[t] = 0;
+        }
+    }
+
+    // 새로 들어온 바이트만 링 안에서 직접 검사 (복사 없음, 랩 경계 포함)
+    uint32_t pos = matcher->scan_pos;
+    while (pos != head) {
+        char ch = link.resp_ring.at(pos);
+        pos++;
+
+        for (int t = 0; t < matcher->count; t++) {
+            const char* token = matcher->tokens[t];
+            uint8_t k = matcher->progress[t];
+            while (k > 0 && ch != token[k]) {
+                k = matcher->fail[t][k - 1];
+            }
+            if (ch == token[k]) {
+                k++;
+            }
+
+            if (k == matcher->token_len[t]) {
+                // 일치한 토큰 끝까지 소비
+                link.resp_ring.consume_to(pos);
+                matcher->scan_pos = pos;
+                for (int r = 0; r < matcher->count; r++) {
+                    matcher->progress[r] = 0;
+                }
+                rtt_record(link);
+                return t;
+            }
+            matcher->progress[t] = k;
+        }
     }
-    out_buf[i] = '\0';
-    return out_buf;
+
+    matcher->scan_pos = pos;
+    return -1;
 }
 
-void uart_clear_rx_buffer(void) {
-    // Critical Section: ISR과 동시 접근 방지
-    uint32_t irq_status = save_and_disable_interrupts();
-    rx_tail = rx_head;
-    restore_interrupts(irq_status);
+void uart_wait_event(absolute_time_t deadline) {
+#if UART_WAIT_POLL_MS > 0
+    sleep_ms(UART_WAIT_POLL_MS);
+#else
+    // RX ISR(라인 종료) 또는 DMA 감시 타이머(새 수신)의 SEV까지 코어 수면
+    // 이벤트를 놓쳐도 기존 폴링 주기(10 ms) 이상 늦어지지 않도록 상한을 둠
+#if UART_RX_USE_DMA
+    rx_watch_update();
+#endif
+    absolute_time_t wake = make_timeout_time_ms(10);
+    best_effort_wfe_or_timeout(absolute_time_diff_us(wake, deadline) < 0 ? deadline : wake);
+#endif
 }
 
-void uart_send_raw(const char* data, int len) {
-    if (!g_uart) {
-        printf("[UART] UART 초기화되지 않음\n");
-        return;
+int uart_wait_any(UartLink& link, const char* const* tokens, int count, uint32_t timeout_ms) {
+    // 매처는 호출마다 스택에 두므로 링크별로 재진입 가능
+    UartMatcher matcher;
+    if (!uart_matcher_init(link, &matcher, tokens, count)) {
+        return -1;
+    }
+
+    absolute_time_t deadline = make_timeout_time_ms(timeout_ms);
+
+    int hit = -1;
+    link.rx_waiters++;  // 기다리는 동안 DMA 수신 감시 타이머 유지
+    while (true) {
+        hit = uart_matcher_poll(&matcher);
+        if (hit >= 0 || time_reached(deadline)) {
+            break;
+        }
+        uart_wait_event(deadline);
+    }
+    link.rx_waiters--;
+    return hit;
+}
+
+bool uart_wait_response(UartLink& link, const char* expected, uint32_t timeout_ms) {
+    // NULL 포인터 검증
+    if (!expected) {
+        printf("[UART] NULL 예상 응답\n");
+        return false;
+    }
+
+    return uart_wait_any(link, &expected, 1, timeout_ms) == 0;
+}
+
+int uart_get_rx_buffer(UartLink& link, char* buffer, int max_len) {
+    // NULL 포인터 및 길이 검증
+    if (!buffer || max_len <= 0) {
+        return 0;
+    }
+
+    // 읽기 전용 스냅샷 (소비하지 않음)
+    uart_link_poll(link);
+    UartRespRing::Span spans[2];
+    uint32_t len = link.resp_ring.peek(spans, (uint32_t)max_len - 1);
+    memcpy(buffer, spans[0].data, spans[0].len);
+    memcpy(buffer + spans[0].len, spans[1].data, spans[1].len);
+    buffer[len] = '\0';
+    return (int)len;
+}
+
+void uart_clear_rx_buffer(UartLink& link) {
+    // 명령 응답만 비움 - 분배를 먼저 끝내 이미 도착한 URC는 큐/콜백으로 보존
+    uart_link_poll(link);
+    link.resp_ring.clear();
+}
+
+int uart_read_raw(UartLink& link, char* buffer, int max_len) {
+    // NULL 포인터 및 길이 검증
+    if (!buffer || max_len <= 0) {
+        return 0;
     }
-    
+
+    // 줄 분배기를 거치지 않으므로 같은 링크에서 uart_link_poll과 함께 쓰면 안 됨
+    rx_sync(link);
+    UartSpan spans[2];
+    uint32_t len = link.rx_ring.peek(spans, (uint32_t)max_len);
+    memcpy(buffer, spans[0].data, spans[0].len);
+    memcpy(buffer + spans[0].len, spans[1].data, spans[1].len);
+    link.rx_ring.consume(len);
+    return (int)len;
+}
+
+bool uart_send_raw(UartLink& link, const char* data, int len) {
+    if (!tx_can_submit(link)) {
+        return false;
+    }
+
     // NULL 포인터 검증
     if (!data) {
         printf("[UART] NULL 데이터\n");
-        return;
+        return false;
     }
-    
+
     // 음수 길이 검증
     if (len < 0) {
         printf("[UART] 유효하지 않은 길이: %d\n", len);
-        return;
+        return false;
     }
-    
+
     if (len == 0) {
-        return;  // 전송할 데이터 없음
+        return true;  // 전송할 데이터 없음
+    }
+
+    // 전체가 한 번에 들어갈 수 없으면 아무것도 보내지 않음 (일부만 나간 스트림은 상대가 복구할 수 없음)
+    if ((uint32_t)len > UART_TX_STAGING_SIZE) {
+        printf("[UART] 원시 전송 길이 초과: %d > %d\n", len, UART_TX_STAGING_SIZE);
+        return false;
+    }
+
+    // 전체(링 끝에서 나뉘면 세그먼트 2개)가 들어갈 자리가 날 때까지 대기 후 한 번에 복사
+    absolute_time_t deadline = make_timeout_time_ms(UART_TX_WAIT_TIMEOUT_MS);
+    while (!tx_has_room(link, 2, (uint32_t)len)) {
+        if (time_reached(deadline)) {
+            printf("[UART] TX 큐 공간 대기 시간 초과 - %d 바이트 보내지 않음\n", len);
+            return false;
+        }
+        tight_loop_contents();
+    }
+
+    UartTxSegment segs[2];
+    uint32_t releases[2];
+    uint32_t pos = link.tx_staging_head % UART_TX_STAGING_SIZE;
+    uint32_t first = UART_TX_STAGING_SIZE - pos;
+    if (first > (uint32_t)len) {
+        first = (uint32_t)len;
     }
-    
-    // TX FIFO가 비워질 때까지 대기
-    uart_tx_wait_blocking(g_uart);
-    
-    for (int i = 0; i < len; i++) {
-        uart_putc_raw(g_uart, data[i]);
+    memcpy(&link.tx_staging[pos], data, first);
+    memcpy(link.tx_staging, data + first, (uint32_t)len - first);
+    segs[0].data = &link.tx_staging[pos];
+    segs[0].len = first;
+    segs[1].data = link.tx_staging;
+    segs[1].len = (uint32_t)len - first;
+    releases[0] = first;
+    releases[1] = (uint32_t)len - first;
+    link.tx_staging_head += (uint32_t)len;
+
+    // 슬롯을 확인했으므로 실패하지 않음
+    return tx_enqueue(link, segs, releases, 2, NULL, NULL);
+}
+
+// URC 큐 맨 앞의 완성된 프레임 조회 (패딩 프레임은 건너뜀)
+static bool urc_frame_front(UartLink& link, UartMqttFrame* frame) {
+    while (true) {
+        uint32_t tail = link.urc_ring.tail();
+        uint32_t avail = link.urc_ring.head() - tail;
+        if (avail < sizeof(UrcFrameHeader)) {
+            return false;
+        }
+
+        // 프레임은 정렬 단위로 연속 저장되므로 헤더를 바로 읽을 수 있음
+        const volatile char* base = link.urc_ring.storage() + (tail & UartUrcRing::MASK);
+        const volatile UrcFrameHeader* hdr = (const volatile UrcFrameHeader*)base;
+        uint32_t topic_len = hdr->topic_len;
+        uint32_t payload_len = hdr->payload_len;
+        if (topic_len == URC_FRAME_PAD) {
+            link.urc_ring.consume(UartUrcRing::CAPACITY - (tail & UartUrcRing::MASK));
+            continue;
+        }
+
+        // 페이로드가 아직 다 오지 않은 프레임
+        if (avail < frame_size(topic_len, payload_len)) {
+            return false;
+        }
+
+        frame->topic = (const char*)(base + sizeof(UrcFrameHeader));
+        frame->topic_len = topic_len;
+        frame->payload = frame->topic + topic_len + 1;
+        frame->payload_len = payload_len;
+        return true;
     }
-    
-    // 전송 완료 대기
-    uart_tx_wait_blocking(g_uart);
 }
 
-int uart_read_mqtt_message(char* buffer, int max_len) {
+bool uart_peek_mqtt_frame(UartLink& link, UartMqttFrame* frame) {
     // NULL 포인터 검증
-    if (!buffer) {
-        printf("[UART] NULL 버퍼\n");
-        return 0;
+    if (!frame) {
+        printf("[UART] NULL 프레임\n");
+        return false;
     }
-    
-    // 길이 검증
-    if (max_len <= 0) {
-        printf("[UART] 유효하지 않은 버퍼 크기: %d\n", max_len);
-        return 0;
+
+    uart_link_poll(link);
+    return urc_frame_front(link, frame);
+}
+
+void uart_release_mqtt_frame(UartLink& link) {
+    UartMqttFrame frame;
+    if (urc_frame_front(link, &frame)) {
+        link.urc_ring.consume(frame_size(frame.topic_len, frame.payload_len));
     }
-    
-    // Critical Section: 링버퍼 읽기 (ISR의 rx_head 업데이트와 충돌 방지)
-    uint32_t irq_status = save_and_disable_interrupts();
-    
-    // 링 버퍼에서 직접 읽기 (static 버퍼 의존성 제거)
-    char temp_buf[RX_BUFFER_SIZE];
-    int buf_len = 0;
-    uint16_t pos = rx_tail;
-    
-    // 링 버퍼에서 temp_buf로 복사
-    while (pos != rx_head && buf_len < RX_BUFFER_SIZE - 1) {
-        temp_buf[buf_len++] = rx_buffer[pos];
-        pos = (pos + 1) % RX_BUFFER_SIZE;
-    }
-    temp_buf[buf_len] = '\0';
-    
-    restore_interrupts(irq_status);
-    
-    const char* mqtt_start = strstr(temp_buf, "+MQTTSUBRECV");
-    
-    if (mqtt_start) {
-        // 메시지 한 줄만 읽기
-        const char* line_end = strchr(mqtt_start, '\n');
-        int copy_len = line_end ? (line_end - mqtt_start) : strlen(mqtt_start);
-        
-        if (copy_len >= max_len) {
-            copy_len = max_len - 1;
-        }
-        
-        strncpy(buffer, mqtt_start, copy_len);
-        buffer[copy_len] = '\0';
-        
-        // Critical Section: rx_tail 업데이트 보호
-        irq_status = save_and_disable_interrupts();
-        
-        // 읽은 메시지만 제거 (포인터 산술 오류 수정)
-        if (line_end) {
-            // mqtt_start부터 line_end까지의 문자 개수 계산
-            int consumed = (line_end - mqtt_start) + 1;  // '\n' 포함
-            
-            // temp_buf의 시작부터 mqtt_start까지의 거리도 고려
-            int offset_to_mqtt = mqtt_start - temp_buf;
-            int total_consumed = offset_to_mqtt + consumed;
-            
-            // tail을 안전하게 이동
-            for (int i = 0; i < total_consumed && rx_tail != rx_head; i++) {
-                rx_tail = (rx_tail + 1) % RX_BUFFER_SIZE;
-            }
+}
+
+void uart_get_rx_stats(UartLink& link, UartRxStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    // ISR이 두 필드를 함께 갱신하므로 wakeups가 변하지 않을 때까지 다시 읽어 일관된 스냅샷 확보
+    uint32_t wakeups;
+    do {
+        wakeups = link.rx_stats.wakeups;
+        stats->bytes = link.rx_stats.bytes;
+    } while (wakeups != link.rx_stats.wakeups);
+    stats->wakeups = wakeups;
+}
+
+void uart_get_link_stats(UartLink& link, UartLinkStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    rx_sync(link);  // DMA 모드: 덮어쓰기 손실과 점유량을 최신으로 반영
+    UartRxStats rx;
+    uart_get_rx_stats(link, &rx);
+
+    stats->rx_bytes = rx.bytes;
+    stats->rx_dropped = link.rx_dropped;
+    stats->rx_hwm = link.rx_hwm;
+    stats->rx_capacity = UartRxRing::CAPACITY;
+    stats->overrun_errors = link.err_overrun;
+    stats->framing_errors = link.err_framing;
+    stats->break_errors = link.err_break;
+    stats->parity_errors = link.err_parity;
+    stats->urc_dropped = link.urc_dropped;
+    stats->max_isr_us = link.max_isr_us;
+    stats->max_irq_masked_us = link.max_irq_masked_us;
+}
+
+void uart_reset_link_stats(UartLink& link) {
+    link.rx_dropped = 0;
+    link.rx_hwm = 0;
+    link.err_overrun = 0;
+    link.err_framing = 0;
+    link.err_break = 0;
+    link.err_parity = 0;
+    link.urc_dropped = 0;
+    link.max_isr_us = 0;
+    link.max_irq_masked_us = 0;
+}
+
+int uart_format_link_stats(UartLink& link, char* buffer, int max_len) {
+    // NULL 포인터 및 길이 검증
+    if (!buffer || max_len <= 0) {
+        return -1;
+    }
+
+    UartLinkStats st;
+    uart_get_link_stats(link, &st);
+
+    int written = snprintf(buffer, max_len,
+                           "{\"baud\":%lu,\"rx\":%lu,\"drop\":%lu,\"hwm\":%lu,\"cap\":%lu,"
+                           "\"oe\":%lu,\"fe\":%lu,\"be\":%lu,\"pe\":%lu,\"urc_drop\":%lu,\"isr_us\":%lu,\"masked_us\":%lu}",
+                           (unsigned long)link.baudrate, (unsigned long)st.rx_bytes,
+                           (unsigned long)st.rx_dropped, (unsigned long)st.rx_hwm,
+                           (unsigned long)st.rx_capacity, (unsigned long)st.overrun_errors,
+                           (unsigned long)st.framing_errors, (unsigned long)st.break_errors,
+                           (unsigned long)st.parity_errors, (unsigned long)st.urc_dropped,
+                           (unsigned long)st.max_isr_us,
+                           (unsigned long)st.max_irq_masked_us);
+    if (written < 0 || written >= max_len) {
+        printf("[UART] 통계 JSON 버퍼 부족\n");
+        return -1;
+    }
+    return written;
+}
+
+void uart_get_throughput(UartLink& link, UartThroughput* tp) {
+    if (!tp) {
+        return;
+    }
+
+    UartRxStats rx;
+    uart_get_rx_stats(link, &rx);
+    uint64_t elapsed_us = time_us_64() - link.tp_start_us;
+
+    tp->baudrate = link.baudrate;
+    tp->flow_control = link.cts_pin >= 0 || link.rts_pin >= 0;
+    tp->elapsed_ms = (uint32_t)(elapsed_us / 1000);
+    tp->rx_bytes = rx.bytes - link.tp_rx_base;
+    tp->tx_bytes = link.tx_bytes - link.tp_tx_base;
+    tp->rx_bytes_per_sec = elapsed_us ? (uint32_t)((uint64_t)tp->rx_bytes * 1000000 / elapsed_us) : 0;
+    tp->tx_bytes_per_sec = elapsed_us ? (uint32_t)((uint64_t)tp->tx_bytes * 1000000 / elapsed_us) : 0;
+}
+
+void uart_get_rtt_histogram(UartLink& link, UartRttHistogram* hist) {
+    if (!hist) {
+        return;
+    }
+    *hist = link.rtt_hist;
+}
+
+void uart_reset_rtt_histogram(UartLink& link) {
+    memset(&link.rtt_hist, 0, sizeof(link.rtt_hist));
+}
+
+void uart_print_rtt_histogram(UartLink& link) {
+    const UartRttHistogram& hist = link.rtt_hist;
+    printf("[UART] AT 왕복 시간 히스토그램 (샘플 %lu, 평균 %lu us, 최대 %lu us)\n",
+           (unsigned long)hist.samples,
+           (unsigned long)(hist.samples ? hist.total_us / hist.samples : 0),
+           (unsigned long)hist.max_us);
+
+    uint32_t lower = 0;
+    for (int i = 0; i < UART_RTT_BUCKETS; i++) {
+        if (i < UART_RTT_BUCKETS - 1) {
+            printf("  %5lu ~ %5lu ms: %lu\n", (unsigned long)lower,
+                   (unsigned long)RTT_BUCKET_LIMIT_MS[i], (unsigned long)hist.count[i]);
+            lower = RTT_BUCKET_LIMIT_MS[i];
         } else {
-            // 개행이 없으면 MQTTSUBRECV부터 끝까지 소비
-            int offset_to_mqtt = mqtt_start - temp_buf;
-            for (int i = 0; i < offset_to_mqtt + copy_len && rx_tail != rx_head; i++) {
-                rx_tail = (rx_tail + 1) % RX_BUFFER_SIZE;
-            }
+            printf("  %5lu ms 이상  : %lu\n", (unsigned long)lower, (unsigned long)hist.count[i]);
         }
-        
-        restore_interrupts(irq_status);
-        
-        return copy_len;
     }
-    return 0;
 }
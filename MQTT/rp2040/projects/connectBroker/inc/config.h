@@ -5,9 +5,14 @@
 #include "esp01.h"
 #include "hardware/uart.h"
 
+// 부팅 시 USB 시리얼 연결 대기 (ms, 부팅 로그를 볼 때만 5000 등으로 설정)
+// 0이면 바로 모듈 부팅 → 현장 보드의 전원 복구 후 첫 발행이 그만큼 빨라짐
+#define STDIO_USB_WAIT_MS 0
+
 // WiFi 설정
 #define WIFI_SSID     "FarmMain5G"
 #define WIFI_PASSWORD "wweerrtt"
+#define WIFI_FAST_REJOIN 1   // 재접속 시 마지막 BSSID/IP 사용 (스캔/DHCP 생략, 실패 시 전체 접속)
 
 // ESP-01 하드웨어 설정
 #define ESP01_UART          uart1
@@ -16,6 +21,13 @@
 #define ESP01_UART_BAUDRATE 115200
 #define ESP01_RST_PIN       3
 
+// ESP-01 고속 UART (부팅 후 AT+UART_CUR로 전환, 실패 시 ESP01_UART_BAUDRATE 유지)
+// RX DMA 링 모드는 FIFO를 항상 비우므로 RTS가 내려가지 않음 → 흐름 제어는 링버퍼 넘침을 막지 못함
+// (RTS는 uart_rx_pause로 직접 멈출 때만 동작), 921600 등은 링버퍼를 충분히 키운 뒤에만 사용
+#define ESP01_UART_TARGET_BAUDRATE 0        // 0 = 전환 안 함 (115200 유지)
+#define ESP01_UART_CTS_PIN  -1              // RTS/CTS 배선 시 핀 번호 (-1 = 미연결)
+#define ESP01_UART_RTS_PIN  -1
+
 // MQTT 브로커 설정
 #define MQTT_BROKER     "192.168.0.24"
 #define MQTT_PORT       1883
@@ -27,6 +39,21 @@
 #define TOPIC_STATUS    "test/rp2040/status"
 #define TOPIC_SENSOR    "test/rp2040/sensor"
 #define TOPIC_CONTROL   "test/rp2040/control"
+#define TOPIC_CONTROL_STATE "test/rp2040/control/state" // 제어 적용 결과 (QoS 1, 재연결 후에도 전달 보장)
+#define TOPIC_BLOB      "test/rp2040/blob"         // 대용량 페이로드 스트리밍 수신 (URC 큐 크기 제한 없음)
+#define TOPIC_UART_STATS "test/rp2040/uart_stats"   // RX 손실/오류/최대 점유 (버퍼 크기 결정용)
+#define TOPIC_NET_STATS "test/rp2040/net_stats"     // 복구 감독자 상태/끊김 횟수/복구 시간
+
+// 발행 지연 벤치마크 (1 = 부팅 시 ESP-01 대신 AT 에뮬레이터를 상대로 측정 후 정지)
+// 배선: GPIO4(uart1 TX) → GPIO1(uart0 RX), GPIO0(uart0 TX) → GPIO5(uart1 RX)
+#define PUBLISH_BENCHMARK       0
+#define BENCH_UART              uart0
+#define BENCH_UART_TX_PIN       0
+#define BENCH_UART_RX_PIN       1
+#define BENCH_BAUDRATE          921600
+#define BENCH_PUBLISH_COUNT     1000
+#define BENCH_PAYLOAD_LEN       64
+#define BENCH_ACK_DELAY_US      0       // 에뮬레이터 응답 지연 (모듈 처리 시간 모사)
 
 // LWT (Last Will Testament)
 #define LWT_TOPIC       TOPIC_STATUS
@@ -3,16 +3,123 @@
 #include "pico/stdlib.h"
 #include "hardware/uart.h"
 #include "uart_comm.h"
+#include "at_engine.h"
 #include "esp01.h"
 #include "mqtt_client.h"
+#include "mqtt_router.h"
+#include "net_supervisor.h"
 #include "serial_bridge.h"
+#include "at_emulator.h"
 #include "config.h"
 
+// ESP-01 UART 링크 (링버퍼 정렬 및 크기 때문에 스택이 아닌 전역에 둠)
+static UartLink esp_link;
+
+// ESP-01 AT 명령 엔진 (메인 루프에서 at_engine_poll로 진행)
+static AtEngine esp_at;
+
+// 연결 끊김 중 발행 보관 로그 (플래시 끝 MQTT_STORE_SECTORS 섹터)
+static MqttStore pub_store;
+
+// 네트워크 복구 감독자 (끊김 시 MQTT → WiFi → 모듈 리셋 순, 지수 백오프 + 보드별 지터)
+static NetSupervisor net_sup;
+
+// 재연결 후 재구독 결과 (완료 콜백이 갱신)
+static int net_sub_pending = 0;
+static int net_sub_failures = 0;
+
+static void on_topic_subscribed(int result, void* user) {
+    net_sub_pending--;
+    if (result != 0) {
+        printf("[오류] 토픽 재구독 실패: %s\n", (const char*)user);
+        net_sub_failures++;
+    }
+}
+
+// 대용량 페이로드 스트리밍 수신 상태 (RAM은 크기와 무관하게 고정)
+typedef struct {
+    uint32_t total;       // 헤더의 선언 길이
+    uint32_t received;    // 지금까지 받은 바이트
+    uint32_t crc;         // CRC-32 진행 값 (청크마다 이어서 계산)
+    uint32_t start_ms;
+} BlobRx;
+
+static BlobRx blob_rx;
+
+// CRC-32 (IEEE 802.3, zlib.crc32와 같은 값) - 4비트 테이블로 청크 단위 증분 계산
+static const uint32_t CRC32_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t crc32_update(uint32_t crc, const char* data, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= (uint8_t)data[i];
+        crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+        crc = (crc >> 4) ^ CRC32_NIBBLE[crc & 0x0F];
+    }
+    return crc;
+}
+
+static void on_blob_begin(const char* topic, uint32_t total_len, void* user) {
+    BlobRx& rx = *(BlobRx*)user;
+    rx.total = total_len;
+    rx.received = 0;
+    rx.crc = 0xFFFFFFFF;
+    rx.start_ms = to_ms_since_boot(get_absolute_time());
+    printf("[수신] %s: %lu 바이트 스트리밍 시작\n", topic, (unsigned long)total_len);
+}
+
+// 청크는 콜백 안에서만 유효 → 버퍼에 모으지 않고 도착하는 대로 CRC에 반영
+static void on_blob_chunk(UartSpan chunk, void* user) {
+    BlobRx& rx = *(BlobRx*)user;
+    rx.crc = crc32_update(rx.crc, chunk.data, chunk.len);
+    rx.received += chunk.len;
+}
+
+static void on_blob_end(bool complete, void* user) {
+    BlobRx& rx = *(BlobRx*)user;
+    uint32_t elapsed = to_ms_since_boot(get_absolute_time()) - rx.start_ms;
+    printf("[수신] 스트리밍 %s: %lu/%lu 바이트, CRC-32 0x%08lx, %lu ms\n",
+           complete ? "완료" : "불완전(손실)", (unsigned long)rx.received, (unsigned long)rx.total,
+           (unsigned long)(rx.crc ^ 0xFFFFFFFF), (unsigned long)elapsed);
+}
+
+static const UartStreamHandler blob_stream = { on_blob_begin, on_blob_chunk, on_blob_end, &blob_rx };
+
+// 수신 토픽 → 핸들러 (토픽별로 나눠 처리, 페이로드는 해당 토픽 안에서만 해석)
+static MqttRouter msg_router;
+
+static void on_control_state_delivered(bool delivered, void* user) {
+    printf("[제어] 상태 보고 %s: %s\n", delivered ? "전달 확인" : "전달 실패", (const char*)user);
+}
+
+static void on_control_message(const char* topic, const char* payload, uint32_t payload_len, void* user) {
+    MqttClient& mqtt = *(MqttClient*)user;
+    const char* state = NULL;
+    
+    // 제어 명령 처리
+    if (strstr(payload, "ON")) {
+        printf("[제어] 장치 ON\n");
+        // TODO: 액츄에이터 제어
+        state = "ON";
+    } else if (strstr(payload, "OFF")) {
+        printf("[제어] 장치 OFF\n");
+        // TODO: 액츄에이터 제어
+        state = "OFF";
+    }
+    
+    // 적용 결과는 QoS 1로 보고 (확인될 때까지 보관, 재연결 후 재전송)
+    if (state && !mqtt_publish_qos1(mqtt, TOPIC_CONTROL_STATE, state, 1, on_control_state_delivered, (void*)state)) {
+        printf("[경고] 제어 상태 보고 실패 (QoS 1 슬롯 가득 참)\n");
+    }
+}
+
 /**
  * @brief MQTT 재연결 후 초기화 작업 수행
  * 
  * MQTT 브로커 재연결 시 필요한 모든 초기화 작업을 수행합니다:
- * - 제어 토픽 재구독
+ * - 제어/스트리밍 토픽 재구독
  * - 상태 토픽에 online 메시지 발행
  * 
  * @param mqtt MQTT 클라이언트 구조체
@@ -29,6 +136,11 @@ bool mqtt_reinitialize_after_reconnect(MqttClient& mqtt) {
     }
     printf("[MQTT] 제어 토픽 재구독 완료: %s\n", TOPIC_CONTROL);
     
+    if (!mqtt_subscribe(mqtt, TOPIC_BLOB, 0)) {
+        printf("[오류] 스트리밍 토픽 재구독 실패: %s\n", TOPIC_BLOB);
+        return false;
+    }
+    
     // 2. 상태 토픽에 online 메시지 발행 (retain)
     if (!mqtt_publish(mqtt, TOPIC_STATUS, "online", 0, 1)) {
         printf("[오류] 상태 메시지 발행 실패: %s\n", TOPIC_STATUS);
@@ -40,31 +152,191 @@ bool mqtt_reinitialize_after_reconnect(MqttClient& mqtt) {
     return true;
 }
 
+/**
+ * @brief 브로커 재연결 후 복원 제출 (감독자 복원 훅, 차단 없음)
+ * 
+ * 제어/스트리밍 토픽을 다시 구독하고 상태 토픽에 online 메시지를 발행합니다 (retain).
+ * 
+ * @param mqtt MQTT 클라이언트
+ * @param attempt 복원 시도 번호 (0 = 새 연결)
+ * @param user 사용 안 함
+ * @return 제출 여부
+ */
+static bool net_restore_submit(MqttClient& mqtt, uint32_t attempt, void* user) {
+    net_sub_pending = 2;
+    net_sub_failures = 0;
+    if (!mqtt_subscribe_async(mqtt, TOPIC_CONTROL, 0, on_topic_subscribed, (void*)TOPIC_CONTROL)) {
+        net_sub_pending = 0;
+        return false;
+    }
+    if (!mqtt_subscribe_async(mqtt, TOPIC_BLOB, 0, on_topic_subscribed, (void*)TOPIC_BLOB)) {
+        net_sub_pending--;
+        net_sub_failures++;
+        return true;  // 확인 단계에서 재시도
+    }
+    mqtt_publish_async(mqtt, TOPIC_STATUS, "online", 0, 1);
+    return true;
+}
+
+/**
+ * @brief 재구독 결과 확인 (감독자 복원 훅)
+ * 
+ * 실패한 구독이 있으면 연결 상태 확인 후 다시 구독합니다 (횟수 제한 없음).
+ */
+static NetRestoreResult net_restore_check(MqttClient& mqtt, uint32_t attempt, void* user) {
+    if (net_sub_pending > 0) {
+        return NET_RESTORE_PENDING;  // 네이티브 전송: SUBACK 대기 중
+    }
+    if (net_sub_failures > 0) {
+        return NET_RESTORE_RETRY;
+    }
+    printf("[MQTT] 재연결 후 초기화 완료\n");
+    return NET_RESTORE_DONE;
+}
+
+static const NetRestoreHooks net_restore = { net_restore_submit, net_restore_check, NULL };
+
+#if PUBLISH_BENCHMARK
+#if MQTT_NATIVE_TRANSPORT
+#error "발행 벤치마크는 AT 에뮬레이터 상대 - MQTT_NATIVE_TRANSPORT와 함께 쓸 수 없음"
+#endif
+// 에뮬레이터 쪽 링크 (esp_link와 교차 연결)
+static UartLink emu_link;
+static AtEmulator emu;
+
+// 발행 count회를 in_flight개씩 겹쳐 진행, 반환: 경과 시간 (us)
+static uint32_t bench_publish(MqttClient& mqtt, const char* payload, uint32_t count, uint32_t in_flight) {
+    uint32_t submitted = 0;
+    uint32_t start_us = time_us_32();
+    mqtt_reset_publish_stats(mqtt);
+    
+    while (mqtt.pub_stats.published + mqtt.pub_stats.failed < count) {
+        while (submitted < count && at_engine_pending(esp_at) < in_flight) {
+            if (!mqtt_publish_async(mqtt, TOPIC_SENSOR, payload, 0, 0)) {
+                break;
+            }
+            submitted++;
+        }
+        at_engine_poll(esp_at);
+        at_emu_poll(emu);
+        if (!mqtt.connected) {
+            printf("[BENCH] 발행 실패로 중단\n");
+            break;
+        }
+    }
+    return time_us_32() - start_us;
+}
+
+static void bench_report(MqttClient& mqtt, const char* name, uint32_t elapsed_us) {
+    MqttPublishLatency lat;
+    mqtt_get_publish_latency(mqtt, &lat);
+    uint32_t rate = elapsed_us ? (uint32_t)((uint64_t)lat.published * 1000000 / elapsed_us) : 0;
+    printf("[BENCH] %s: %lu건 (실패 %lu), %lu 건/s, p50 %lu us, p99 %lu us, max %lu us\n",
+           name, (unsigned long)lat.published, (unsigned long)lat.failed, (unsigned long)rate,
+           (unsigned long)lat.p50_us, (unsigned long)lat.p99_us, (unsigned long)lat.max_us);
+}
+
+/**
+ * @brief 발행 지연 벤치마크 (ESP-01 대신 uart0의 AT 에뮬레이터 사용)
+ * 
+ * uart1(ESP-01 링크)과 uart0(에뮬레이터)을 교차 연결한 상태에서
+ * 실제 발행 경로(명령 생성 → '>' 프롬프트 → 페이로드 → +MQTTPUB:OK)를 측정합니다.
+ * - 단건: 발행 하나씩 완료 후 다음 제출 (순수 발행 지연)
+ * - 연속: AT 큐를 가득 채운 상태 유지 (최대 처리량, 지연은 큐 대기 포함)
+ */
+static void run_publish_benchmark(void) {
+    printf("[BENCH] 발행 벤치마크: %lu baud, 페이로드 %d 바이트, 응답 지연 %d us\n",
+           (unsigned long)BENCH_BAUDRATE, BENCH_PAYLOAD_LEN, BENCH_ACK_DELAY_US);
+    
+    uart_init_esp01(esp_link, ESP01_UART, ESP01_UART_TX_PIN, ESP01_UART_RX_PIN, BENCH_BAUDRATE);
+    uart_init_esp01(emu_link, BENCH_UART, BENCH_UART_TX_PIN, BENCH_UART_RX_PIN, BENCH_BAUDRATE);
+    at_engine_init(esp_at, esp_link);
+    at_emu_init(emu, emu_link, BENCH_ACK_DELAY_US);
+    
+    // 발신 큐/발행 통계 크기 때문에 스택이 아닌 정적 저장소에 둠
+    static MqttClient mqtt = {
+        .link = &esp_link,
+        .broker = MQTT_BROKER,
+        .port = MQTT_PORT,
+        .client_id = MQTT_CLIENT_ID,
+        .username = MQTT_USERNAME,
+        .password = MQTT_PASSWORD,
+        .lwt_topic = LWT_TOPIC,
+        .lwt_message = LWT_MESSAGE,
+        .connected = true,      // 에뮬레이터는 항상 연결 상태
+        .last_activity = 0,
+        .pub_stats = {},
+        .pub_prefix = {},
+        .outbox = {},
+        .store = NULL,
+        .qos1 = {},
+        .native = {}
+    };
+    
+    static char payload[BENCH_PAYLOAD_LEN + 1];
+    memset(payload, 'x', BENCH_PAYLOAD_LEN);
+    payload[BENCH_PAYLOAD_LEN] = '\0';
+    
+    uint32_t elapsed = bench_publish(mqtt, payload, BENCH_PUBLISH_COUNT, 1);
+    bench_report(mqtt, "단건", elapsed);
+    
+    elapsed = bench_publish(mqtt, payload, BENCH_PUBLISH_COUNT, AT_QUEUE_LEN);
+    bench_report(mqtt, "연속", elapsed);
+    
+    printf("[BENCH] 에뮬레이터: 명령 %lu, 발행 %lu, 줄 초과 %lu\n",
+           (unsigned long)emu.commands, (unsigned long)emu.publishes, (unsigned long)emu.overflows);
+}
+#endif
+
 int main(void) {
     // 표준 입출력 초기화
     stdio_init_all();
     
-    // USB CDC 연결 대기 (최대 5초)
+    // USB CDC 연결 대기 (STDIO_USB_WAIT_MS, 0이면 기다리지 않음 → 전원 복구 후 바로 모듈 부팅)
+#if STDIO_USB_WAIT_MS > 0
     uint32_t start = to_ms_since_boot(get_absolute_time());
-    while (!stdio_usb_connected() && (to_ms_since_boot(get_absolute_time()) - start < 5000)) {
-        sleep_ms(100);
+    while (!stdio_usb_connected() && (to_ms_since_boot(get_absolute_time()) - start < STDIO_USB_WAIT_MS)) {
+        sleep_ms(10);
     }
-    sleep_ms(500);
+#endif
     
     printf("\n\n=== RP2040 MQTT 클라이언트 ===\n");
     printf("ESP-01 WiFi & MQTT 브로커 연결\n\n");
     
+#if PUBLISH_BENCHMARK
+    run_publish_benchmark();
+    while (true) {
+        sleep_ms(1000);
+    }
+#endif
+    
     // ESP-01 모듈 설정
     Esp01Module esp01 = {
+        .link = &esp_link,
         .uart = ESP01_UART,
         .uart_tx_pin = ESP01_UART_TX_PIN,
         .uart_rx_pin = ESP01_UART_RX_PIN,
         .uart_baudrate = ESP01_UART_BAUDRATE,
+        .uart_target_baudrate = ESP01_UART_TARGET_BAUDRATE,
+        .uart_cts_pin = ESP01_UART_CTS_PIN,
+        .uart_rts_pin = ESP01_UART_RTS_PIN,
         .rst_pin = ESP01_RST_PIN,
         .ssid = WIFI_SSID,
-        .password = WIFI_PASSWORD
+        .password = WIFI_PASSWORD,
+        .wifi_connected = false,
+        .fast_rejoin = WIFI_FAST_REJOIN,
+        .join_cache = {},
+        .join_stats = {},
+        .join_start_ms = 0,
+        .ready = false,
+        .rebooted = false,
+        .reset_ms = 0,
+        .ready_ms = 0
     };
     
+    // AT 엔진을 링크에 연결 (esp01/mqtt 함수가 link.at으로 사용)
+    at_engine_init(esp_at, esp_link);
+    
     // ESP-01 모듈 초기화 (UART + 하드웨어 리셋)
     esp01_module_init(esp01);
     
@@ -72,6 +344,7 @@ int main(void) {
     if (!esp01_at_init(esp01)) {
         printf("[오류] ESP-01 AT 초기화 실패\n");
         printf("시리얼 브리지 모드로 전환합니다...\n");
+        uart_deinit_esp01(esp_link);  // DMA/인터럽트 수신 정지 후 브릿지가 UART 직접 사용
         serial_bridge_mode(uart1);
         return -1;
     }
@@ -80,14 +353,15 @@ int main(void) {
     if (!esp01_connect_wifi(esp01)) {
         printf("[오류] WiFi 연결 실패\n");
         printf("시리얼 브리지 모드로 전환합니다...\n");
+        uart_deinit_esp01(esp_link);  // DMA/인터럽트 수신 정지 후 브릿지가 UART 직접 사용
         serial_bridge_mode(uart1);
         return -1;
     }
     
-    sleep_ms(2000);
-    
     // MQTT 클라이언트 설정
-    MqttClient mqtt = {
+    // 발신 큐/발행 통계 크기 때문에 스택이 아닌 정적 저장소에 둠
+    static MqttClient mqtt = {
+        .link = &esp_link,
         .broker = MQTT_BROKER,
         .port = MQTT_PORT,
         .client_id = MQTT_CLIENT_ID,
@@ -96,9 +370,29 @@ int main(void) {
         .lwt_topic = LWT_TOPIC,
         .lwt_message = LWT_MESSAGE,
         .connected = false,
-        .last_activity = 0
+        .last_activity = 0,
+        .pub_stats = {},
+        .pub_prefix = {},
+        .outbox = {},
+        .store = &pub_store,
+        .qos1 = {},
+        .native = {}
     };
     
+    // 플래시 보관 로그 열기 (이전 부팅에서 못 보낸 메시지는 연결 후 재전송)
+    if (!mqtt_store_init(pub_store)) {
+        printf("[경고] 보관 로그 사용 불가 - 연결 끊김 중 발행은 버려짐\n");
+        mqtt.store = NULL;
+    }
+    pub_store.pause_link = &esp_link;   // 섹터 지우기 동안 RTS로 모듈 송신 정지 (ESP01_UART_RTS_PIN 배선 시)
+    
+    // 대용량 토픽은 URC 큐 대신 스트리밍으로 수신
+    mqtt_register_stream(mqtt, TOPIC_BLOB, &blob_stream);
+    
+    // 수신 핸들러 등록
+    mqtt_router_init(msg_router);
+    mqtt_router_add(msg_router, TOPIC_CONTROL, on_control_message, &mqtt);
+    
     // MQTT 브로커 연결
     if (!mqtt_connect(mqtt)) {
         printf("[오류] MQTT 연결 실패\n");
@@ -114,50 +408,36 @@ int main(void) {
     
     uint32_t last_sensor_time = 0;
     uint32_t last_alive_time = 0;
-    uint32_t last_connection_check = 0;
+    
+    // 여기서부터 끊김은 감독자가 메인 루프를 멈추지 않고 복구
+    net_supervisor_init(net_sup, esp01, mqtt, &net_restore);
     
     while (true) {
         uint32_t now = to_ms_since_boot(get_absolute_time());
         
-        // 연결 상태 확인 (30초마다)
-        if (now - last_connection_check > 30000) {
-            // MQTT keepalive 메시지 전송
-            mqtt_keepalive(mqtt);
-            
-            if (!mqtt_is_connected(mqtt)) {
-                printf("[경고] MQTT 연결 끊김 감지\n");
-                
-                // WiFi 연결 확인
-                if (!esp01_is_connected(esp01)) {
-                    printf("[경고] WiFi 연결 끊김 감지\n");
-                    if (esp01_reconnect_wifi(esp01)) {
-                        // WiFi 재연결 성공 후 MQTT 재연결
-                        if (mqtt_reconnect(mqtt)) {
-                            mqtt_reinitialize_after_reconnect(mqtt);
-                        }
-                    }
-                } else {
-                    // WiFi는 연결됨, MQTT만 재연결
-                    if (mqtt_reconnect(mqtt)) {
-                        mqtt_reinitialize_after_reconnect(mqtt);
-                    }
-                }
-            }
-            last_connection_check = now;
-        }
+        // AT 명령 진행 + URC 분배 (차단 없음)
+        at_engine_poll(esp_at);
+        
+        // 발신 큐 배출 (연결된 동안, 재연결 후 밀린 값부터)
+        mqtt_outbox_poll(mqtt);
+        
+        // 연결 상태 확인 (30초마다) 및 끊김 시 단계별 복구
+        net_supervisor_poll(net_sup, now);
         
         // 센서 데이터 발행 (10초마다)
         if (now - last_sensor_time > 10000) {
-            char data[64];
+            char data[96];
             float temp = 25.5;  // TODO: 실제 센서 값
             float humi = 60.0;  // TODO: 실제 센서 값
-            snprintf(data, sizeof(data), "{\"temp\":%.1f,\"humi\":%.1f}", temp, humi);
+            // 측정 시각(부팅 후 ms)과 부팅 번호를 함께 실어 보관 후 재전송돼도 원래 시각 유지
+            // (재부팅 전에 보관된 값은 boot가 달라 이번 부팅의 ts와 섞이지 않음, 보관 영역이 없으면 boot 0)
+            snprintf(data, sizeof(data), "{\"boot\":%lu,\"ts\":%lu,\"temp\":%.1f,\"humi\":%.1f}",
+                     (unsigned long)pub_store.boot, (unsigned long)now, temp, humi);
             
             printf("[발행] %s: %s\n", TOPIC_SENSOR, data);
-            if (!mqtt_publish(mqtt, TOPIC_SENSOR, data, 0, 0)) {
-                printf("[경고] 센서 데이터 발행 실패 - 연결 확인 중...\n");
-                // 즉시 연결 재확인
-                last_connection_check = 0;
+            // 발신 큐에 넣기만 함 (밀려 있으면 최신 값으로 교체, 끊김 중에는 재연결 후 전송)
+            if (!mqtt_enqueue(mqtt, TOPIC_SENSOR, data, 0, 0, true)) {
+                printf("[경고] 센서 데이터 발신 큐 추가 실패\n");
             }
             last_sensor_time = now;
         }
@@ -165,30 +445,75 @@ int main(void) {
         // Alive 메시지 (60초마다)
         if (now - last_alive_time > 60000) {
             printf("[발행] %s: alive\n", TOPIC_STATUS);
-            if (!mqtt_publish(mqtt, TOPIC_STATUS, "alive", 0, 0)) {
-                printf("[경고] Alive 메시지 발행 실패 - 연결 확인 중...\n");
-                // 즉시 연결 재확인
-                last_connection_check = 0;
+            if (!mqtt_enqueue(mqtt, TOPIC_STATUS, "alive", 0, 0, true)) {
+                printf("[경고] Alive 메시지 발신 큐 추가 실패\n");
+            }
+            
+            // AT 왕복 시간 분포 출력 (UART_WAIT_POLL_MS=10 빌드와 비교용)
+            uart_print_rtt_histogram(esp_link);
+            
+            // 링크 실측 처리량 (보드레이트 전환 이후 누적)
+            UartThroughput tp;
+            uart_get_throughput(esp_link, &tp);
+            printf("[UART] %lu baud%s, RX %lu B/s, TX %lu B/s (%lu ms)\n",
+                   (unsigned long)tp.baudrate, tp.flow_control ? " RTS/CTS" : "",
+                   (unsigned long)tp.rx_bytes_per_sec, (unsigned long)tp.tx_bytes_per_sec,
+                   (unsigned long)tp.elapsed_ms);
+            
+            // 발행 지연 (제출 → +MQTTPUB:OK, 최근 표본)
+            MqttPublishLatency lat;
+            mqtt_get_publish_latency(mqtt, &lat);
+            printf("[MQTT] 발행 %lu건 (실패 %lu), p50 %lu us, p99 %lu us\n",
+                   (unsigned long)lat.published, (unsigned long)lat.failed,
+                   (unsigned long)lat.p50_us, (unsigned long)lat.p99_us);
+            printf("[MQTT] 발신 큐 %lu건 대기, 전송 %lu, 병합 %lu, 버림 %lu\n",
+                   (unsigned long)mqtt.outbox.count, (unsigned long)mqtt.outbox.sent,
+                   (unsigned long)mqtt.outbox.coalesced, (unsigned long)mqtt.outbox.dropped);
+            printf("[MQTT] QoS 1 %lu건 확인 대기, 확인 %lu, 재전송 %lu, 포기 %lu\n",
+                   (unsigned long)mqtt_qos1_pending(mqtt), (unsigned long)mqtt.qos1.delivered,
+                   (unsigned long)mqtt.qos1.retransmits, (unsigned long)mqtt.qos1.expired);
+            printf("[NET] %s, 끊김 %lu회, 복구 %lu회 (시도 %lu, WiFi 재접속 %lu, 모듈 리셋 %lu), 복구 시간 최근 %lu ms / 최대 %lu ms\n",
+                   net_supervisor_state_name(net_sup.state), (unsigned long)net_sup.stats.outages,
+                   (unsigned long)net_sup.stats.recoveries, (unsigned long)net_sup.stats.attempts,
+                   (unsigned long)net_sup.stats.wifi_rejoins, (unsigned long)net_sup.stats.module_resets,
+                   (unsigned long)net_sup.stats.last_recover_ms, (unsigned long)net_sup.stats.max_recover_ms);
+            printf("[WiFi] 빠른 재접속 %lu회 (실패 %lu, 최근 %lu ms), 전체 접속 %lu회 (최근 %lu ms)\n",
+                   (unsigned long)esp01.join_stats.fast_ok, (unsigned long)esp01.join_stats.fast_failed,
+                   (unsigned long)esp01.join_stats.last_fast_ms, (unsigned long)esp01.join_stats.full_ok,
+                   (unsigned long)esp01.join_stats.last_full_ms);
+            printf("[STORE] 보관 %lu건 대기, 기록 %lu, 재전송 %lu, 삭제 %lu, 섹터 지우기 %lu\n",
+                   (unsigned long)pub_store.pending, (unsigned long)pub_store.stored,
+                   (unsigned long)pub_store.replayed, (unsigned long)pub_store.dropped,
+                   (unsigned long)pub_store.erases);
+
+            // UART 링크 통계 발행 (손실/오류/링버퍼 최대 점유)
+            char stats[384];
+            if (uart_format_link_stats(esp_link, stats, sizeof(stats)) > 0) {
+                printf("[발행] %s: %s\n", TOPIC_UART_STATS, stats);
+                mqtt_enqueue(mqtt, TOPIC_UART_STATS, stats, 0, 0, true);
+            }
+            
+            // 복구 감독자 통계 발행 (상태/단계/복구 시간)
+            if (net_supervisor_format_stats(net_sup, now, stats, sizeof(stats)) > 0) {
+                printf("[발행] %s: %s\n", TOPIC_NET_STATS, stats);
+                mqtt_enqueue(mqtt, TOPIC_NET_STATS, stats, 0, 0, true);
             }
             last_alive_time = now;
         }
         
-        // MQTT 메시지 수신 확인
-        char topic[64], message[128];
-        if (mqtt_check_message(mqtt, topic, sizeof(topic), message, sizeof(message))) {
-            printf("[수신] %s: %s\n", topic, message);
+        // MQTT 메시지 수신 확인 (URC 큐 안의 메시지를 복사 없이 처리)
+        UartMqttFrame msg;
+        while (mqtt_peek_message(mqtt, &msg)) {
+            printf("[수신] %s: %.*s\n", msg.topic, (int)msg.payload_len, msg.payload);
             
-            // 제어 명령 처리
-            if (strstr(message, "ON")) {
-                printf("[제어] 장치 ON\n");
-                // TODO: 액츄에이터 제어
-            } else if (strstr(message, "OFF")) {
-                printf("[제어] 장치 OFF\n");
-                // TODO: 액츄에이터 제어
+            if (mqtt_router_dispatch(msg_router, msg.topic, msg.payload, msg.payload_len) == 0) {
+                printf("[경고] 처리하지 않는 토픽: %s\n", msg.topic);
             }
+            mqtt_release_message(mqtt);
         }
         
-        sleep_ms(50);
+        // 다음 UART 이벤트까지 수면 (응답이 오면 바로 깨어나 AT 엔진 진행)
+        uart_wait_event(make_timeout_time_ms(50));
     }
     
     return 0;
@@ -6,15 +6,25 @@
 #include "tm1637.h"
 #include "hardware/uart.h"
 
+// 부팅 시 USB 시리얼 연결 대기 (ms, 부팅 로그를 볼 때만 5000 등으로 설정)
+// 0이면 바로 모듈 부팅 → 현장 보드의 전원 복구 후 첫 발행이 그만큼 빨라짐
+#define STDIO_USB_WAIT_MS 0
+
 // WiFi 설정
 #define WIFI_SSID "FarmMain5G"
 #define WIFI_PASSWORD "wweerrtt"
+#define WIFI_FAST_REJOIN 1 // 재접속 시 마지막 BSSID/IP 사용 (스캔/DHCP 생략, 실패 시 전체 접속)
 
 // ESP-01 하드웨어 설정
 #define ESP01_UART uart1
 #define ESP01_UART_TX_PIN 4
 #define ESP01_UART_RX_PIN 5
 #define ESP01_UART_BAUDRATE 115200
+// RX DMA 링 모드는 FIFO를 항상 비우므로 RTS가 내려가지 않음 (링버퍼 넘침 보호 없음)
+// → 921600 등 고속은 UART_RX_BUFFER_SIZE를 충분히 키운 뒤에만 사용
+#define ESP01_UART_TARGET_BAUDRATE 0 // AT+UART_CUR로 전환 (0 = 115200 유지)
+#define ESP01_UART_CTS_PIN -1 // RTS/CTS 배선 시 핀 번호 (-1 = 미연결)
+#define ESP01_UART_RTS_PIN -1
 #define ESP01_RST_PIN 3
 
 // TM1637 디스플레이 하드웨어 설정 (8개 병렬)
@@ -51,20 +61,28 @@
 // 연결 재확인 간격 (밀리초)
 #define CONNECTION_CHECK_MS 5000 // 5초마다 연결 상태 확인
 #define DISPLAY_UPDATE_MS 1000   // 1초마다 디스플레이 업데이트
+#define UART_STATS_PUBLISH_MS 60000 // 1분마다 UART 링크 통계 발행
+
+// 부팅 단계 (디스플레이 테스트와 모듈 부팅/WiFi 접속을 겹쳐 진행)
+#define DISPLAY_TEST_MS 1000        // 8888 자가 테스트 표시 시간
+#define FIRST_DISPLAY_WAIT_MS 5000  // 구독 후 첫 값(retained) 대기 한도, 지나면 빈 화면으로 메인 루프 진입
 
 // 센서 값 범위 검증 (온도/습도)
 #define SENSOR_VALUE_MIN -99.9f
 #define SENSOR_VALUE_MAX 99.9f
 
-// MQTT 메시지 버퍼 크기
-#define MQTT_TOPIC_MAX_LEN 64
-#define MQTT_MESSAGE_MAX_LEN 128
-
 // MQTT 토픽 - 디스플레이용
 #define TOPIC_STATUS "Display/TM1637/status"
+#define TOPIC_UART_STATS "Display/TM1637/uart_stats" // RX 손실/오류/최대 점유 (버퍼 크기 결정용)
+#define TOPIC_NET_STATS "Display/TM1637/net_stats"   // 복구 감독자 상태/끊김 횟수/복구 시간
+#define TOPIC_BOOT_STATS "Display/TM1637/boot_stats" // 부팅 단계별 시작/소요 시간 (부팅마다 1회, retain)
 #define LWT_TOPIC TOPIC_STATUS
 #define LWT_MESSAGE "offline"
 
+// 구독 토픽을 '+' 필터로 묶어 구독 명령 수 줄이기 (1: 16개 → 2개, 0: 토픽별 구독)
+// 묶인 필터로 들어오는 다른 토픽은 수신 후 로컬에서 걸러냄
+#define MQTT_SUBS_COLLAPSE 1
+
 // 센서 데이터 구독 토픽 (온실별 온도/습도)
 // GH1~GH4: Greenhouse 1~4
 #define TOPIC_GH1_TEMP "Sensor/GH1/Center/Temp"
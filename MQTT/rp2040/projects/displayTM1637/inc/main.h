@@ -6,6 +6,7 @@
 #include <cstdlib>
 #include <stdbool.h>
 #include "mqtt_client.h"
+#include "topic_table.h"
 #include "tm1637.h"
 #include "config.h"
 
@@ -18,73 +19,50 @@ typedef struct {
     bool valid;         // 데이터 유효성
 } DisplayData;
 
-// 토픽-디스플레이 매핑 구조체
+// 수신 토픽 종류
+enum DisplayTopicKind : uint8_t
+{
+    TOPIC_KIND_READING,     // 센서 값
+    TOPIC_KIND_OFFSET       // 보정값
+};
+
+// 수신 토픽 → 디스플레이 인덱스 + 종류
 typedef struct {
-    const char* topic;
-    int display_idx;
-} TopicMapping;
+    uint8_t display_idx;
+    DisplayTopicKind kind;
+} DisplayTopic;
+
+typedef TopicTable<DisplayTopic, NUM_DISPLAYS * 2> DisplayTopicTable;
+
+// 구독/수신 토픽 목록 (컴파일 타임 완전 해시 테이블, 플래시에 배치)
+inline constexpr DisplayTopicTable::Entry display_topic_list[NUM_DISPLAYS * 2] = {
+    {TOPIC_GH1_TEMP, {DISPLAY_GH1_TEMP, TOPIC_KIND_READING}},
+    {TOPIC_GH1_HUM, {DISPLAY_GH1_HUM, TOPIC_KIND_READING}},
+    {TOPIC_GH2_TEMP, {DISPLAY_GH2_TEMP, TOPIC_KIND_READING}},
+    {TOPIC_GH2_HUM, {DISPLAY_GH2_HUM, TOPIC_KIND_READING}},
+    {TOPIC_GH3_TEMP, {DISPLAY_GH3_TEMP, TOPIC_KIND_READING}},
+    {TOPIC_GH3_HUM, {DISPLAY_GH3_HUM, TOPIC_KIND_READING}},
+    {TOPIC_GH4_TEMP, {DISPLAY_GH4_TEMP, TOPIC_KIND_READING}},
+    {TOPIC_GH4_HUM, {DISPLAY_GH4_HUM, TOPIC_KIND_READING}},
+    {TOPIC_GH1_TEMP_OFFSET, {DISPLAY_GH1_TEMP, TOPIC_KIND_OFFSET}},
+    {TOPIC_GH1_HUM_OFFSET, {DISPLAY_GH1_HUM, TOPIC_KIND_OFFSET}},
+    {TOPIC_GH2_TEMP_OFFSET, {DISPLAY_GH2_TEMP, TOPIC_KIND_OFFSET}},
+    {TOPIC_GH2_HUM_OFFSET, {DISPLAY_GH2_HUM, TOPIC_KIND_OFFSET}},
+    {TOPIC_GH3_TEMP_OFFSET, {DISPLAY_GH3_TEMP, TOPIC_KIND_OFFSET}},
+    {TOPIC_GH3_HUM_OFFSET, {DISPLAY_GH3_HUM, TOPIC_KIND_OFFSET}},
+    {TOPIC_GH4_TEMP_OFFSET, {DISPLAY_GH4_TEMP, TOPIC_KIND_OFFSET}},
+    {TOPIC_GH4_HUM_OFFSET, {DISPLAY_GH4_HUM, TOPIC_KIND_OFFSET}}};
+
+inline constexpr DisplayTopicTable display_topics(display_topic_list);
+
+static_assert(display_topics.perfect(), "토픽 목록에 중복이 있거나 충돌 없는 해시 시드를 찾지 못함");
+static_assert(display_topics.max_len() < MAX_TOPIC_LEN, "토픽 길이가 MAX_TOPIC_LEN을 넘음");
+static_assert(display_topics.max_len() < MQTT_SUBS_FILTER_MAX, "토픽 길이가 구독 필터 최대 길이를 넘음");
 
 // 전역 변수 선언
 extern TM1637Display* displays[NUM_DISPLAYS];
 extern DisplayData display_data[NUM_DISPLAYS];
-extern const TopicMapping topic_map[NUM_DISPLAYS];
-
-/**
- * @brief MQTT 재연결 후 초기화 작업 수행
- * 
- * MQTT 브로커 재연결 시 필요한 모든 초기화 작업을 수행합니다:
- * - 상태 토픽에 online 메시지 발행
- * - 센서 토픽 재구독 (GH1~GH4)
- * - 보정값 토픽 재구독 (GH1~GH4)
- * 
- * @param mqtt MQTT 클라이언트 구조체
- * @return true 모든 초기화 작업 성공
- * @return false 초기화 작업 중 하나라도 실패
- */
-inline bool mqtt_reinitialize_after_reconnect(MqttClient& mqtt) {
-    printf("[MQTT] 재연결 후 초기화 시작...\n");
-    
-    // 상태 토픽에 online 메시지 발행 (retain)
-    if (!mqtt_publish(mqtt, TOPIC_STATUS, "online", 0, 1)) {
-        printf("[오류] 상태 메시지 발행 실패: %s\n", TOPIC_STATUS);
-        return false;
-    }
-    
-    // 센서 데이터 토픽 구독 (GH1~GH4)
-    const char* sensor_topics[] = {
-        TOPIC_GH1_TEMP, TOPIC_GH1_HUM,
-        TOPIC_GH2_TEMP, TOPIC_GH2_HUM,
-        TOPIC_GH3_TEMP, TOPIC_GH3_HUM,
-        TOPIC_GH4_TEMP, TOPIC_GH4_HUM
-    };
-    
-    for (size_t i = 0; i < sizeof(sensor_topics) / sizeof(sensor_topics[0]); i++) {
-        if (!mqtt_subscribe(mqtt, sensor_topics[i], 0)) {
-            printf("[오류] 센서 토픽 재구독 실패: %s\n", sensor_topics[i]);
-            return false;
-        }
-        printf("[MQTT] 센서 토픽 재구독 완료: %s\n", sensor_topics[i]);
-    }
-    
-    // 보정값 토픽 구독 (GH1~GH4)
-    const char* offset_topics[] = {
-        TOPIC_GH1_TEMP_OFFSET, TOPIC_GH1_HUM_OFFSET,
-        TOPIC_GH2_TEMP_OFFSET, TOPIC_GH2_HUM_OFFSET,
-        TOPIC_GH3_TEMP_OFFSET, TOPIC_GH3_HUM_OFFSET,
-        TOPIC_GH4_TEMP_OFFSET, TOPIC_GH4_HUM_OFFSET
-    };
-    
-    for (size_t i = 0; i < sizeof(offset_topics) / sizeof(offset_topics[0]); i++) {
-        if (!mqtt_subscribe(mqtt, offset_topics[i], 0)) {
-            printf("[오류] 보정값 토픽 재구독 실패: %s\n", offset_topics[i]);
-            return false;
-        }
-        printf("[MQTT] 보정값 토픽 재구독 완료: %s\n", offset_topics[i]);
-    }
-    
-    printf("[MQTT] 재연결 후 초기화 완료\n");
-    return true;
-}
+extern MqttSubscriptions display_subs;
 
 /**
  * @brief MQTT 메시지에서 float 값 파싱 (범위 검증)
@@ -106,47 +84,34 @@ inline float parse_float_from_message(const char* message) {
 }
 
 /**
- * @brief MQTT 메시지 처리 (센서 데이터 및 보정값 업데이트 - 테이블 기반)
+ * @brief MQTT 메시지 처리 (센서 데이터 및 보정값 업데이트 - 컴파일 타임 테이블 기반)
  * 
- * 토픽-디스플레이 매핑 테이블을 사용하여 동적으로 업데이트합니다.
+ * display_topics에서 토픽을 해시 1회 + 비교 1회로 찾아 동적으로 업데이트합니다.
  * - 센서 값: display_data[idx].value 업데이트
  * - 보정값: display_data[idx].offset 업데이트
+ * 목록에 없는 토픽 (묶은 구독 필터로 들어온 다른 온실/항목)은 무시합니다.
  * 
  * @param topic MQTT 토픽
+ * @param topic_len 토픽 길이
  * @param message MQTT 메시지
  */
-inline void process_mqtt_message(const char* topic, const char* message) {
-    printf("[수신] %s: %s\n", topic, message);
-    
-    float value = parse_float_from_message(message);
-    
-    // 센서 값 토픽 처리
-    for (int i = 0; i < NUM_DISPLAYS; i++) {
-        if (strcmp(topic, topic_map[i].topic) == 0) {
-            int idx = topic_map[i].display_idx;
-            display_data[idx].value = value;
-            display_data[idx].valid = true;
-            return;
-        }
+inline void process_mqtt_message(const char* topic, uint32_t topic_len, const char* message) {
+    const DisplayTopic* entry = display_topics.find(topic, topic_len);
+    if (!entry) {
+        return;
     }
     
-    // 보정값 토픽 처리
-    const char* offset_topics[] = {
-        TOPIC_GH1_TEMP_OFFSET, TOPIC_GH1_HUM_OFFSET,
-        TOPIC_GH2_TEMP_OFFSET, TOPIC_GH2_HUM_OFFSET,
-        TOPIC_GH3_TEMP_OFFSET, TOPIC_GH3_HUM_OFFSET,
-        TOPIC_GH4_TEMP_OFFSET, TOPIC_GH4_HUM_OFFSET
-    };
+    printf("[수신] %s: %s\n", topic, message);
+    DisplayData& data = display_data[entry->display_idx];
+    float value = parse_float_from_message(message);
     
-    for (int i = 0; i < NUM_DISPLAYS; i++) {
-        if (strcmp(topic, offset_topics[i]) == 0) {
-            display_data[i].offset = value;
-            printf("[OK] 보정값 업데이트: 디스플레이 %d, 오프셋=%.1f\n", i, value);
-            return;
-        }
+    if (entry->kind == TOPIC_KIND_READING) {
+        data.value = value;
+        data.valid = true;
+    } else {
+        data.offset = value;
+        printf("[OK] 보정값 업데이트: 디스플레이 %d, 오프셋=%.1f\n", entry->display_idx, value);
     }
-    
-    printf("[경고] 알 수 없는 토픽: %s\n", topic);
 }
 
 /**
@@ -7,8 +7,11 @@
 #include "pico/unique_id.h" // RP2040 고유 ID
 #include "hardware/uart.h"
 #include "uart_comm.h"
+#include "at_engine.h"
 #include "esp01.h"
 #include "mqtt_client.h"
+#include "net_supervisor.h"
+#include "boot_seq.h"
 #include "serial_bridge.h"
 #include "tm1637.h"
 #include "config.h"
@@ -18,16 +21,17 @@
 TM1637Display *displays[NUM_DISPLAYS];
 DisplayData display_data[NUM_DISPLAYS] = {{0.0f, 0.0f, false}};
 
-// 토픽-디스플레이 매핑 테이블 (동적 처리용)
-const TopicMapping topic_map[NUM_DISPLAYS] = {
-    {TOPIC_GH1_TEMP, DISPLAY_GH1_TEMP},
-    {TOPIC_GH1_HUM, DISPLAY_GH1_HUM},
-    {TOPIC_GH2_TEMP, DISPLAY_GH2_TEMP},
-    {TOPIC_GH2_HUM, DISPLAY_GH2_HUM},
-    {TOPIC_GH3_TEMP, DISPLAY_GH3_TEMP},
-    {TOPIC_GH3_HUM, DISPLAY_GH3_HUM},
-    {TOPIC_GH4_TEMP, DISPLAY_GH4_TEMP},
-    {TOPIC_GH4_HUM, DISPLAY_GH4_HUM}};
+// ESP-01 UART 링크 (링버퍼 정렬 및 크기 때문에 스택이 아닌 전역에 둠)
+static UartLink esp_link;
+
+// ESP-01 AT 명령 엔진 (메인 루프에서 at_engine_poll로 진행)
+static AtEngine esp_at;
+
+// 네트워크 복구 감독자 (끊김 시 MQTT → WiFi → 모듈 리셋 순, 지수 백오프 + 보드별 지터)
+static NetSupervisor net_sup;
+
+// 구독 토픽 (센서 + 보정값, 재연결마다 묶은 필터로 다시 구독)
+MqttSubscriptions display_subs;
 
 /**
  * @brief RP2040 고유 ID를 사용해 고유한 MQTT Client ID 생성
@@ -47,24 +51,95 @@ void generate_unique_client_id(char *buffer, size_t buffer_size)
              board_id.id[6], board_id.id[7]);
 }
 
-int main(void)
+/**
+ * @brief 브로커 재연결 후 복원 제출 (감독자 복원 훅, 차단 없음)
+ *
+ * 새 연결이면 상태 토픽에 online 메시지를 발행(retain)하고 구독 필터를 모두 다시 구독,
+ * 재시도면 실패한 필터만 다시 구독합니다. 루프는 그동안 디스플레이 갱신을 계속합니다.
+ *
+ * @param mqtt MQTT 클라이언트
+ * @param attempt 복원 시도 번호 (0 = 새 연결)
+ * @param user 사용 안 함
+ * @return 제출 여부
+ */
+static bool net_restore_submit(MqttClient &mqtt, uint32_t attempt, void *user)
 {
-    // 표준 입출력 초기화
-    stdio_init_all();
+    if (attempt == 0)
+    {
+        printf("[MQTT] 재연결 후 초기화 시작...\n");
+        mqtt_publish_async(mqtt, TOPIC_STATUS, "online", 0, 1);
+        return mqtt_subs_start(mqtt, display_subs);
+    }
+    return mqtt_subs_retry(mqtt, display_subs);
+}
 
-    // USB CDC 연결 대기 (최대 5초)
-    uint32_t start = to_ms_since_boot(get_absolute_time());
-    while (!stdio_usb_connected() && (to_ms_since_boot(get_absolute_time()) - start < 5000))
+/**
+ * @brief 구독 결과 확인 (감독자 복원 훅)
+ *
+ * 실패한 필터는 1초 후 재시도 (최대 3회), 그래도 실패하면 포기하고 정상 상태로 돌아갑니다.
+ */
+static NetRestoreResult net_restore_check(MqttClient &mqtt, uint32_t attempt, void *user)
+{
+    if (mqtt_subs_busy(display_subs))
     {
-        sleep_ms(100);
+        return NET_RESTORE_PENDING; // 네이티브 전송: SUBACK 대기 중
+    }
+    if (mqtt_subs_failed(display_subs) > 0)
+    {
+        if (attempt + 1 < 3)
+        {
+            printf("[MQTT] 구독 실패 %d개 (시도 %lu/3)\n", mqtt_subs_failed(display_subs), (unsigned long)(attempt + 1));
+            return NET_RESTORE_RETRY;
+        }
+        printf("[오류] 토픽 재구독 실패: %d개 필터\n", mqtt_subs_failed(display_subs));
     }
-    sleep_ms(500);
+    printf("[MQTT] 재연결 후 초기화 완료\n");
+    return NET_RESTORE_DONE;
+}
 
-    printf("\n\n=== RP2040 TM1637 디스플레이 ===\n");
-    printf("8개 디스플레이 - 온실 4개 (온도/습도)\n\n");
+static const NetRestoreHooks net_restore = {net_restore_submit, net_restore_check, NULL};
 
-    // 8개 TM1637 디스플레이 초기화
-    const uint8_t display_pins[NUM_DISPLAYS][2] = {
+/**
+ * @brief 수신한 MQTT 메시지 처리 (URC 큐 안의 메시지를 복사 없이 처리)
+ */
+static void process_received_messages(MqttClient &mqtt)
+{
+    UartMqttFrame msg;
+    while (mqtt_peek_message(mqtt, &msg))
+    {
+        process_mqtt_message(msg.topic, msg.topic_len, msg.payload);
+        mqtt_release_message(mqtt);
+    }
+}
+
+// ===== 부팅 단계 =====
+// 디스플레이 초기화/자가 테스트는 타이머만 기다리고, 모듈 부팅/접속은 응답만 기다리므로 서로 겹쳐 진행
+
+// 부팅 단계 공유 상태 (단계 함수의 user)
+typedef struct
+{
+    Esp01Module *esp01;
+    MqttClient *mqtt;
+    AtEngine *at;
+    uint32_t test_start;      // 자가 테스트 표시 시작 시각
+    uint32_t reset_at;        // RST 핀 내린 시각
+    bool reset_released;
+    uint32_t next_probe;      // 다음 부팅 확인 AT 시각
+    int at_result;            // 비차단 AT 초기화 결과 (AT_RESULT_PENDING = 대기)
+    uint8_t at_tries;
+    uint8_t join_tries;
+    uint32_t restore_attempt;
+    bool restore_submitted;
+    uint32_t restore_at;      // 복원 재제출 가능 시각
+    uint32_t wait_start;      // 첫 값 대기 시작 시각
+} DisplayBoot;
+
+/**
+ * @brief 8개 TM1637 디스플레이 초기화 (실패 시 이미 만든 디스플레이 정리)
+ */
+static BootStepResult boot_display_init(void *user, uint32_t now)
+{
+    static const uint8_t display_pins[NUM_DISPLAYS][2] = {
         {TM1637_GH1_TEMP_CLK, TM1637_GH1_TEMP_DIO}, // GH1 온도
         {TM1637_GH1_HUM_CLK, TM1637_GH1_HUM_DIO},   // GH1 습도
         {TM1637_GH2_TEMP_CLK, TM1637_GH2_TEMP_DIO}, // GH2 온도
@@ -75,7 +150,7 @@ int main(void)
         {TM1637_GH4_HUM_CLK, TM1637_GH4_HUM_DIO}    // GH4 습도
     };
 
-    const char *display_names[NUM_DISPLAYS] = {
+    static const char *const display_names[NUM_DISPLAYS] = {
         "GH1 온도", "GH1 습도",
         "GH2 온도", "GH2 습도",
         "GH3 온도", "GH3 습도",
@@ -98,61 +173,308 @@ int main(void)
                     displays[j] = nullptr;
                 }
             }
-            return -1;
+            delete displays[i];
+            displays[i] = nullptr;
+            return BOOT_STEP_FAILED;
         }
         displays[i]->setBrightness(TM1637_BRIGHTNESS);
         printf("[OK] %s 디스플레이 초기화 완료 (CLK=%d, DIO=%d)\n",
                display_names[i], display_pins[i][0], display_pins[i][1]);
     }
+    return BOOT_STEP_DONE;
+}
 
-    // 초기 테스트 표시 (모든 디스플레이에 8888)
+/**
+ * @brief 자가 테스트 시작 (모든 디스플레이에 8888, DISPLAY_TEST_MS 뒤 지움)
+ */
+static BootStepResult boot_display_test_start(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
     printf("\n디스플레이 테스트 중...\n");
     for (int i = 0; i < NUM_DISPLAYS; i++)
     {
         displays[i]->showNumber(8888, true);
     }
-    sleep_ms(1000);
+    boot.test_start = now;
+    return BOOT_STEP_PENDING;
+}
+
+static BootStepResult boot_display_test_poll(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    if (now - boot.test_start < DISPLAY_TEST_MS)
+    {
+        return BOOT_STEP_PENDING;
+    }
     for (int i = 0; i < NUM_DISPLAYS; i++)
     {
         displays[i]->clear();
     }
     printf("디스플레이 테스트 완료\n\n");
+    return BOOT_STEP_DONE;
+}
 
-    // ESP-01 모듈 설정
-    Esp01Module esp01 = {
-        .uart = ESP01_UART,
-        .uart_tx_pin = ESP01_UART_TX_PIN,
-        .uart_rx_pin = ESP01_UART_RX_PIN,
-        .uart_baudrate = ESP01_UART_BAUDRATE,
-        .rst_pin = ESP01_RST_PIN,
-        .ssid = WIFI_SSID,
-        .password = WIFI_PASSWORD};
-
-    // ESP-01 모듈 초기화
+/**
+ * @brief ESP-01 리셋 시작 (UART 초기화 + RST 핀 내림)
+ */
+static BootStepResult boot_esp_start(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
     printf("[정보] ESP-01 모듈 초기화 중...\n");
-    esp01_module_init(esp01);
+    if (!esp01_module_begin(*boot.esp01))
+    {
+        return BOOT_STEP_FAILED;
+    }
+    boot.reset_at = now;
+    return BOOT_STEP_PENDING;
+}
 
-    // ESP-01 AT 명령 초기화
-    if (!esp01_at_init(esp01))
+/**
+ * @brief 리셋 펄스 후 RST 핀을 올리고 "ready" 배너 또는 AT 응답 대기
+ *
+ * ESP01_BOOT_WAIT_MS 안에 확인하지 못해도 완료로 처리합니다 (AT 초기화 단계가 다시 확인).
+ */
+static BootStepResult boot_esp_poll(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    Esp01Module &esp01 = *boot.esp01;
+    if (!boot.reset_released)
+    {
+        if (now - boot.reset_at < ESP01_RESET_PULSE_MS)
+        {
+            return BOOT_STEP_PENDING;
+        }
+        esp01_reset_release(esp01);
+        boot.reset_released = true;
+        boot.next_probe = now + ESP01_READY_PROBE_MS;
+        return BOOT_STEP_PENDING;
+    }
+    if (esp01.ready)
+    {
+        return BOOT_STEP_DONE;
+    }
+    if (now - esp01.reset_ms >= ESP01_BOOT_WAIT_MS)
+    {
+        printf("[경고] ESP-01 부팅 확인 못함 - AT 초기화에서 다시 확인\n");
+        return BOOT_STEP_DONE;
+    }
+    // 배너를 놓친 경우 대비 짧은 간격 AT 확인
+    if ((int32_t)(now - boot.next_probe) >= 0 && esp01_probe_ready_async(esp01))
+    {
+        boot.next_probe = now + ESP01_READY_PROBE_MS;
+    }
+    return BOOT_STEP_PENDING;
+}
+
+static void on_boot_at_done(int result, void *user)
+{
+    ((DisplayBoot *)user)->at_result = result;
+}
+
+/**
+ * @brief AT 초기화 제출 (AT → ATE0 → AT+CWMODE=1)
+ */
+static BootStepResult boot_at_start(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    boot.at_result = AT_RESULT_PENDING;
+    return esp01_at_init_async(*boot.esp01, on_boot_at_done, &boot) ? BOOT_STEP_PENDING : BOOT_STEP_FAILED;
+}
+
+/**
+ * @brief AT 초기화 결과 확인 (최대 3회), 성공하면 고속 보드레이트로 전환
+ */
+static BootStepResult boot_at_poll(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    if (boot.at_result == AT_RESULT_PENDING)
+    {
+        return BOOT_STEP_PENDING;
+    }
+    // 보드레이트 전환은 차단이지만 수 ms (실패해도 기존 보드레이트로 계속)
+    // 전환 실패 복구 리셋 뒤에도 모듈이 응답하지 않으면 AT 초기화 실패와 같이 재시도
+    if (boot.at_result == 0 && esp01_negotiate_baudrate(*boot.esp01))
+    {
+        return BOOT_STEP_DONE;
+    }
+    if (++boot.at_tries >= 3)
     {
         printf("[오류] ESP-01 AT 초기화 실패\n");
-        printf("시리얼 브리지 모드로 전환합니다...\n");
-        cleanup_resources();
-        serial_bridge_mode(uart1);
-        return -1;
+        return BOOT_STEP_FAILED;
     }
+    printf("[경고] ESP-01 AT 초기화 재시도 (%d/3)\n", boot.at_tries + 1);
+    return boot_at_start(user, now);
+}
+
+/**
+ * @brief WiFi 접속 제출 (빠른 재접속 → 실패 시 전체 접속)
+ */
+static BootStepResult boot_wifi_start(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    return esp01_connect_wifi_async(*boot.esp01) ? BOOT_STEP_PENDING : BOOT_STEP_FAILED;
+}
 
-    // WiFi 연결
-    if (!esp01_connect_wifi(esp01))
+static BootStepResult boot_wifi_poll(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    if (at_engine_busy(*boot.at))
+    {
+        return BOOT_STEP_PENDING;
+    }
+    if (boot.esp01->wifi_connected)
+    {
+        return BOOT_STEP_DONE;
+    }
+    if (++boot.join_tries >= 3)
     {
         printf("[오류] WiFi 연결 실패\n");
-        printf("시리얼 브리지 모드로 전환합니다...\n");
-        cleanup_resources();
-        serial_bridge_mode(uart1);
-        return -1;
+        return BOOT_STEP_FAILED;
+    }
+    printf("[경고] WiFi 연결 실패 (시도 %d/3)\n", boot.join_tries);
+    return boot_wifi_start(user, now);
+}
+
+/**
+ * @brief 브로커 연결 제출
+ */
+static BootStepResult boot_mqtt_start(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    return mqtt_connect_async(*boot.mqtt) ? BOOT_STEP_PENDING : BOOT_STEP_FAILED;
+}
+
+static BootStepResult boot_mqtt_poll(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    if (at_engine_busy(*boot.at) || mqtt_connect_pending(*boot.mqtt))
+    {
+        return BOOT_STEP_PENDING;
+    }
+    return mqtt_is_connected(*boot.mqtt) ? BOOT_STEP_DONE : BOOT_STEP_FAILED;
+}
+
+/**
+ * @brief online 발행 + 구독 (감독자 복원 훅과 같은 절차)
+ */
+static BootStepResult boot_restore_start(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    boot.restore_attempt = 0;
+    boot.restore_submitted = false;
+    boot.restore_at = now;
+    return BOOT_STEP_PENDING;
+}
+
+static BootStepResult boot_restore_poll(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    MqttClient &mqtt = *boot.mqtt;
+    if (!mqtt_is_connected(mqtt))
+    {
+        return BOOT_STEP_FAILED;
+    }
+    if (!boot.restore_submitted)
+    {
+        if ((int32_t)(now - boot.restore_at) >= 0)
+        {
+            boot.restore_submitted = net_restore_submit(mqtt, boot.restore_attempt, NULL);
+        }
+        return BOOT_STEP_PENDING;
+    }
+    if (at_engine_busy(*boot.at))
+    {
+        return BOOT_STEP_PENDING;
+    }
+    switch (net_restore_check(mqtt, boot.restore_attempt, NULL))
+    {
+    case NET_RESTORE_DONE:
+        return BOOT_STEP_DONE;
+    case NET_RESTORE_RETRY:
+        boot.restore_attempt++;
+        boot.restore_submitted = false;
+        boot.restore_at = now + NET_SUP_RESTORE_RETRY_MS;
+        return BOOT_STEP_PENDING;
+    default:
+        return BOOT_STEP_PENDING;
+    }
+}
+
+/**
+ * @brief 첫 값 표시 대기 (구독 직후 들어오는 retained 값)
+ *
+ * 값이 들어오면 바로 화면을 갱신하고 완료, FIRST_DISPLAY_WAIT_MS 안에 없으면 실패로 기록합니다
+ * (메인 루프는 그대로 시작하고 값이 오면 표시).
+ */
+static BootStepResult boot_first_data_start(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    boot.wait_start = now;
+    return BOOT_STEP_PENDING;
+}
+
+static BootStepResult boot_first_data_poll(void *user, uint32_t now)
+{
+    DisplayBoot &boot = *(DisplayBoot *)user;
+    for (int i = 0; i < NUM_DISPLAYS; i++)
+    {
+        if (display_data[i].valid)
+        {
+            update_all_displays();
+            printf("[정보] 첫 값 표시: 부팅 후 %lu ms\n", (unsigned long)now);
+            return BOOT_STEP_DONE;
+        }
+    }
+    if (now - boot.wait_start >= FIRST_DISPLAY_WAIT_MS)
+    {
+        printf("[경고] %d ms 안에 수신한 값 없음 - 메인 루프에서 계속 대기\n", FIRST_DISPLAY_WAIT_MS);
+        return BOOT_STEP_FAILED;
+    }
+    return BOOT_STEP_PENDING;
+}
+
+int main(void)
+{
+    // 표준 입출력 초기화
+    stdio_init_all();
+
+    // USB CDC 연결 대기 (STDIO_USB_WAIT_MS, 0이면 기다리지 않음 → 전원 복구 후 바로 모듈 부팅)
+#if STDIO_USB_WAIT_MS > 0
+    uint32_t start = to_ms_since_boot(get_absolute_time());
+    while (!stdio_usb_connected() && (to_ms_since_boot(get_absolute_time()) - start < STDIO_USB_WAIT_MS))
+    {
+        sleep_ms(10);
     }
+#endif
+
+    printf("\n\n=== RP2040 TM1637 디스플레이 ===\n");
+    printf("8개 디스플레이 - 온실 4개 (온도/습도)\n\n");
+
+    // ESP-01 모듈 설정
+    Esp01Module esp01 = {
+        .link = &esp_link,
+        .uart = ESP01_UART,
+        .uart_tx_pin = ESP01_UART_TX_PIN,
+        .uart_rx_pin = ESP01_UART_RX_PIN,
+        .uart_baudrate = ESP01_UART_BAUDRATE,
+        .uart_target_baudrate = ESP01_UART_TARGET_BAUDRATE,
+        .uart_cts_pin = ESP01_UART_CTS_PIN,
+        .uart_rts_pin = ESP01_UART_RTS_PIN,
+        .rst_pin = ESP01_RST_PIN,
+        .ssid = WIFI_SSID,
+        .password = WIFI_PASSWORD,
+        .wifi_connected = false,
+        .fast_rejoin = WIFI_FAST_REJOIN,
+        .join_cache = {},
+        .join_stats = {},
+        .join_start_ms = 0,
+        .ready = false,
+        .rebooted = false,
+        .reset_ms = 0,
+        .ready_ms = 0};
 
-    sleep_ms(2000);
+    // AT 엔진을 링크에 연결 (esp01/mqtt 함수가 link.at으로 사용)
+    at_engine_init(esp_at, esp_link);
 
     // 고유한 MQTT Client ID 생성
     char mqtt_client_id[64];
@@ -160,7 +482,9 @@ int main(void)
     printf("생성된 Client ID: %s\n", mqtt_client_id);
 
     // MQTT 클라이언트 설정
-    MqttClient mqtt = {
+    // 발신 큐/발행 통계 크기 때문에 스택이 아닌 정적 저장소에 둠
+    static MqttClient mqtt = {
+        .link = &esp_link,
         .broker = MQTT_BROKER,
         .port = MQTT_PORT,
         .client_id = mqtt_client_id, // 동적 생성된 고유 ID
@@ -169,68 +493,110 @@ int main(void)
         .lwt_topic = LWT_TOPIC,
         .lwt_message = LWT_MESSAGE,
         .connected = false,
-        .last_activity = 0};
+        .last_activity = 0,
+        .pub_stats = {},
+        .pub_prefix = {},
+        .outbox = {},
+        .store = NULL,
+        .qos1 = {},
+        .native = {}};
+
+    // 구독 토픽 등록 (센서 8개 + 보정값 8개 → 필터로 묶어 구독)
+    mqtt_subs_init(display_subs, MQTT_SUBS_COLLAPSE);
+    for (uint32_t i = 0; i < display_topics.size(); i++)
+    {
+        mqtt_subs_add(display_subs, display_topics[i].topic, 0);
+    }
+
+    // 부팅 단계 등록 (의존 단계가 끝난 단계는 동시에 진행)
+    // disp_init → disp_test ─────────────────────────────┐
+    // esp_boot → at_init → wifi → mqtt → restore ────────┴→ first_data
+    DisplayBoot boot = {};
+    boot.esp01 = &esp01;
+    boot.mqtt = &mqtt;
+    boot.at = &esp_at;
+
+    static BootSeq boot_seq;
+    boot_seq_init(boot_seq);
+    int st_display = boot_seq_add(boot_seq, "disp_init", boot_display_init, NULL, &boot, 0);
+    int st_test = boot_seq_add(boot_seq, "disp_test", boot_display_test_start, boot_display_test_poll, &boot,
+                               BOOT_DEP(st_display));
+    int st_esp = boot_seq_add(boot_seq, "esp_boot", boot_esp_start, boot_esp_poll, &boot, 0);
+    int st_at = boot_seq_add(boot_seq, "at_init", boot_at_start, boot_at_poll, &boot, BOOT_DEP(st_esp));
+    int st_wifi = boot_seq_add(boot_seq, "wifi", boot_wifi_start, boot_wifi_poll, &boot, BOOT_DEP(st_at));
+    int st_mqtt = boot_seq_add(boot_seq, "mqtt", boot_mqtt_start, boot_mqtt_poll, &boot, BOOT_DEP(st_wifi));
+    int st_restore = boot_seq_add(boot_seq, "restore", boot_restore_start, boot_restore_poll, &boot,
+                                  BOOT_DEP(st_mqtt));
+    boot_seq_add(boot_seq, "first_data", boot_first_data_start, boot_first_data_poll, &boot,
+                 BOOT_DEP(st_test) | BOOT_DEP(st_restore));
+
+    // 모든 단계가 끝날 때까지 진행 (자가 테스트 표시 중에도 모듈 부팅/WiFi 접속 응답 처리)
+    while (true)
+    {
+        at_engine_poll(esp_at);
+        process_received_messages(mqtt);
+        if (boot_seq_poll(boot_seq, to_ms_since_boot(get_absolute_time())))
+        {
+            break;
+        }
+        uart_wait_event(make_timeout_time_ms(10));
+    }
+    boot_seq_report(boot_seq);
 
-    // MQTT 브로커 연결
-    if (!mqtt_connect(mqtt))
+    if (boot_seq_state(boot_seq, st_display) != BOOT_STAGE_DONE)
     {
-        printf("[오류] MQTT 연결 실패\n");
+        printf("[오류] 디스플레이 초기화 실패\n");
         cleanup_resources();
         return -1;
     }
 
-    // MQTT 초기화 (구독 + 상태 발행)
-    if (!mqtt_reinitialize_after_reconnect(mqtt))
+    if (boot_seq_state(boot_seq, st_at) != BOOT_STAGE_DONE)
     {
-        printf("[경고] MQTT 초기화 실패\n");
+        printf("[오류] ESP-01 AT 초기화 실패\n");
+        printf("시리얼 브리지 모드로 전환합니다...\n");
+        cleanup_resources();
+        uart_deinit_esp01(esp_link);  // DMA/인터럽트 수신 정지 후 브릿지가 UART 직접 사용
+        serial_bridge_mode(uart1);
+        return -1;
+    }
+
+    // WiFi/브로커 연결이 부팅 중 실패했으면 감독자가 첫 poll에서 끊김으로 보고 단계별 복구
+    if (!mqtt_is_connected(mqtt))
+    {
+        printf("[경고] 부팅 중 브로커 연결 실패 - 메인 루프에서 복구\n");
+    }
+
+    // 여기서부터 끊김은 감독자가 메인 루프를 멈추지 않고 복구 (연결 확인은 더 짧은 간격)
+    net_supervisor_init(net_sup, esp01, mqtt, &net_restore);
+    net_sup.check_interval_ms = CONNECTION_CHECK_MS;
+
+    // 부팅 단계별 시간 발행 (연결 전이면 발신 큐에 보관 후 전송)
+    char boot_stats[MQTT_OUTBOX_MSG_MAX + 1];
+    if (boot_seq_format_stats(boot_seq, boot_stats, sizeof(boot_stats)) > 0)
+    {
+        mqtt_enqueue(mqtt, TOPIC_BOOT_STATS, boot_stats, 0, 1, true);
     }
 
     printf("\n=== 메인 루프 시작 ===\n");
 
-    uint32_t last_connection_check = 0;
     uint32_t last_display_update = 0;
+    uint32_t last_stats_publish = 0;
 
     while (true)
     {
         uint32_t now = to_ms_since_boot(get_absolute_time());
 
-        // 연결 상태 확인 (CONNECTION_CHECK_MS마다 - 더 빠른 재연결)
-        if (now - last_connection_check > CONNECTION_CHECK_MS)
-        {
-            mqtt_keepalive(mqtt);
+        // AT 명령 진행 + URC 분배 (차단 없음)
+        at_engine_poll(esp_at);
 
-            if (!mqtt_is_connected(mqtt))
-            {
-                printf("[경고] MQTT 연결 끊김 감지 (타임스탬프: %lu)\n", now);
+        // 발신 큐 배출 (연결된 동안, 재연결 후 밀린 값부터)
+        mqtt_outbox_poll(mqtt);
 
-                if (!esp01_is_connected(esp01))
-                {
-                    printf("[경고] WiFi 연결 끊김 감지\n");
-                    if (esp01_reconnect_wifi(esp01))
-                    {
-                        if (mqtt_reconnect(mqtt))
-                        {
-                            mqtt_reinitialize_after_reconnect(mqtt);
-                        }
-                    }
-                }
-                else
-                {
-                    if (mqtt_reconnect(mqtt))
-                    {
-                        mqtt_reinitialize_after_reconnect(mqtt);
-                    }
-                }
-            }
-            last_connection_check = now;
-        }
+        // 연결 상태 확인 (CONNECTION_CHECK_MS마다 - 더 빠른 재연결) 및 끊김 시 단계별 복구
+        net_supervisor_poll(net_sup, now);
 
-        // MQTT 메시지 수신 확인
-        char topic[MQTT_TOPIC_MAX_LEN], message[MQTT_MESSAGE_MAX_LEN];
-        if (mqtt_check_message(mqtt, topic, sizeof(topic), message, sizeof(message)))
-        {
-            process_mqtt_message(topic, message);
-        }
+        // MQTT 메시지 수신 확인 (URC 큐 안의 메시지를 복사 없이 처리)
+        process_received_messages(mqtt);
 
         // 모든 디스플레이 업데이트 (DISPLAY_UPDATE_MS마다)
         if (now - last_display_update > DISPLAY_UPDATE_MS)
@@ -239,7 +605,23 @@ int main(void)
             last_display_update = now;
         }
 
-        sleep_ms(50);
+        // UART 링크 통계 발행 (UART_STATS_PUBLISH_MS마다)
+        if (now - last_stats_publish > UART_STATS_PUBLISH_MS)
+        {
+            char stats[384];
+            if (uart_format_link_stats(esp_link, stats, sizeof(stats)) > 0)
+            {
+                mqtt_enqueue(mqtt, TOPIC_UART_STATS, stats, 0, 0, true);
+            }
+            if (net_supervisor_format_stats(net_sup, now, stats, sizeof(stats)) > 0)
+            {
+                mqtt_enqueue(mqtt, TOPIC_NET_STATS, stats, 0, 0, true);
+            }
+            last_stats_publish = now;
+        }
+
+        // 다음 UART 이벤트까지 수면 (응답이 오면 바로 깨어나 AT 엔진 진행)
+        uart_wait_event(make_timeout_time_ms(50));
     }
 
     // 도달하지 않지만, 종료 시 정리 코드